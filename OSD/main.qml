@@ -12,6 +12,8 @@ Window {
     property string mode: osdMode
     property int value: osdValue
     property bool muted: osdMuted
+    // Always-mapped mode keeps the window up and only hides what is drawn
+    property bool shown: true
 
     width: 1900
     height: 1240
@@ -19,6 +21,7 @@ Window {
     flags: Qt.FramelessWindowHint | Qt.WindowStaysOnTopHint | Qt.Tool
 
     Rectangle {
+        visible: root.shown
         anchors.centerIn: parent
         width: AppModel.HexWidth
         height: AppModel.HexHeight
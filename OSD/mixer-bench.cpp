@@ -0,0 +1,94 @@
+// mixer-bench: what one volume key press costs before the OSD can be told.
+//
+//   amixer        the old osd-client sequence: read mute, change, read volume
+//                 and mute back, each an amixer process with its output parsed
+//   open+adjust   osd-client now: open the mixer backend, one adjust()
+//   adjust        one adjust() on a mixer that is already open
+//
+// Every step is undone by the next one, so the volume ends where it started
+// (steps go down first above 50%, so neither end clips them). Pick
+// the backend with HEX_MIXER (alsa, pulse, fake); fake skips the amixer run.
+//
+//   mixer-bench [iterations]
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QProcess>
+#include <QRegularExpression>
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+#include "mixer.h"
+
+static QString amixer(const QStringList& arguments)
+{
+    QProcess process;
+    process.start("amixer", arguments);
+    process.waitForFinished();
+    return QString::fromUtf8(process.readAllStandardOutput());
+}
+
+static void amixerKeyPress(const QString& change)
+{
+    static const QRegularExpression volume(R"(\[(\d+)%\])");
+    const bool wasMuted = amixer({ "get", "Master" }).contains("[off]");
+    if (wasMuted)
+        amixer({ "sset", "Master", "toggle" });
+    amixer({ "sset", "Master", change });
+    volume.match(amixer({ "get", "Master" }));
+    amixer({ "get", "Master" }).contains("[off]");
+}
+
+static void report(const char* name, std::vector<qint64>& samples)
+{
+    if (samples.empty())
+        return;
+    std::sort(samples.begin(), samples.end());
+    const auto at = [&](double q) { return samples[std::min(samples.size() - 1, size_t(q * samples.size()))] / 1000.0; };
+    std::printf("%-12s p50 %9.1f us   p99 %9.1f us   (%zu runs)\n", name, at(0.50), at(0.99), samples.size());
+}
+
+static std::vector<qint64> measure(int iterations, bool downFirst, const std::function<void(bool up)>& press)
+{
+    std::vector<qint64> samples;
+    QElapsedTimer timer;
+    for (int i = 0; i < iterations; ++i) {
+        timer.start();
+        press((i % 2 == 0) != downFirst);
+        samples.push_back(timer.nsecsElapsed());
+    }
+    return samples;
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    const int iterations = argc > 1 ? std::max(2, atoi(argv[1])) & ~1 : 200;
+
+    Mixer* mixer = Mixer::create(&app);
+    if (!mixer->state().isValid()) {
+        std::fprintf(stderr, "no usable %s mixer control\n", qPrintable(mixer->name()));
+        return 1;
+    }
+    std::printf("backend %s, volume %d%%\n", qPrintable(mixer->name()), mixer->state().percent);
+    const bool downFirst = mixer->state().percent > 50;
+
+    if (mixer->name() == "alsa") {
+        std::vector<qint64> samples = measure(iterations, downFirst, [](bool up) { amixerKeyPress(up ? "5%+" : "5%-"); });
+        report("amixer", samples);
+    }
+
+    std::vector<qint64> fresh = measure(iterations, downFirst, [](bool up) {
+        Mixer* m = Mixer::create();
+        m->adjust(up ? 5 : -5);
+        delete m;
+    });
+    report("open+adjust", fresh);
+
+    std::vector<qint64> open = measure(iterations, downFirst, [mixer](bool up) { mixer->adjust(up ? 5 : -5); });
+    report("adjust", open);
+
+    return 0;
+}
@@ -0,0 +1,359 @@
+// osd-bench: key press to presented OSD frame, stage by stage.
+//
+//   osd-bench [--iterations N] [--via client|socket|both] [--kind volume|brightness]
+//             [--gap ms] [--always-mapped] [--platform offscreen|wayland]
+//
+// Starts its own osd-server on a private socket (HEX_OSD_SOCKET), with the
+// fake mixer (HEX_MIXER=fake) and a throwaway sysfs tree holding one
+// backlight (HEX_SYSFS_ROOT), so no hardware is touched and a running OSD is
+// left alone. Its apps.ini is a copy of yours under a throwaway
+// XDG_CONFIG_HOME, with [OSD] AlwaysMapped set from --always-mapped. The
+// default platform is offscreen with the software Qt Quick renderer; for a
+// headless compositor start e.g. `weston --backend=headless` and pass
+// --platform wayland with WAYLAND_DISPLAY set.
+//
+// Then presses the key N times, one press at a time, either by running
+// osd-client (--volup/--voldown, or --dispup/--dispdown) or by writing the
+// Adjust frame from here. With HEX_OSD_TRACE set both processes print stage
+// timestamps (osdTrace), which are matched up per press:
+//
+//   launch    osd-bench starts the client process, or connects
+//   start     osd-client enters main()
+//   sent      the Adjust frame is written
+//   received  osd-server has read it
+//   set       the QML properties hold the new value
+//   swapped   the frame showing it is presented (frameSwapped)
+//
+// Presses alternate up and down so the level never clamps. The window stays
+// up between presses unless --gap is longer than its 1.5 s hide delay, so
+// --gap 2000 measures showing the OSD from idle: with and without
+// --always-mapped, that is the cost of mapping a new surface per show.
+// Offscreen has no compositor to map anything, so that comparison only
+// means something with --platform wayland:
+//
+//   osd-bench --platform wayland --gap 2000 --iterations 30
+//   osd-bench --platform wayland --gap 2000 --iterations 30 --always-mapped
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QLocalSocket>
+#include <QProcess>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QTimer>
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+#include "osdprotocol.h"
+
+namespace {
+
+enum Stage { Launch, Start, Sent, Received, Set, Swapped, StageCount };
+const char* const stageNames[StageCount] = { "launch", "start", "sent", "received", "set", "swapped" };
+
+struct Press {
+    qint64 at[StageCount] = { -1, -1, -1, -1, -1, -1 };
+};
+
+double percentile(std::vector<qint64> samples, double q)
+{
+    if (samples.empty())
+        return 0.0;
+    std::sort(samples.begin(), samples.end());
+    return samples[std::min(samples.size() - 1, size_t(q * samples.size()))] / 1e6;
+}
+
+// Takes the trace lines out of `output` that belong to `press`: each stage
+// counts once, and only after the stage before it. A line still being
+// written is left for the next call.
+void collect(const QByteArray& output, Press& press)
+{
+    for (const QByteArray& line : output.left(output.lastIndexOf('\n')).split('\n')) {
+        const QList<QByteArray> fields = line.trimmed().split(' ');
+        if (fields.size() != 3 || fields[0] != "trace")
+            continue;
+        for (int stage = Start; stage < StageCount; ++stage) {
+            if (fields[1] != stageNames[stage] || press.at[stage] >= 0)
+                continue;
+            const qint64 at = fields[2].toLongLong();
+            qint64 previous = -1;
+            for (int before = stage - 1; before >= Launch && previous < 0; --before)
+                previous = press.at[before];
+            if (at >= previous)
+                press.at[stage] = at;
+        }
+    }
+}
+
+class Bench
+{
+public:
+    Bench(QCoreApplication& app, const QCommandLineParser& options)
+        : m_app(app)
+        , m_iterations(std::max(1, options.value("iterations").toInt()))
+        , m_gapMs(std::max(0, options.value("gap").toInt()))
+        , m_brightness(options.value("kind") == "brightness")
+        , m_alwaysMapped(options.isSet("always-mapped"))
+    {
+        const QString via = options.value("via");
+        if (via == "client" || via == "both")
+            m_rounds.push_back(true);
+        if (via == "socket" || via == "both")
+            m_rounds.push_back(false);
+
+        m_press.setSingleShot(true);
+        QObject::connect(&m_press, &QTimer::timeout, &m_app, [this]() { press(); });
+        m_timeout.setSingleShot(true);
+        m_timeout.setInterval(2000);
+        QObject::connect(&m_timeout, &QTimer::timeout, &m_app, [this]() {
+            ++m_failed;
+            next();
+        });
+    }
+
+    bool startServer(const QString& platform)
+    {
+        // One backlight at 50% for the server to drive
+        const QString light = m_sysfs.path() + "/class/backlight/bench";
+        if (!QDir().mkpath(light) || !write(light + "/max_brightness", "100") || !write(light + "/brightness", "50"))
+            return false;
+
+        // The user's look, with the mapping mode under test
+        const QString configDir = m_sysfs.path() + "/config/hexlauncher";
+        const QString userConfig = QDir(QStandardPaths::writableLocation(QStandardPaths::ConfigLocation)).filePath("hexlauncher/apps.ini");
+        if (!QDir().mkpath(configDir))
+            return false;
+        QFile::copy(userConfig, configDir + "/apps.ini");
+        {
+            QSettings settings(configDir + "/apps.ini", QSettings::IniFormat);
+            settings.setValue("OSD/AlwaysMapped", m_alwaysMapped);
+        }
+
+        QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+        env.insert("HEX_OSD_SOCKET", m_socketName);
+        env.insert("HEX_OSD_TRACE", "1");
+        env.insert("HEX_MIXER", "fake");
+        env.insert("HEX_SYSFS_ROOT", m_sysfs.path());
+        env.insert("XDG_CONFIG_HOME", m_sysfs.path() + "/config");
+        env.insert("QT_QPA_PLATFORM", platform);
+        if (platform == "offscreen")
+            env.insert("QT_QUICK_BACKEND", "software");
+        m_env = env;
+
+        m_server.setProcessEnvironment(env);
+        m_server.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+        QObject::connect(&m_server, &QProcess::readyReadStandardOutput, &m_app, [this]() {
+            m_serverOutput += m_server.readAllStandardOutput();
+            settle();
+        });
+        m_server.start(binary("osd-server"), {});
+        if (!m_server.waitForStarted(5000))
+            return false;
+
+        // Ready once the socket takes connections
+        for (int tries = 0; tries < 100; ++tries) {
+            QLocalSocket probe;
+            probe.connectToServer(m_socketName);
+            if (probe.waitForConnected(100))
+                return true;
+            if (m_server.state() != QProcess::Running)
+                return false;
+            QThread::msleep(50);
+        }
+        return false;
+    }
+
+    void run()
+    {
+        m_round = 0;
+        m_done = -warmup;
+        QTimer::singleShot(0, &m_app, [this]() { press(); });
+        m_app.exec();
+
+        m_server.terminate();
+        if (!m_server.waitForFinished(2000))
+            m_server.kill();
+    }
+
+    int report() const
+    {
+        for (size_t round = 0; round < m_rounds.size(); ++round) {
+            const std::vector<Press>& presses = m_results[round];
+            std::printf("%s, %zu presses, %s, %s:\n", m_rounds[round] ? "via osd-client" : "via socket", presses.size(),
+                m_brightness ? "brightness" : "volume", m_alwaysMapped ? "always mapped" : "hidden when idle");
+            std::printf("  %-20s %9s %9s %9s\n", "stage", "p50 ms", "p99 ms", "max ms");
+
+            for (int stage = Start; stage < StageCount; ++stage) {
+                if (stage == Start && !m_rounds[round])
+                    continue;
+                std::vector<qint64> step, total;
+                for (const Press& press : presses) {
+                    int before = stage - 1;
+                    while (press.at[before] < 0)
+                        --before;
+                    step.push_back(press.at[stage] - press.at[before]);
+                    total.push_back(press.at[stage] - press.at[Launch]);
+                }
+                const QByteArray label = QByteArray("-> ") + stageNames[stage];
+                std::printf("  %-20s %9.3f %9.3f %9.3f\n", label.constData(), percentile(step, 0.50),
+                    percentile(step, 0.99), percentile(step, 1.0));
+                if (stage == Swapped) {
+                    std::printf("  %-20s %9.3f %9.3f %9.3f\n", "launch -> swapped", percentile(total, 0.50),
+                        percentile(total, 0.99), percentile(total, 1.0));
+                }
+            }
+        }
+        if (m_failed > 0)
+            std::printf("%d presses never reached the screen\n", m_failed);
+        return m_failed == 0 ? 0 : 1;
+    }
+
+private:
+    static constexpr int warmup = 20;
+
+    static bool write(const QString& path, const QByteArray& value)
+    {
+        QFile file(path);
+        return file.open(QIODevice::WriteOnly) && file.write(value) == value.size();
+    }
+
+    static QString binary(const QString& name)
+    {
+        return QDir(QCoreApplication::applicationDirPath()).filePath(name);
+    }
+
+    void press()
+    {
+        m_current = Press();
+        m_serverOutput.clear();
+        m_clientDone = false;
+        m_timeout.start();
+
+        const bool up = (m_done & 1) == 0;
+        m_current.at[Launch] = osdTraceNow();
+        if (m_rounds[m_round])
+            pressWithClient(up);
+        else
+            pressWithSocket(up);
+    }
+
+    void pressWithClient(bool up)
+    {
+        auto* client = new QProcess(&m_app);
+        client->setProcessEnvironment(m_env);
+        QObject::connect(client, &QProcess::finished, &m_app, [this, client]() {
+            collect(client->readAllStandardOutput(), m_current);
+            client->deleteLater();
+            m_clientDone = true;
+            settle();
+        });
+        const char* option = m_brightness ? (up ? "--dispup" : "--dispdown") : (up ? "--volup" : "--voldown");
+        client->start(binary("osd-client"), { option });
+    }
+
+    void pressWithSocket(bool up)
+    {
+        auto* socket = new QLocalSocket(&m_app);
+        QObject::connect(socket, &QLocalSocket::connected, socket, [this, socket, up]() {
+            OsdMessage adjust;
+            adjust.type = OsdMessage::Adjust;
+            adjust.kind = m_brightness ? OsdMessage::Brightness : OsdMessage::Volume;
+            adjust.delta = up ? 5 : -5;
+            socket->write(encodeOsdFrame(adjust));
+        });
+        QObject::connect(socket, &QLocalSocket::bytesWritten, socket, [this, socket]() {
+            m_current.at[Sent] = osdTraceNow();
+            socket->disconnectFromServer();
+            socket->deleteLater();
+            m_clientDone = true;
+            settle();
+        });
+        socket->connectToServer(m_socketName);
+    }
+
+    // Done with this press once the client has finished and the frame is out
+    void settle()
+    {
+        if (!m_timeout.isActive())
+            return;
+        collect(m_serverOutput, m_current);
+        if (!m_clientDone)
+            return;
+        for (int stage = m_rounds[m_round] ? Start : Sent; stage < StageCount; ++stage) {
+            if (m_current.at[stage] < 0)
+                return;
+        }
+
+        if (m_done >= 0)
+            m_results[m_round].push_back(m_current);
+        next();
+    }
+
+    void next()
+    {
+        m_timeout.stop();
+        if (++m_done == m_iterations) {
+            m_done = -warmup;
+            if (++m_round == int(m_rounds.size())) {
+                m_app.quit();
+                return;
+            }
+        }
+        m_press.start(m_gapMs);
+    }
+
+    QCoreApplication& m_app;
+    const int m_iterations;
+    const int m_gapMs;
+    const bool m_brightness;
+    const bool m_alwaysMapped;
+    std::vector<bool> m_rounds; // true: through osd-client
+    std::vector<Press> m_results[2];
+
+    const QString m_socketName = QString("osd-bench-%1").arg(QCoreApplication::applicationPid());
+    QTemporaryDir m_sysfs;
+    QProcessEnvironment m_env;
+    QProcess m_server;
+    QByteArray m_serverOutput;
+
+    QTimer m_press;
+    QTimer m_timeout;
+    Press m_current;
+    bool m_clientDone = false;
+    int m_round = 0;
+    int m_done = 0; // presses in this round; negative while warming up
+    int m_failed = 0;
+};
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.addOption({ "iterations", "Presses per round", "n", "2000" });
+    parser.addOption({ "via", "client, socket or both", "how", "both" });
+    parser.addOption({ "kind", "volume or brightness", "kind", "volume" });
+    parser.addOption({ "gap", "Pause between presses", "ms", "0" });
+    parser.addOption({ "always-mapped", "Keep the OSD surface mapped while idle" });
+    parser.addOption({ "platform", "QPA platform for osd-server", "name", "offscreen" });
+    parser.process(app);
+
+    const QString via = parser.value("via");
+    if (via != "client" && via != "socket" && via != "both")
+        parser.showHelp(1);
+
+    Bench bench(app, parser);
+    if (!bench.startServer(parser.value("platform"))) {
+        std::fprintf(stderr, "osd-server did not come up\n");
+        return 1;
+    }
+    bench.run();
+    return bench.report();
+}
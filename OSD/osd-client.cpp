@@ -1,81 +1,91 @@
 #include <QCommandLineParser>
 #include <QCoreApplication>
 #include <QLocalSocket>
-#include <QProcess>
-#include <QRegularExpression>
-#include <algorithm>
-
-const QString socketName = "osd_instance_socket"; // ✅ No full path
-
-void adjustVolumeAlsa(int deltaPercent)
-{
-    QString change = QString::number(std::abs(deltaPercent)) + "%";
-    change += (deltaPercent > 0 ? "+" : "-");
-    QProcess::execute("amixer", { "sset", "Master", change });
-}
-
-int getCurrentVolumeAlsa()
-{
-    QProcess proc;
-    proc.start("amixer", { "sget", "Master" });
-    proc.waitForFinished();
-    QString output = proc.readAllStandardOutput();
-    QRegularExpression re(R"(\[(\d+)%\])");
-    QRegularExpressionMatch match = re.match(output);
-    return match.hasMatch() ? match.captured(1).toInt() : 50;
-}
-
-bool getMuteStatusAlsa()
+#include <QTimer>
+#include <functional>
+#include <memory>
+
+#include "asyncprocess.h"
+#include "backlight.h"
+#include "mixer.h"
+#include "osdprotocol.h"
+
+// osd-server owns the mixer and the backlights: the client only tells it
+// which way to go and leaves, so a held key never waits on the hardware.
+// Without a server the change is made here instead, in-process (mixer.h,
+// backlight.h), with amixer through runProcess() when no mixer control
+// could be opened.
+static const ProcessOptions toolOptions = { 2000, 64 * 1024 };
+
+// deltaPercent 0 toggles mute
+void changeVolumeLocally(int deltaPercent)
 {
-    QProcess proc;
-    proc.start("amixer", { "get", "Master" });
-    proc.waitForFinished();
-    return proc.readAllStandardOutput().contains("[off]");
-}
+    Mixer* mixer = Mixer::create(qApp);
+    const MixerState state = deltaPercent == 0 ? mixer->toggleMute() : mixer->adjust(deltaPercent);
+    if (state.isValid()) {
+        QCoreApplication::quit();
+        return;
+    }
 
-void toggleMute()
-{
-    QProcess::execute("amixer", { "sset", "Master", "toggle" });
+    const QString step = QString::number(qAbs(deltaPercent)) + (deltaPercent > 0 ? "%+" : "%-");
+    const QStringList change = deltaPercent == 0 ? QStringList { "toggle" } : QStringList { step, "unmute" };
+    runProcess("amixer", QStringList { "sset", "Master" } + change, toolOptions)
+        .then(qApp, [](const ProcessResult& result) { QCoreApplication::exit(result.ok() ? 0 : 1); });
 }
 
-void adjustBrightness(int deltaPercent)
+// See backlight.h for how the device is picked and written
+void changeBrightnessLocally(int deltaPercent, const QString& output)
 {
-    QProcess getProc, maxProc;
-    getProc.start("brightnessctl", { "get" });
-    getProc.waitForFinished();
-    int current = getProc.readAllStandardOutput().trimmed().toInt();
-
-    maxProc.start("brightnessctl", { "max" });
-    maxProc.waitForFinished();
-    int max = maxProc.readAllStandardOutput().trimmed().toInt();
-
-    if (current <= 0 || max <= 0)
+    Backlight backlight = Backlight::forOutput(output);
+    if (backlight.brightness() < 0) {
+        qWarning("No usable backlight.");
+        QCoreApplication::exit(1);
         return;
+    }
 
-    int currentPercent = static_cast<int>((100.0 * current) / max);
-    int newPercent = std::clamp(currentPercent + deltaPercent, 1, 100);
-    QString value = QString::number(newPercent) + "%";
-    QProcess::execute("brightnessctl", { "set", value });
+    QCoreApplication::exit(backlight.adjust(deltaPercent) < 0 ? 1 : 0);
 }
 
-int getCurrentBrightness()
+// Quits once the message is written; runs `fallback` instead when no server
+// takes the connection within 100 ms
+void sendToOsd(const OsdMessage& message, const std::function<void()>& fallback)
 {
-    QProcess getProc, maxProc;
-    getProc.start("brightnessctl", { "get" });
-    getProc.waitForFinished();
-    int current = getProc.readAllStandardOutput().trimmed().toInt();
-
-    maxProc.start("brightnessctl", { "max" });
-    maxProc.waitForFinished();
-    int max = maxProc.readAllStandardOutput().trimmed().toInt();
-
-    if (current > 0 && max > 0)
-        return static_cast<int>((100.0 * current) / max);
-    return 50;
+    auto* socket = new QLocalSocket(qApp);
+    const QByteArray payload = encodeOsdFrame(message);
+    auto settled = std::make_shared<bool>(false);
+
+    auto noServer = [socket, settled, fallback]() {
+        if (*settled)
+            return;
+        *settled = true;
+        socket->abort();
+        qWarning("OSD server is not running.");
+        fallback();
+    };
+
+    QObject::connect(socket, &QLocalSocket::connected, socket, [socket, payload]() {
+        socket->write(payload);
+    });
+    QObject::connect(socket, &QLocalSocket::bytesWritten, qApp, [settled]() {
+        osdTrace("sent");
+        *settled = true;
+        QCoreApplication::quit();
+    });
+    // May fire inside connectToServer(), before the event loop runs
+    QObject::connect(socket, &QLocalSocket::errorOccurred, qApp, [noServer]() {
+        QTimer::singleShot(0, qApp, noServer);
+    });
+    socket->connectToServer(osdSocketName());
+
+    QTimer::singleShot(100, qApp, [socket, noServer]() {
+        if (socket->state() != QLocalSocket::ConnectedState)
+            noServer();
+    });
 }
 
 int main(int argc, char* argv[])
 {
+    osdTrace("start");
     QCoreApplication app(argc, argv);
     QCommandLineParser parser;
     parser.addHelpOption();
@@ -84,58 +94,29 @@ int main(int argc, char* argv[])
     parser.addOption({ "dispup", "Increase brightness" });
     parser.addOption({ "dispdown", "Decrease brightness" });
     parser.addOption({ "mute", "Toggle mute" });
+    parser.addOption({ "output", "Backlight of this output (e.g. eDP-1)", "name" });
     parser.process(app);
 
-    QString mode;
-    int value = 50;
-    bool isMuted = getMuteStatusAlsa();
-
+    OsdMessage message;
+    message.type = OsdMessage::Adjust;
     if (parser.isSet("mute")) {
-        toggleMute();
-        isMuted = getMuteStatusAlsa();
-        if (isMuted) {
-            mode = "mute";
-            value = 0;
-        } else {
-            mode = "volume";
-            value = getCurrentVolumeAlsa();
-        }
-    } else if (parser.isSet("volup")) {
-        if (isMuted)
-            toggleMute();
-        adjustVolumeAlsa(5);
-        mode = "volume";
-        value = getCurrentVolumeAlsa();
-        isMuted = getMuteStatusAlsa();
-    } else if (parser.isSet("voldown")) {
-        if (isMuted)
-            toggleMute();
-        adjustVolumeAlsa(-5);
-        mode = "volume";
-        value = getCurrentVolumeAlsa();
-        isMuted = getMuteStatusAlsa();
-    } else if (parser.isSet("dispup")) {
-        mode = "brightness";
-        adjustBrightness(5);
-        value = getCurrentBrightness();
-    } else if (parser.isSet("dispdown")) {
-        mode = "brightness";
-        adjustBrightness(-5);
-        value = getCurrentBrightness();
+        message.type = OsdMessage::ToggleMute;
+    } else if (parser.isSet("volup") || parser.isSet("voldown")) {
+        message.kind = OsdMessage::Volume;
+        message.delta = parser.isSet("volup") ? 5 : -5;
+    } else if (parser.isSet("dispup") || parser.isSet("dispdown")) {
+        message.kind = OsdMessage::Brightness;
+        message.delta = parser.isSet("dispup") ? 5 : -5;
+        message.output = parser.value("output");
     } else {
         return 0;
     }
 
-    QLocalSocket socket;
-    socket.connectToServer(socketName);
-    if (socket.waitForConnected(100)) {
-        QString msg = mode + " " + QString::number(value) + " " + (isMuted ? "1" : "0");
-        socket.write(msg.toUtf8());
-        socket.flush();
-        socket.waitForBytesWritten();
-    } else {
-        qWarning("OSD server is not running.");
-    }
-
-    return 0;
+    sendToOsd(message, [message]() {
+        if (message.kind == OsdMessage::Brightness)
+            changeBrightnessLocally(message.delta, message.output);
+        else
+            changeVolumeLocally(message.type == OsdMessage::ToggleMute ? 0 : message.delta);
+    });
+    return app.exec();
 }
@@ -4,17 +4,331 @@
 #include <QLocalSocket>
 #include <QQmlApplicationEngine>
 #include <QQmlContext>
+#include <QQuickWindow>
 #include <QScreen>
 #include <QTimer>
 #include <QWindow>
 #include <QSettings>
 #include <QStandardPaths>
 #include <QDir>
+#include <QHash>
+#include <QPointer>
+#include <algorithm>
+#include <optional>
+#include <utility>
 
 // 🧩 LayerShellQt
 #include <LayerShellQt/window.h>
 
-const QString socketName = "osd_instance_socket";
+#include "backlight.h"
+#include "mixer.h"
+#include "osdprotocol.h"
+
+// ----------------- OsdServer -----------------
+// Serves any number of clients at once without ever waiting on one: frames
+// are taken off each socket as readyRead delivers them (osdprotocol.h).
+//
+// The server owns the mixer and the backlights. Clients only say which way
+// to go (Adjust, ToggleMute) and leave; the steps pile up here and reach the
+// hardware at most once per frame, so a held key costs one mixer or sysfs
+// write per frame however fast it repeats, and no step is dropped. What is
+// shown comes from the state the server just set, not from the client.
+//
+// By default the window is hidden when idle, which on layer-shell destroys
+// the surface: the next show has to wait for a new surface to be configured
+// before its first frame. With AlwaysMapped=true under [OSD] in apps.ini the
+// surface stays mapped, passes all input through, and draws nothing while
+// idle, so showing the OSD is one more frame on an existing surface.
+// Whether that shows up any sooner on a real compositor has not been
+// measured yet, so it stays off by default. `osd-bench --platform wayland
+// --gap 2000` measures the show latency of the default mode, and with
+// --always-mapped of this one.
+class OsdServer : public QObject {
+    Q_OBJECT
+
+public:
+    OsdServer(QQuickWindow* window, bool alwaysMapped, QObject* parent = nullptr)
+        : QObject(parent)
+        , m_window(window)
+        , m_mixer(Mixer::create(this))
+        , m_alwaysMapped(alwaysMapped)
+    {
+        qDebug() << "[INFO] OSD mixer backend:" << m_mixer->name();
+
+        // Hundreds of clients may connect in the same instant
+        m_server.setMaxPendingConnections(256);
+        m_server.setListenBacklogSize(256);
+        connect(&m_server, &QLocalServer::newConnection, this, &OsdServer::accept);
+
+        // Auto-hide after 1.5 seconds
+        m_hideTimer.setInterval(1500);
+        m_hideTimer.setSingleShot(true);
+        connect(&m_hideTimer, &QTimer::timeout, this, &OsdServer::hide);
+        // Something else may move the backlight while we are hidden
+        connect(&m_hideTimer, &QTimer::timeout, this, [this]() { m_levels.clear(); });
+
+        m_applyTimer.setSingleShot(true);
+        connect(&m_applyTimer, &QTimer::timeout, this, &OsdServer::apply);
+
+        // The next state goes out once the last one is on screen; the
+        // fallback covers frames that never come (window not exposed yet)
+        connect(m_window, &QQuickWindow::frameSwapped, this, &OsdServer::frameDone);
+        connect(m_window, &QQuickWindow::frameSwapped, this, []() { osdTrace("swapped"); }, Qt::DirectConnection);
+        m_frameFallback.setInterval(100);
+        m_frameFallback.setSingleShot(true);
+        connect(&m_frameFallback, &QTimer::timeout, this, &OsdServer::frameDone);
+
+        if (m_alwaysMapped) {
+            // Empty input region: clicks go to whatever is underneath
+            m_window->setFlag(Qt::WindowTransparentForInput);
+            m_window->setProperty("shown", false);
+            m_window->show();
+            center();
+        }
+    }
+
+    bool listen()
+    {
+        QLocalServer::removeServer(osdSocketName());
+        if (!m_server.listen(osdSocketName())) {
+            qCritical() << "Failed to start socket server on" << osdSocketName();
+            return false;
+        }
+        return true;
+    }
+
+private:
+    void accept()
+    {
+        while (QLocalSocket* client = m_server.nextPendingConnection()) {
+            connect(client, &QLocalSocket::readyRead, this, [this, client]() { read(client); });
+            connect(client, &QLocalSocket::disconnected, client, &QObject::deleteLater);
+
+            // A client that goes quiet for two seconds is let go
+            auto* idle = new QTimer(client);
+            idle->setSingleShot(true);
+            connect(idle, &QTimer::timeout, client, &QLocalSocket::disconnectFromServer);
+            idle->start(2000);
+
+            if (client->bytesAvailable() > 0)
+                read(client);
+        }
+    }
+
+    void read(QLocalSocket* client)
+    {
+        if (auto* idle = client->findChild<QTimer*>())
+            idle->start();
+
+        QList<OsdMessage> messages;
+        if (!readOsdFrames(client, messages)) {
+            qWarning() << "[WARN] dropping OSD client sending a bad frame";
+            client->abort();
+            return;
+        }
+
+        for (const OsdMessage& message : messages) {
+            if (message.type != OsdMessage::Ping && message.type != OsdMessage::Pong)
+                osdTrace("received");
+
+            switch (message.type) {
+            case OsdMessage::Show:
+                m_show = message;
+                break;
+            case OsdMessage::Adjust:
+                if (message.kind == OsdMessage::Volume) {
+                    m_volumeDelta += message.delta;
+                    m_volumeAdjusted = true;
+                    m_muteToggles = 0; // adjusting unmutes anyway
+                } else {
+                    m_brightnessDeltas[message.output] += message.delta;
+                }
+                m_show.reset();
+                m_shownKind = message.kind;
+                m_shownOutput = message.output;
+                break;
+            case OsdMessage::ToggleMute:
+                ++m_muteToggles;
+                m_show.reset();
+                m_shownKind = OsdMessage::Volume;
+                break;
+            case OsdMessage::Ping:
+                // Answered once whatever came before it has been applied
+                if (hasWork())
+                    m_pings.append({ client, message.serial });
+                else
+                    client->write(encodeOsdFrame(pong(message.serial)));
+                break;
+            case OsdMessage::Pong:
+                break;
+            }
+        }
+
+        if (hasWork() && !m_frameInFlight && !m_applyTimer.isActive())
+            m_applyTimer.start(0); // after every socket ready in this loop pass
+    }
+
+    bool hasWork() const
+    {
+        return m_volumeAdjusted || m_muteToggles > 0 || !m_brightnessDeltas.isEmpty() || m_show;
+    }
+
+    Backlight& backlight(const QString& output)
+    {
+        auto it = m_backlights.find(output);
+        if (it == m_backlights.end())
+            it = m_backlights.insert(output, Backlight::forOutput(output));
+        return *it;
+    }
+
+    // Raw brightness as last set by us; read from sysfs only when we have none
+    int rawLevel(const QString& output)
+    {
+        auto it = m_levels.find(output);
+        if (it == m_levels.end() || *it < 0)
+            it = m_levels.insert(output, backlight(output).brightness());
+        return *it;
+    }
+
+    int level(const QString& output) { return backlight(output).percentOf(rawLevel(output)); }
+
+    // Everything piled up since the last frame goes out in one write each
+    void applyIntents()
+    {
+        if (m_volumeAdjusted)
+            m_mixer->adjust(m_volumeDelta);
+        if (m_muteToggles % 2)
+            m_mixer->toggleMute();
+        if ((m_volumeAdjusted || m_muteToggles > 0) && !m_mixer->state().isValid())
+            qWarning() << "[WARN] no usable mixer control";
+        m_volumeDelta = 0;
+        m_volumeAdjusted = false;
+        m_muteToggles = 0;
+
+        for (auto it = m_brightnessDeltas.cbegin(); it != m_brightnessDeltas.cend(); ++it) {
+            const int current = rawLevel(it.key());
+            if (current < 0) {
+                qWarning() << "[WARN] no usable backlight for output" << it.key();
+                continue;
+            }
+            m_levels[it.key()] = backlight(it.key()).adjust(it.value(), current);
+        }
+        m_brightnessDeltas.clear();
+    }
+
+    OsdMessage pong(quint32 serial)
+    {
+        const MixerState volume = m_mixer->state();
+        OsdMessage message;
+        message.type = OsdMessage::Pong;
+        message.serial = serial;
+        message.value = volume.percent;
+        message.muted = volume.muted;
+        message.brightness = level(QString());
+        return message;
+    }
+
+    void apply()
+    {
+        if (!hasWork())
+            return;
+        applyIntents();
+
+        OsdMessage message;
+        if (m_show) {
+            message = *m_show;
+            m_show.reset();
+        } else if (m_shownKind == OsdMessage::Brightness) {
+            message.kind = OsdMessage::Brightness;
+            message.value = level(m_shownOutput);
+        } else {
+            const MixerState volume = m_mixer->state();
+            message.value = volume.percent;
+            message.muted = volume.muted;
+        }
+
+        for (const auto& [client, serial] : std::as_const(m_pings)) {
+            if (client)
+                client->write(encodeOsdFrame(pong(serial)));
+        }
+        m_pings.clear();
+
+        if (message.value < 0)
+            return; // nothing to show; already warned
+
+        m_window->setProperty("mode", message.mode());
+        m_window->setProperty("value", message.muted && message.kind == OsdMessage::Volume ? 0 : message.value);
+        m_window->setProperty("muted", message.muted);
+        m_window->setProperty("shown", true);
+        osdTrace("set");
+        m_window->update(); // a frame even if nothing changed, so frameSwapped follows
+
+        if (!m_window->isVisible()) {
+            // Show and center the window
+            m_window->show();
+            center();
+            m_window->raise();
+            m_window->requestActivate();
+        }
+        m_hideTimer.start();
+
+        m_frameInFlight = true;
+        m_frameFallback.start();
+    }
+
+    void center()
+    {
+        QScreen* screen = m_window->screen();
+        if (screen) {
+            QRect screenGeometry = screen->geometry();
+            int x = screenGeometry.x() + (screenGeometry.width() - m_window->width()) / 2;
+            int y = screenGeometry.y() + (screenGeometry.height() - m_window->height()) / 2;
+            m_window->setPosition(x, y);
+        }
+    }
+
+    void hide()
+    {
+        if (!m_alwaysMapped) {
+            m_window->hide();
+            return;
+        }
+        // Stay mapped; the next frame is just empty
+        m_window->setProperty("shown", false);
+        m_window->update();
+    }
+
+    void frameDone()
+    {
+        if (!m_frameInFlight)
+            return;
+        m_frameInFlight = false;
+        m_frameFallback.stop();
+        if (hasWork())
+            apply();
+    }
+
+    QQuickWindow* m_window;
+    Mixer* m_mixer;
+    const bool m_alwaysMapped;
+    QHash<QString, Backlight> m_backlights; // by output; "" is the default one
+    QHash<QString, int> m_levels; // raw brightness by output
+    QLocalServer m_server;
+    QTimer m_hideTimer;
+    QTimer m_applyTimer;
+    QTimer m_frameFallback;
+    bool m_frameInFlight = false;
+
+    // Pending until the next frame
+    int m_volumeDelta = 0;
+    bool m_volumeAdjusted = false;
+    int m_muteToggles = 0;
+    QHash<QString, int> m_brightnessDeltas;
+    std::optional<OsdMessage> m_show;
+    OsdMessage::Kind m_shownKind = OsdMessage::Volume;
+    QString m_shownOutput;
+    QList<QPair<QPointer<QLocalSocket>, quint32>> m_pings;
+};
 
 int main(int argc, char* argv[])
 {
@@ -59,6 +373,8 @@ int main(int argc, char* argv[])
 
     settings.endGroup();
 
+    const bool alwaysMapped = settings.value("OSD/AlwaysMapped", false).toBool();
+
     // Expose AppModel map to QML
     engine.rootContext()->setContextProperty("AppModel", QVariant::fromValue(AppModel));
 
@@ -76,7 +392,7 @@ int main(int argc, char* argv[])
 
     // Get root QWindow
     QObject* root = engine.rootObjects().first();
-    QWindow* window = qobject_cast<QWindow*>(root);
+    QQuickWindow* window = qobject_cast<QQuickWindow*>(root);
     if (!window) {
         qCritical("Root object is not a QWindow.");
         return -1;
@@ -99,49 +415,11 @@ int main(int argc, char* argv[])
     // Start hidden
     window->hide();
 
-    // Auto-hide after 1.5 seconds
-    QTimer timer;
-    timer.setInterval(1500);
-    timer.setSingleShot(true);
-    QObject::connect(&timer, &QTimer::timeout, [&]() {
-        window->hide();
-    });
-
-    // Local socket server setup
-    QLocalServer server;
-    QLocalServer::removeServer(socketName);
-    if (!server.listen(socketName)) {
-        qCritical() << "Failed to start socket server on" << socketName;
+    OsdServer server(window, alwaysMapped);
+    if (!server.listen())
         return 1;
-    }
-
-    QObject::connect(&server, &QLocalServer::newConnection, [&]() {
-        QLocalSocket* client = server.nextPendingConnection();
-        if (client->waitForReadyRead(500)) {
-            QStringList parts = QString(client->readAll()).split(' ');
-            if (parts.size() >= 2) {
-                root->setProperty("mode", parts[0]);
-                root->setProperty("value", parts[1].toInt());
-                if (parts.size() >= 3)
-                    root->setProperty("muted", parts[2] == "1");
-
-                // Show and center the window
-                window->show();
-                QScreen* screen = window->screen();
-                if (screen) {
-                    QRect screenGeometry = screen->geometry();
-                    int x = screenGeometry.x() + (screenGeometry.width() - window->width()) / 2;
-                    int y = screenGeometry.y() + (screenGeometry.height() - window->height()) / 2;
-                    window->setPosition(x, y);
-                }
-
-                window->raise();
-                window->requestActivate();
-                timer.start();
-            }
-        }
-        client->disconnectFromServer();
-    });
 
     return app.exec();
 }
+
+#include "osd-server.moc"
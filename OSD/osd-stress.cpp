@@ -0,0 +1,261 @@
+// osd-stress: load against a running osd-server.
+//
+//   osd-stress [clients] [timeout-ms]
+//
+// Many clients at the same moment. Every client connects, sends a Show and
+// a Ping, and waits for its Pong, which the server only sends after handling
+// the Show. Reports how many got through and the connect-to-Pong times;
+// exits non-zero if any client was refused, dropped or not answered within
+// the timeout.
+//
+//   osd-stress hold [presses] [per-second]
+//
+// A held volume key: one short-lived client per repeat (default 45 at 30 a
+// second), each sending Adjust +-1 and leaving, as osd-client does. Pings
+// before and after give the volume the steps must add up to; exits non-zero
+// if any step was lost. Run the server with HEX_MIXER=fake to leave the real
+// volume alone.
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QLocalSocket>
+#include <QTimer>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "osdprotocol.h"
+
+static double percentile(std::vector<qint64> samples, double q)
+{
+    if (samples.empty())
+        return 0.0;
+    std::sort(samples.begin(), samples.end());
+    return samples[std::min(samples.size() - 1, size_t(q * samples.size()))] / 1e6;
+}
+
+static int burst(QCoreApplication& app, int clients, int timeoutMs)
+{
+    QElapsedTimer clock;
+    clock.start();
+
+    std::vector<qint64> roundTrips;
+    int failed = 0;
+    int pending = clients;
+    auto done = [&]() {
+        if (--pending == 0)
+            app.quit();
+    };
+
+    for (int i = 0; i < clients; ++i) {
+        auto* socket = new QLocalSocket(&app);
+        const qint64 startedNs = clock.nsecsElapsed();
+        auto finished = std::make_shared<bool>(false);
+
+        auto finish = [socket, startedNs, finished, &clock, &roundTrips, &failed, &done](bool ok) {
+            if (*finished)
+                return;
+            *finished = true;
+            if (ok)
+                roundTrips.push_back(clock.nsecsElapsed() - startedNs);
+            else
+                ++failed;
+            socket->abort();
+            done();
+        };
+
+        QObject::connect(socket, &QLocalSocket::connected, socket, [socket, i]() {
+            OsdMessage show;
+            show.kind = i % 2 ? OsdMessage::Brightness : OsdMessage::Volume;
+            show.value = i % 101;
+            OsdMessage ping;
+            ping.type = OsdMessage::Ping;
+            ping.serial = quint32(i);
+            socket->write(encodeOsdFrame(show) + encodeOsdFrame(ping));
+        });
+        QObject::connect(socket, &QLocalSocket::readyRead, socket, [socket, i, finish]() {
+            QList<OsdMessage> replies;
+            if (!readOsdFrames(socket, replies))
+                finish(false);
+            for (const OsdMessage& reply : replies) {
+                if (reply.type == OsdMessage::Pong)
+                    finish(reply.serial == quint32(i));
+            }
+        });
+        QObject::connect(socket, &QLocalSocket::errorOccurred, socket, [finish]() { finish(false); });
+
+        socket->connectToServer(osdSocketName());
+    }
+
+    QTimer::singleShot(timeoutMs, &app, [&]() {
+        failed += pending;
+        app.quit();
+    });
+    app.exec();
+
+    std::printf("%d clients: %zu answered, %d failed, %.1f ms total\n", clients, roundTrips.size(), failed,
+        clock.nsecsElapsed() / 1e6);
+    std::printf("connect to pong: p50 %.2f ms, p99 %.2f ms, max %.2f ms\n", percentile(roundTrips, 0.50),
+        percentile(roundTrips, 0.99), percentile(roundTrips, 1.0));
+
+    return failed == 0 ? 0 : 1;
+}
+
+// Calls `answer` with the server's Pong, or with a Pong carrying volume -1
+// when the server could not be reached
+static void ping(QObject* parent, const std::function<void(const OsdMessage&)>& answer)
+{
+    auto* socket = new QLocalSocket(parent);
+    auto answered = std::make_shared<bool>(false);
+    auto finish = [socket, answered, answer](const OsdMessage& reply) {
+        if (*answered)
+            return;
+        *answered = true;
+        socket->abort();
+        socket->deleteLater();
+        answer(reply);
+    };
+
+    QObject::connect(socket, &QLocalSocket::connected, socket, [socket]() {
+        OsdMessage message;
+        message.type = OsdMessage::Ping;
+        socket->write(encodeOsdFrame(message));
+    });
+    QObject::connect(socket, &QLocalSocket::readyRead, socket, [socket, finish]() {
+        QList<OsdMessage> replies;
+        readOsdFrames(socket, replies);
+        for (const OsdMessage& reply : replies) {
+            if (reply.type == OsdMessage::Pong)
+                finish(reply);
+        }
+    });
+    // May fire inside connectToServer(), before the event loop runs
+    QObject::connect(socket, &QLocalSocket::errorOccurred, socket, [socket, finish]() {
+        QTimer::singleShot(0, socket, [finish]() {
+            OsdMessage lost;
+            lost.type = OsdMessage::Pong;
+            lost.value = -1;
+            finish(lost);
+        });
+    });
+    socket->connectToServer(osdSocketName());
+}
+
+static int hold(QCoreApplication& app, int presses, int perSecond)
+{
+    QElapsedTimer clock;
+    clock.start();
+
+    int startVolume = -1, expected = -1, finalVolume = -1, step = 1, sent = 0, failed = 0, pongs = 0;
+    bool finalMuted = false;
+    qint64 lastPressNs = 0, settledNs = -1;
+    std::vector<qint64> pressTimes;
+
+    QTimer repeat;
+    repeat.setInterval(1000 / perSecond);
+
+    // After the last press, ping until the volume has caught up or 2 s pass
+    std::function<void()> settle = [&]() {
+        ping(&app, [&](const OsdMessage& reply) {
+            ++pongs;
+            finalVolume = reply.value;
+            finalMuted = reply.muted;
+            const bool caughtUp = finalVolume == expected;
+            if (caughtUp)
+                settledNs = clock.nsecsElapsed() - lastPressNs;
+            if (caughtUp || finalVolume < 0 || clock.nsecsElapsed() - lastPressNs > 2000000000LL)
+                app.quit();
+            else
+                QTimer::singleShot(5, &app, settle);
+        });
+    };
+
+    auto press = [&]() {
+        const int index = sent++;
+        if (sent == presses)
+            repeat.stop();
+
+        auto* socket = new QLocalSocket(&app);
+        const qint64 startedNs = clock.nsecsElapsed();
+        auto finished = std::make_shared<bool>(false);
+        auto finish = [&, socket, finished, startedNs, index](bool ok) {
+            if (*finished)
+                return;
+            *finished = true;
+            if (ok)
+                pressTimes.push_back(clock.nsecsElapsed() - startedNs);
+            else
+                ++failed;
+            socket->disconnectFromServer();
+            socket->deleteLater();
+            if (index == presses - 1) {
+                lastPressNs = clock.nsecsElapsed();
+                settle();
+            }
+        };
+        QObject::connect(socket, &QLocalSocket::connected, socket, [socket, &step]() {
+            OsdMessage adjust;
+            adjust.type = OsdMessage::Adjust;
+            adjust.kind = OsdMessage::Volume;
+            adjust.delta = step;
+            socket->write(encodeOsdFrame(adjust));
+        });
+        QObject::connect(socket, &QLocalSocket::bytesWritten, socket, [finish]() { finish(true); });
+        QObject::connect(socket, &QLocalSocket::errorOccurred, socket, [finish]() { finish(false); });
+        socket->connectToServer(osdSocketName());
+    };
+    QObject::connect(&repeat, &QTimer::timeout, &app, press);
+
+    ping(&app, [&](const OsdMessage& reply) {
+        startVolume = reply.value;
+        if (startVolume < 0) {
+            app.quit();
+            return;
+        }
+        // Head for the side with room, so no step is lost to clamping
+        step = startVolume > 50 ? -1 : 1;
+        expected = std::clamp(startVolume + step * presses, 0, 100);
+        if (expected != startVolume + step * presses)
+            std::printf("note: %d presses from %d%% clamp at %d%%; steps past it go uncounted\n", presses,
+                startVolume, expected);
+        press();
+        if (sent < presses)
+            repeat.start();
+    });
+    app.exec();
+
+    if (startVolume < 0) {
+        std::fprintf(stderr, "no osd-server, or it has no mixer (try HEX_MIXER=fake)\n");
+        return 1;
+    }
+
+    const int lost = qAbs(expected - finalVolume);
+    std::printf("%d presses at %d/s: %d failed to send, volume %d -> %d%s (expected %d, %d steps lost)\n", presses,
+        perSecond, failed, startVolume, finalVolume, finalMuted ? " muted" : "", expected, lost);
+    std::printf("press (connect + write): p50 %.2f ms, p99 %.2f ms, max %.2f ms\n", percentile(pressTimes, 0.50),
+        percentile(pressTimes, 0.99), percentile(pressTimes, 1.0));
+    if (settledNs >= 0)
+        std::printf("last press to settled volume: %.2f ms (%d pings)\n", settledNs / 1e6, pongs);
+    else
+        std::printf("volume never settled (%d pings)\n", pongs);
+
+    return failed == 0 && lost == 0 && !finalMuted ? 0 : 1;
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    if (argc > 1 && std::strcmp(argv[1], "hold") == 0) {
+        const int presses = argc > 2 ? std::max(1, atoi(argv[2])) : 45;
+        const int perSecond = argc > 3 ? std::clamp(atoi(argv[3]), 1, 1000) : 30;
+        return hold(app, presses, perSecond);
+    }
+
+    const int clients = argc > 1 ? std::max(1, atoi(argv[1])) : 500;
+    const int timeoutMs = argc > 2 ? std::max(100, atoi(argv[2])) : 10000;
+    return burst(app, clients, timeoutMs);
+}
@@ -0,0 +1,121 @@
+#include "osdprotocol.h"
+
+#include <QDataStream>
+#include <QIODevice>
+#include <QtEndian>
+#include <cstdio>
+#include <ctime>
+
+QString osdSocketName()
+{
+    const QString name = qEnvironmentVariable("HEX_OSD_SOCKET");
+    return name.isEmpty() ? QStringLiteral("osd_instance_socket") : name;
+}
+
+QString OsdMessage::mode() const
+{
+    if (kind == Brightness)
+        return "brightness";
+    return muted ? "mute" : "volume";
+}
+
+QByteArray encodeOsdFrame(const OsdMessage& message)
+{
+    QByteArray frame(sizeof(quint32), '\0');
+    QDataStream out(&frame, QIODevice::WriteOnly | QIODevice::Append);
+    out.setVersion(QDataStream::Qt_6_0);
+
+    out << osdProtocolVersion << quint8(message.type);
+    switch (message.type) {
+    case OsdMessage::Show:
+        out << quint8(message.kind) << message.value << message.muted;
+        break;
+    case OsdMessage::Adjust:
+        out << quint8(message.kind) << message.delta << message.output;
+        break;
+    case OsdMessage::ToggleMute:
+        break;
+    case OsdMessage::Ping:
+        out << message.serial;
+        break;
+    case OsdMessage::Pong:
+        out << message.serial << message.value << message.muted << message.brightness;
+        break;
+    }
+
+    qToBigEndian<quint32>(frame.size() - sizeof(quint32), frame.data());
+    return frame;
+}
+
+static bool decodeOsdPayload(const QByteArray& payload, OsdMessage& message)
+{
+    QDataStream in(payload);
+    in.setVersion(QDataStream::Qt_6_0);
+
+    quint8 version = 0, type = 0;
+    in >> version >> type;
+    if (version != osdProtocolVersion)
+        return false;
+
+    quint8 kind = OsdMessage::Volume;
+    switch (type) {
+    case OsdMessage::Show:
+        in >> kind >> message.value >> message.muted;
+        break;
+    case OsdMessage::Adjust:
+        in >> kind >> message.delta >> message.output;
+        break;
+    case OsdMessage::ToggleMute:
+        break;
+    case OsdMessage::Ping:
+        in >> message.serial;
+        break;
+    case OsdMessage::Pong:
+        in >> message.serial >> message.value >> message.muted >> message.brightness;
+        break;
+    default:
+        return false;
+    }
+
+    if (kind > OsdMessage::Brightness)
+        return false;
+    message.kind = OsdMessage::Kind(kind);
+    message.type = OsdMessage::Type(type);
+    return in.status() == QDataStream::Ok;
+}
+
+bool readOsdFrames(QIODevice* device, QList<OsdMessage>& messages)
+{
+    for (;;) {
+        char header[sizeof(quint32)];
+        if (device->peek(header, sizeof(header)) < qint64(sizeof(header)))
+            return true;
+
+        const quint32 size = qFromBigEndian<quint32>(header);
+        if (size > osdMaxFrameSize)
+            return false;
+        if (device->bytesAvailable() < qint64(sizeof(header) + size))
+            return true;
+
+        device->skip(sizeof(header));
+        OsdMessage message;
+        if (decodeOsdPayload(device->read(size), message))
+            messages.append(message);
+    }
+}
+
+qint64 osdTraceNow()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return qint64(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+void osdTrace(const char* stage)
+{
+    static const bool enabled = qEnvironmentVariableIsSet("HEX_OSD_TRACE");
+    if (!enabled)
+        return;
+    std::printf("trace %s %lld\n", stage, static_cast<long long>(osdTraceNow()));
+    std::fflush(stdout);
+}
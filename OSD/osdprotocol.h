@@ -0,0 +1,74 @@
+#pragma once
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+
+class QIODevice;
+
+// What goes over the OSD's local socket.
+//
+// Every message is one frame: a big-endian quint32 payload length, then the
+// payload, written with QDataStream. The payload starts with the protocol
+// version and the message type; typed fields follow. A reader skips a frame
+// whose version or type it does not know, and ignores bytes past the fields
+// it knows, so fields can be appended without breaking older servers.
+//
+//   version 1
+//     Show        kind:quint8 value:qint32 muted:bool     client -> server
+//     Adjust      kind:quint8 delta:qint32 output:QString client -> server
+//     ToggleMute                                          client -> server
+//     Ping        serial:quint32                          client -> server
+//     Pong        serial:quint32 volume:qint32 muted:bool server -> client,
+//                 brightness:qint32                       once everything
+//                                                         sent before the
+//                                                         Ping is applied
+//
+// Show displays a state the client already set. Adjust and ToggleMute leave
+// the change to the server, which owns the mixer and backlight; output
+// names the backlight's output and may be empty.
+
+// "osd_instance_socket" unless HEX_OSD_SOCKET names another, so a second
+// server (osd-bench's) can run beside the real one
+QString osdSocketName();
+constexpr quint8 osdProtocolVersion = 1;
+constexpr quint32 osdMaxFrameSize = 4096;
+
+struct OsdMessage {
+    enum Type : quint8 {
+        Show = 1,
+        Ping = 2,
+        Pong = 3,
+        Adjust = 4,
+        ToggleMute = 5
+    };
+    enum Kind : quint8 {
+        Volume = 0,
+        Brightness = 1
+    };
+
+    Type type = Show;
+    Kind kind = Volume;
+    qint32 value = 0; // Show; the volume in a Pong
+    bool muted = false;
+    qint32 delta = 0;
+    QString output;
+    quint32 serial = 0;
+    qint32 brightness = -1; // Pong
+
+    // What main.qml shows: "volume", "mute" or "brightness"
+    QString mode() const;
+};
+
+QByteArray encodeOsdFrame(const OsdMessage& message);
+
+// Takes every complete frame off `device` and leaves partial ones there for
+// the next readyRead. Returns false on a frame too large to be ours: the
+// stream cannot be trusted any more and the peer should be dropped.
+bool readOsdFrames(QIODevice* device, QList<OsdMessage>& messages);
+
+// Stage timestamps for osd-bench. With HEX_OSD_TRACE set, osd-client and
+// osd-server print "trace <stage> <ns>" lines on stdout. The clock is
+// CLOCK_MONOTONIC, so lines from different processes compare directly.
+qint64 osdTraceNow();
+void osdTrace(const char* stage);
@@ -1,3 +1,4 @@
+#include "clockservice.h"
 #include "lockmanager.h"
 #include <LayerShellQt/window.h>
 #include <QDebug>
@@ -5,6 +6,7 @@
 #include <QGuiApplication>
 #include <QQmlApplicationEngine>
 #include <QQmlContext>
+#include <QQmlEngine>
 #include <QQuickWindow>
 #include <QSettings>
 #include <QStandardPaths>
@@ -34,6 +36,7 @@ int main(int argc, char* argv[])
         }
     }
 
+    qmlRegisterType<WorldClock>("Hex", 1, 0, "WorldClock");
     QQmlApplicationEngine engine;
 
     // Instantiate and expose LockManager
@@ -2,6 +2,7 @@ import QtQuick 2.15
 import QtQuick.Controls 2.15
 import QtQuick.Shapes 1.15
 import QtQuick.Window 2.15
+import Hex 1.0
 
 Window {
     id: root
@@ -41,8 +42,8 @@ Window {
     Item {
         id: hexClock
 
-        property string currentTime: Qt.formatTime(new Date(), "hh:mm:ss")
-        property string currentDate: Qt.formatDate(new Date(), "ddd, MMM d")
+        property string currentTime: clock.time
+        property string currentDate: clock.date
 
         width: hexWidth * 0.8
         height: hexHeight * 0.6
@@ -99,14 +100,8 @@ Window {
 
         }
 
-        Timer {
-            interval: 1000
-            running: true
-            repeat: true
-            onTriggered: {
-                hexClock.currentTime = Qt.formatTime(new Date(), "hh:mm:ss");
-                hexClock.currentDate = Qt.formatDate(new Date(), "ddd, MMM d");
-            }
+        WorldClock {
+            id: clock
         }
 
         Column {
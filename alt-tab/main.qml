@@ -0,0 +1,149 @@
+import QtQuick 2.15
+import QtQuick.Shapes 1.15
+import QtQuick.Window 2.15
+
+Window {
+    id: root
+
+    // Set from C++ once the scene is loaded
+    property var controller: null
+
+    property int tileWidth: AppModel.HexWidth * 0.6
+    property int tileHeight: AppModel.HexHeight * 0.6
+
+    width: 1920
+    height: 1080
+    color: "transparent"
+    flags: Qt.FramelessWindowHint | Qt.WindowStaysOnTopHint | Qt.Tool
+
+    Item {
+        id: keyHandler
+
+        anchors.fill: parent
+        focus: true
+
+        Keys.onPressed: (event) => {
+            if (!root.controller)
+                return;
+            if (event.key === Qt.Key_Backtab || (event.key === Qt.Key_Tab && (event.modifiers & Qt.ShiftModifier))) {
+                root.controller.previous();
+                event.accepted = true;
+            } else if (event.key === Qt.Key_Tab || event.key === Qt.Key_Right) {
+                root.controller.next();
+                event.accepted = true;
+            } else if (event.key === Qt.Key_Left) {
+                root.controller.previous();
+                event.accepted = true;
+            } else if (event.key === Qt.Key_Return || event.key === Qt.Key_Enter) {
+                root.controller.commit();
+                event.accepted = true;
+            } else if (event.key === Qt.Key_Escape) {
+                root.controller.cancel();
+                event.accepted = true;
+            }
+        }
+
+        // Activate the selection when Alt is let go
+        Keys.onReleased: (event) => {
+            if (root.controller && event.key === Qt.Key_Alt) {
+                root.controller.commit();
+                event.accepted = true;
+            }
+        }
+    }
+
+    Rectangle {
+        anchors.centerIn: parent
+        width: Math.min(parent.width - 40, windowRow.implicitWidth + 40)
+        height: root.tileHeight + 70
+        radius: 10
+        color: "#000000cc"
+        // The window stays mapped while closed; only this goes away
+        visible: switcherModel.count > 0 && root.controller !== null && root.controller.open
+
+        Row {
+            id: windowRow
+
+            anchors.centerIn: parent
+            spacing: 12
+
+            Repeater {
+                model: switcherModel
+
+                delegate: Item {
+                    id: tile
+
+                    property bool selected: root.controller && root.controller.selectedIndex === index
+
+                    width: root.tileWidth
+                    height: root.tileHeight + 30
+
+                    Shape {
+                        id: hexagon
+
+                        width: root.tileWidth
+                        height: root.tileHeight
+                        antialiasing: true
+
+                        ShapePath {
+                            strokeWidth: AppModel.BorderWidth
+                            strokeColor: tile.selected ? AppModel.BorderHoveredColor : AppModel.BorderColor
+                            fillColor: tile.selected ? AppModel.HoveredColor : AppModel.FillColor
+                            fillRule: ShapePath.WindingFill
+                            capStyle: ShapePath.FlatCap
+                            joinStyle: ShapePath.MiterJoin
+                            startX: hexagon.width / 2
+                            startY: 0
+
+                            PathLine { x: hexagon.width; y: hexagon.height * 0.25 }
+                            PathLine { x: hexagon.width; y: hexagon.height * 0.75 }
+                            PathLine { x: hexagon.width / 2; y: hexagon.height }
+                            PathLine { x: 0; y: hexagon.height * 0.75 }
+                            PathLine { x: 0; y: hexagon.height * 0.25 }
+                            PathLine { x: hexagon.width / 2; y: 0 }
+                        }
+                    }
+
+                    Image {
+                        anchors.centerIn: hexagon
+                        width: hexagon.width * 0.5
+                        height: hexagon.height * 0.5
+                        fillMode: Image.PreserveAspectFit
+                        asynchronous: false
+                        source: model.icon !== "" ? "file:" + model.icon : ""
+                    }
+
+                    Text {
+                        anchors.centerIn: hexagon
+                        visible: model.icon === ""
+                        text: model.appId.charAt(0).toUpperCase()
+                        color: "white"
+                        font.pixelSize: hexagon.height * 0.3
+                        font.family: AppModel.mainFont
+                        font.bold: true
+                    }
+
+                    Text {
+                        anchors.top: hexagon.bottom
+                        anchors.topMargin: 8
+                        anchors.horizontalCenter: hexagon.horizontalCenter
+                        width: root.tileWidth
+                        text: model.title
+                        elide: Text.ElideRight
+                        horizontalAlignment: Text.AlignHCenter
+                        color: tile.selected ? "white" : "#AAAAAA"
+                        font.pixelSize: 12
+                    }
+
+                    MouseArea {
+                        anchors.fill: parent
+                        hoverEnabled: true
+                        cursorShape: Qt.PointingHandCursor
+                        onEntered: root.controller.select(index)
+                        onClicked: root.controller.commit()
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,313 @@
+// open-bench: key press to first frame, for the Alt-Tab switcher and the
+// launcher, over repeated runs.
+//
+// Usage: open-bench [--runs N] [--path alt-tab|launcher|both] [--gap ms]
+//                   [--switch-server PATH] [--switch-client PATH]
+//                   [--launcher PATH]
+//
+// Needs a running compositor (WAYLAND_DISPLAY) with at least one window
+// open, since the switcher only opens when there is something to switch to.
+// Everything runs with a private TMPDIR, so its hexswitch socket and the
+// launcher's single-instance socket are its own and a running shell is left
+// alone.
+//
+// Each press is exec'd with HEX_EXEC_STAMP set to CLOCK_MONOTONIC ms taken
+// in the forked child just before execve(). hexswitch forwards it with the
+// "next" command and the launcher reads it at startup, so both "open
+// latency" lines they log measure from the exec to the first frame swapped
+// on the same clock, with no /proc starttime (clock-tick) rounding:
+//
+//   alt-tab     `hexswitch --next` against a resident hexswitch-server
+//               (then `hexswitch --cancel` and --gap ms to close)
+//   alt-tab-cmd the same presses, from the command's arrival at the server
+//   launcher    a fresh hexlauncher per run (SIGTERM and --gap ms after)
+//
+// Binaries default to the ones next to this executable for the switcher and
+// to hexlauncher on PATH.
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <poll.h>
+#include <string>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+extern char** environ;
+
+static double now_ms()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+[[noreturn]] static void fail(const std::string& message)
+{
+    std::cerr << "open-bench: " << message << std::endl;
+    exit(1);
+}
+
+// ----------------- Child processes -----------------
+struct Child {
+    pid_t pid = -1;
+    int out = -1; // our end of its stdout and stderr, or -1
+    std::string buffer;
+
+    // Next output line, or false after timeoutMs / EOF
+    bool readLine(std::string& line, int timeoutMs)
+    {
+        const double deadline = now_ms() + timeoutMs;
+        for (;;) {
+            size_t newline = buffer.find('\n');
+            if (newline != std::string::npos) {
+                line = buffer.substr(0, newline);
+                buffer.erase(0, newline + 1);
+                return true;
+            }
+
+            int remaining = int(deadline - now_ms());
+            pollfd pfd = { out, POLLIN, 0 };
+            if (remaining <= 0 || poll(&pfd, 1, remaining) <= 0)
+                return false;
+
+            char buf[4096];
+            ssize_t n = read(out, buf, sizeof(buf));
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                return false;
+            buffer.append(buf, n);
+        }
+    }
+
+    // The number after "open latency" in the next line that has one, and
+    // after "(" on the same line if given; -1 on timeout
+    double waitForLatency(int timeoutMs, double* afterCommand = nullptr)
+    {
+        const double deadline = now_ms() + timeoutMs;
+        std::string line;
+        while (readLine(line, std::max(0, int(deadline - now_ms())))) {
+            const size_t at = line.find("open latency ");
+            if (at == std::string::npos)
+                continue;
+            const size_t paren = line.find('(', at);
+            if (afterCommand)
+                *afterCommand = paren == std::string::npos ? -1 : std::strtod(line.c_str() + paren + 1, nullptr);
+            return std::strtod(line.c_str() + at + 13, nullptr);
+        }
+        return -1;
+    }
+
+    void reap()
+    {
+        int status;
+        while (waitpid(pid, &status, 0) < 0 && errno == EINTR) { }
+        if (out >= 0)
+            close(out);
+        out = -1;
+    }
+};
+
+// Runs args (looked up on PATH) with extra environment entries on top of
+// ours, HEX_EXEC_STAMP among them, taken as late as possible
+static Child spawn(const std::vector<std::string>& args, const std::vector<std::string>& extraEnv, bool capture)
+{
+    std::vector<char*> argv;
+    for (const std::string& arg : args)
+        argv.push_back(const_cast<char*>(arg.c_str()));
+    argv.push_back(nullptr);
+
+    // Built before fork; the child only fills in the stamp
+    char stamp[64] = "HEX_EXEC_STAMP=";
+    auto overridden = [&](const char* var) {
+        const size_t name = strcspn(var, "=") + 1;
+        if (strncmp(var, stamp, name) == 0)
+            return true;
+        return std::any_of(extraEnv.begin(), extraEnv.end(),
+            [&](const std::string& extra) { return extra.compare(0, name, var, name) == 0; });
+    };
+    std::vector<char*> envp;
+    for (char** var = environ; *var; ++var) {
+        if (!overridden(*var))
+            envp.push_back(*var);
+    }
+    for (const std::string& var : extraEnv)
+        envp.push_back(const_cast<char*>(var.c_str()));
+    envp.push_back(stamp);
+    envp.push_back(nullptr);
+
+    int outPipe[2] = { -1, -1 };
+    if (capture && pipe2(outPipe, O_CLOEXEC) < 0)
+        fail("pipe failed");
+
+    Child child;
+    child.pid = fork();
+    if (child.pid < 0)
+        fail("fork failed");
+
+    if (child.pid == 0) {
+        int null = open("/dev/null", O_RDWR);
+        dup2(null, STDIN_FILENO);
+        dup2(capture ? outPipe[1] : null, STDOUT_FILENO);
+        dup2(capture ? outPipe[1] : null, STDERR_FILENO);
+        snprintf(stamp + 15, sizeof(stamp) - 15, "%.3f", now_ms());
+        execvpe(argv[0], argv.data(), envp.data());
+        _exit(127);
+    }
+
+    if (capture) {
+        close(outPipe[1]);
+        child.out = outPipe[0];
+    }
+    return child;
+}
+
+// ----------------- Reporting -----------------
+struct Samples {
+    std::vector<double> values;
+
+    void add(double value) { values.push_back(value); }
+
+    double percentile(double p)
+    {
+        if (values.empty())
+            return 0;
+        std::sort(values.begin(), values.end());
+        return values[std::min(values.size() - 1, size_t(p * (values.size() - 1) + 0.5))];
+    }
+
+    void print(const char* name)
+    {
+        printf("%-11s runs=%zu min=%.3fms p50=%.3fms p99=%.3fms max=%.3fms\n", name, values.size(),
+            percentile(0), percentile(0.5), percentile(0.99), percentile(1));
+    }
+};
+
+static std::string exe_dir()
+{
+    char path[4096];
+    ssize_t n = readlink("/proc/self/exe", path, sizeof(path) - 1);
+    if (n <= 0)
+        return ".";
+    path[n] = '\0';
+    std::string dir = path;
+    return dir.substr(0, dir.rfind('/'));
+}
+
+static void sleep_ms(int ms)
+{
+    timespec ts = { ms / 1000, (ms % 1000) * 1000000L };
+    while (nanosleep(&ts, &ts) < 0 && errno == EINTR) { }
+}
+
+static void benchAltTab(int runs, int gapMs, const std::string& server, const std::string& client,
+    const std::string& tmpDir, const std::vector<std::string>& env)
+{
+    Child resident = spawn({ server }, env, true);
+
+    // Up once its socket is there
+    const std::string socket = tmpDir + "/hexswitch_socket";
+    const double deadline = now_ms() + 10000;
+    struct stat st;
+    while (stat(socket.c_str(), &st) < 0) {
+        if (now_ms() > deadline)
+            fail("hexswitch-server did not start listening within 10 s");
+        sleep_ms(10);
+    }
+    // Let it map its overlay and load the window list
+    sleep_ms(1000);
+
+    Samples exec, command;
+    for (int run = 0; run < runs; ++run) {
+        Child press = spawn({ client, "--next" }, env, false);
+        double afterCommand = -1;
+        const double latency = resident.waitForLatency(3000, &afterCommand);
+        press.reap();
+        if (latency < 0) {
+            kill(resident.pid, SIGTERM);
+            resident.reap();
+            fail("no switcher open latency within 3 s (is there a window to switch to?)");
+        }
+        exec.add(latency);
+        if (afterCommand >= 0)
+            command.add(afterCommand);
+
+        spawn({ client, "--cancel" }, env, false).reap();
+        sleep_ms(gapMs);
+    }
+
+    kill(resident.pid, SIGTERM);
+    resident.reap();
+    exec.print("alt-tab");
+    command.print("alt-tab-cmd");
+}
+
+static void benchLauncher(int runs, int gapMs, const std::string& launcher, const std::vector<std::string>& env)
+{
+    Samples exec;
+    for (int run = 0; run < runs; ++run) {
+        Child instance = spawn({ launcher }, env, true);
+        const double latency = instance.waitForLatency(10000);
+        kill(instance.pid, SIGTERM);
+        instance.reap();
+        if (latency < 0)
+            fail("no launcher open latency within 10 s");
+        exec.add(latency);
+        sleep_ms(gapMs);
+    }
+    exec.print("launcher");
+}
+
+int main(int argc, char** argv)
+{
+    int runs = 30;
+    int gapMs = 500;
+    std::string path = "both";
+    std::string server = exe_dir() + "/hexswitch-server";
+    std::string client = exe_dir() + "/hexswitch";
+    std::string launcher = "hexlauncher";
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--runs")
+            runs = std::max(1, atoi(argv[i + 1]));
+        else if (arg == "--gap")
+            gapMs = std::max(0, atoi(argv[i + 1]));
+        else if (arg == "--path")
+            path = argv[i + 1];
+        else if (arg == "--switch-server")
+            server = argv[i + 1];
+        else if (arg == "--switch-client")
+            client = argv[i + 1];
+        else if (arg == "--launcher")
+            launcher = argv[i + 1];
+        else
+            fail("unknown option " + arg);
+    }
+    if (path != "alt-tab" && path != "launcher" && path != "both")
+        fail("--path is alt-tab, launcher or both");
+    if (!getenv("WAYLAND_DISPLAY"))
+        fail("WAYLAND_DISPLAY is not set");
+
+    char tmp[] = "/tmp/open-bench-XXXXXX";
+    if (!mkdtemp(tmp))
+        fail("mkdtemp failed");
+    const std::vector<std::string> env = { std::string("TMPDIR=") + tmp, "QT_QPA_PLATFORM=wayland" };
+
+    if (path != "launcher")
+        benchAltTab(runs, gapMs, server, client, tmp, env);
+    if (path != "alt-tab")
+        benchLauncher(runs, gapMs, launcher, env);
+
+    std::string cleanup = std::string("rm -rf '") + tmp + "'";
+    return system(cleanup.c_str()) == 0 ? 0 : 1;
+}
@@ -0,0 +1,86 @@
+// hexswitch: bind this to Alt+Tab (and "--prev" to Alt+Shift+Tab).
+// Deliberately Qt-free: it runs on every key press and only has to hand one
+// line to hexswitch-server, which already has the overlay built.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+// Same path QLocalServer uses for the name "hexswitch_socket"
+static std::string socketPath()
+{
+    const char* tmp = std::getenv("TMPDIR");
+    std::string dir = (tmp && *tmp) ? tmp : "/tmp";
+    if (dir.size() > 1 && dir.back() == '/')
+        dir.pop_back();
+    return dir + "/hexswitch_socket";
+}
+
+// CLOCK_MONOTONIC in ms, which hexswitch-server measures open latency
+// against, as osd-bench's stage stamps are.
+static double monotonicMs()
+{
+    timespec now {};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000.0 + now.tv_nsec / 1e6;
+}
+
+// When this press started: HEX_EXEC_STAMP if whoever exec'd us set it just
+// before the exec (open-bench does, so exec and dynamic loading count too),
+// otherwise main() entry.
+static double pressStartMs(double mainMs)
+{
+    const char* stamp = std::getenv("HEX_EXEC_STAMP");
+    char* end = nullptr;
+    const double execMs = stamp ? std::strtod(stamp, &end) : 0;
+    return stamp && end != stamp && execMs > 0 ? execMs : mainMs;
+}
+
+int main(int argc, char* argv[])
+{
+    const double mainMs = monotonicMs();
+
+    std::string command = "next";
+    if (argc >= 2) {
+        std::string arg = argv[1];
+        if (arg == "--prev")
+            command = "prev";
+        else if (arg == "--cancel")
+            command = "cancel";
+        else if (arg != "--next") {
+            std::cerr << "Usage: hexswitch [--next|--prev|--cancel]" << std::endl;
+            return 1;
+        }
+    }
+
+    sockaddr_un addr {};
+    addr.sun_family = AF_UNIX;
+    const std::string path = socketPath();
+    if (path.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "Socket path too long: " << path << std::endl;
+        return 1;
+    }
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        std::cerr << "hexswitch-server is not running." << std::endl;
+        return 1;
+    }
+
+    if (command != "cancel") {
+        char stamp[32];
+        std::snprintf(stamp, sizeof(stamp), " %.3f", pressStartMs(mainMs));
+        command += stamp;
+    }
+    command += '\n';
+    ssize_t written = write(fd, command.data(), command.size());
+    close(fd);
+    return written == ssize_t(command.size()) ? 0 : 1;
+}
@@ -0,0 +1,397 @@
+#include <QAbstractListModel>
+#include <QDebug>
+#include <QDir>
+#include <QGuiApplication>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QQmlApplicationEngine>
+#include <QQmlContext>
+#include <QQuickWindow>
+#include <QSettings>
+#include <QStandardPaths>
+#include <algorithm>
+#include <atomic>
+#include <ctime>
+
+#include <LayerShellQt/window.h>
+
+#include "appicons.h"
+#include "windowevents.h"
+
+const QString socketName = "hexswitch_socket";
+
+// CLOCK_MONOTONIC in ms: what hexswitch stamps each press in, and what the
+// launcher measures its own open latency against
+static double monotonicMs()
+{
+    timespec now {};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000.0 + now.tv_nsec / 1e6;
+}
+
+// Toplevels in most-recently-used order. list-windows stamps every ACTIVATED
+// transition with an increasing serial; the model only keeps rows sorted by it.
+class SwitcherModel : public QAbstractListModel {
+    Q_OBJECT
+    Q_PROPERTY(int count READ rowCount NOTIFY countChanged)
+
+public:
+    enum Roles {
+        TitleRole = Qt::UserRole + 1,
+        AppIdRole,
+        IconRole,
+        FocusedRole
+    };
+
+    struct Entry {
+        quint32 id;
+        QString title;
+        QString appId;
+        QString icon;
+        bool focused;
+        quint64 lastActivated;
+    };
+
+    explicit SwitcherModel(QObject* parent = nullptr)
+        : QAbstractListModel(parent)
+    {
+    }
+
+    int rowCount(const QModelIndex& = QModelIndex()) const override
+    {
+        return entries.size();
+    }
+
+    QVariant data(const QModelIndex& index, int role) const override
+    {
+        if (!index.isValid() || index.row() >= entries.size())
+            return {};
+        const Entry& e = entries.at(index.row());
+        switch (role) {
+        case TitleRole:
+            return e.title;
+        case AppIdRole:
+            return e.appId;
+        case IconRole:
+            return e.icon;
+        case FocusedRole:
+            return e.focused;
+        }
+        return {};
+    }
+
+    QHash<int, QByteArray> roleNames() const override
+    {
+        return {
+            { TitleRole, "title" },
+            { AppIdRole, "appId" },
+            { IconRole, "icon" },
+            { FocusedRole, "focused" }
+        };
+    }
+
+    quint32 idAt(int row) const
+    {
+        return row >= 0 && row < entries.size() ? entries.at(row).id : 0;
+    }
+
+    void update(quint32 id, const QString& appId, const QString& title, bool focused, quint64 lastActivated)
+    {
+        // Same filter as windows.ini: skip ghost windows
+        if (title.isEmpty() || appId.isEmpty())
+            return;
+
+        int row = indexOf(id);
+        if (row < 0) {
+            Entry e { id, title, appId, iconForAppId(appId), focused, lastActivated };
+            int target = mruPosition(e.lastActivated, -1);
+            beginInsertRows(QModelIndex(), target, target);
+            entries.insert(target, e);
+            endInsertRows();
+            emit countChanged();
+            return;
+        }
+
+        Entry& e = entries[row];
+        if (e.appId != appId)
+            e.icon = iconForAppId(appId);
+        e.title = title;
+        e.appId = appId;
+        e.focused = focused;
+        e.lastActivated = lastActivated;
+
+        int target = mruPosition(lastActivated, row);
+        if (target != row) {
+            beginMoveRows(QModelIndex(), row, row, QModelIndex(), target > row ? target + 1 : target);
+            entries.move(row, target);
+            endMoveRows();
+        }
+        emit dataChanged(index(target), index(target));
+    }
+
+    void remove(quint32 id)
+    {
+        int row = indexOf(id);
+        if (row < 0)
+            return;
+        beginRemoveRows(QModelIndex(), row, row);
+        entries.removeAt(row);
+        endRemoveRows();
+        emit countChanged();
+    }
+
+signals:
+    void countChanged();
+
+private:
+    QList<Entry> entries;
+
+    int indexOf(quint32 id) const
+    {
+        for (int i = 0; i < entries.size(); ++i) {
+            if (entries[i].id == id)
+                return i;
+        }
+        return -1;
+    }
+
+    // Where a row activated at `serial` belongs, counting every row except
+    // `skipRow`. Rows with equal serials keep their current relative order.
+    int mruPosition(quint64 serial, int skipRow) const
+    {
+        int position = 0;
+        for (int i = 0; i < entries.size(); ++i) {
+            if (i == skipRow)
+                continue;
+            const quint64 other = entries[i].lastActivated;
+            if (other > serial || (other == serial && (skipRow < 0 || i < skipRow)))
+                ++position;
+        }
+        return position;
+    }
+};
+
+// Selection state for one Alt-Tab cycle, driven by the client commands and
+// the overlay's key handling.
+//
+// The layer surface is mapped once and stays mapped, like the OSD's
+// always-mapped mode: closed, the overlay draws nothing, takes no input and
+// asks for no keyboard; opening only flips that back and draws one frame,
+// instead of waiting for the compositor to configure a new surface.
+class SwitchController : public QObject {
+    Q_OBJECT
+    Q_PROPERTY(int selectedIndex READ selectedIndex NOTIFY selectedIndexChanged)
+    Q_PROPERTY(bool open READ isOpen NOTIFY openChanged)
+
+public:
+    SwitchController(SwitcherModel* model, WindowEventStream* stream, QQuickWindow* window,
+        LayerShellQt::Window* layerWindow, QObject* parent = nullptr)
+        : QObject(parent)
+        , m_model(model)
+        , m_stream(stream)
+        , m_window(window)
+        , m_layerWindow(layerWindow)
+    {
+        setInteractive(false);
+
+        // Open latency: exec of hexswitch -> first frame of the overlay on
+        // screen, the same measure as the launcher's "open latency" line, so
+        // the two compare directly. Direct: frameSwapped comes from the
+        // render thread, and a queued hop would add to the figure.
+        connect(m_window, &QQuickWindow::frameSwapped, this, [this]() {
+            const double commandMs = m_openCommandMs.exchange(-1, std::memory_order_acquire);
+            if (commandMs < 0)
+                return;
+            const double now = monotonicMs();
+            const double execMs = m_openExecMs.load(std::memory_order_relaxed);
+            qDebug() << "[INFO] switcher open latency" << (execMs >= 0 ? now - execMs : -1) << "ms ("
+                     << now - commandMs << "ms after the command)";
+        }, Qt::DirectConnection);
+
+        // Alt released before the overlay got keyboard focus: a quick Alt-Tab
+        // tap switches straight to the previous window.
+        connect(m_window, &QWindow::activeChanged, this, [this]() {
+            if (m_open && m_window->isActive() && !(QGuiApplication::queryKeyboardModifiers() & Qt::AltModifier))
+                commit();
+        });
+    }
+
+    int selectedIndex() const { return m_selected; }
+    bool isOpen() const { return m_open; }
+
+    // execMs: when the hexswitch that sent this was started (monotonicMs()),
+    // or -1 when it came from a key in the overlay or an older client
+    void step(int delta, double execMs = -1)
+    {
+        const int count = m_model->rowCount();
+        if (count == 0)
+            return;
+
+        if (!m_open) {
+            // Row 0 is the focused window; start on the one before it.
+            setSelected(std::clamp(delta > 0 ? 1 : count - 1, 0, count - 1));
+            m_openExecMs.store(execMs, std::memory_order_relaxed);
+            m_openCommandMs.store(monotonicMs(), std::memory_order_release);
+            m_open = true;
+            emit openChanged();
+            setInteractive(true);
+            m_window->requestActivate();
+            return;
+        }
+
+        setSelected(((m_selected + delta) % count + count) % count);
+    }
+
+    Q_INVOKABLE void next() { step(1); }
+    Q_INVOKABLE void previous() { step(-1); }
+
+    Q_INVOKABLE void select(int index)
+    {
+        if (index >= 0 && index < m_model->rowCount())
+            setSelected(index);
+    }
+
+    Q_INVOKABLE void commit()
+    {
+        if (!m_open)
+            return;
+        if (quint32 id = m_model->idAt(m_selected))
+            m_stream->activate(id);
+        cancel();
+    }
+
+    Q_INVOKABLE void cancel()
+    {
+        if (!m_open)
+            return;
+        m_open = false;
+        emit openChanged();
+        setInteractive(false);
+    }
+
+signals:
+    void selectedIndexChanged();
+    void openChanged();
+
+private:
+    void setInteractive(bool interactive)
+    {
+        m_layerWindow->setKeyboardInteractivity(interactive ? LayerShellQt::Window::KeyboardInteractivityExclusive
+                                                            : LayerShellQt::Window::KeyboardInteractivityNone);
+        m_window->setFlag(Qt::WindowTransparentForInput, !interactive);
+    }
+
+    void setSelected(int index)
+    {
+        if (index == m_selected)
+            return;
+        m_selected = index;
+        emit selectedIndexChanged();
+    }
+
+    SwitcherModel* m_model;
+    WindowEventStream* m_stream;
+    QQuickWindow* m_window;
+    LayerShellQt::Window* m_layerWindow;
+    std::atomic<double> m_openCommandMs { -1 }; // read on the render thread
+    std::atomic<double> m_openExecMs { -1 };
+    int m_selected = 0;
+    bool m_open = false;
+};
+
+int main(int argc, char* argv[])
+{
+    QGuiApplication app(argc, argv);
+    QQmlApplicationEngine engine;
+
+    QString configDir = QStandardPaths::writableLocation(QStandardPaths::ConfigLocation);
+    QDir hexDir(QDir(configDir).filePath("hexlauncher"));
+    QString configPath = hexDir.filePath("apps.ini");
+
+    QSettings settings(configPath, QSettings::IniFormat);
+
+    // Same look as the launcher and OSD
+    settings.beginGroup("gen");
+    QVariantMap AppModel;
+    AppModel["HexWidth"] = settings.value("HexWidth", 200).toInt();
+    AppModel["HexHeight"] = settings.value("HexHeight", 190).toInt();
+    AppModel["BorderWidth"] = settings.value("BorderWidth", 3).toInt();
+    AppModel["FillColor"] = settings.value("FillColor", "#333333cc").toString();
+    AppModel["BorderColor"] = settings.value("BorderColor", "white").toString();
+    AppModel["HoveredColor"] = settings.value("HoveredColor", "#555555cc").toString();
+    AppModel["BorderHoveredColor"] = settings.value("BorderHoveredColor", "#ffffff").toString();
+    AppModel["mainFont"] = settings.value("mainFont", "Orbitron").toString();
+    settings.endGroup();
+
+    engine.rootContext()->setContextProperty("AppModel", QVariant::fromValue(AppModel));
+
+    // The window list is kept current from the start, so opening the
+    // switcher never waits for list-windows.
+    SwitcherModel model;
+    WindowEventStream windowEvents;
+    QObject::connect(&windowEvents, &WindowEventStream::windowChanged, &model, &SwitcherModel::update);
+    QObject::connect(&windowEvents, &WindowEventStream::windowClosed, &model, &SwitcherModel::remove);
+    windowEvents.start();
+
+    engine.rootContext()->setContextProperty("switcherModel", &model);
+
+    // Build the scene once at startup; opening only shows it.
+    engine.load(QUrl(QStringLiteral("qrc:/main.qml")));
+    if (engine.rootObjects().isEmpty()) {
+        qCritical("Failed to load QML.");
+        return -1;
+    }
+
+    QQuickWindow* window = qobject_cast<QQuickWindow*>(engine.rootObjects().first());
+    if (!window) {
+        qCritical("Root object is not a QQuickWindow.");
+        return -1;
+    }
+
+    auto layerWindow = LayerShellQt::Window::get(window);
+    layerWindow->setLayer(LayerShellQt::Window::LayerOverlay);
+    layerWindow->setAnchors({ LayerShellQt::Window::AnchorTop,
+        LayerShellQt::Window::AnchorBottom,
+        LayerShellQt::Window::AnchorLeft,
+        LayerShellQt::Window::AnchorRight });
+    layerWindow->setExclusiveZone(-1);
+
+    SwitchController controller(&model, &windowEvents, window, layerWindow);
+    window->setProperty("controller", QVariant::fromValue<QObject*>(&controller));
+
+    // Mapped for good; see SwitchController
+    window->show();
+
+    // hexswitch sends "next" / "prev" / "cancel", one command per line,
+    // "next" and "prev" followed by the client's CLOCK_MONOTONIC stamp
+    QLocalServer server;
+    QLocalServer::removeServer(socketName);
+    if (!server.listen(socketName)) {
+        qCritical() << "Failed to start socket server on" << socketName;
+        return 1;
+    }
+
+    QObject::connect(&server, &QLocalServer::newConnection, [&]() {
+        while (QLocalSocket* client = server.nextPendingConnection()) {
+            QObject::connect(client, &QLocalSocket::disconnected, client, &QObject::deleteLater);
+            QObject::connect(client, &QLocalSocket::readyRead, client, [client, &controller]() {
+                while (client->canReadLine()) {
+                    const QList<QByteArray> words = client->readLine().trimmed().split(' ');
+                    const QByteArray& command = words.first();
+                    bool stamped = false;
+                    const double execMs = words.size() > 1 ? words.at(1).toDouble(&stamped) : -1;
+                    if (command == "next")
+                        controller.step(1, stamped ? execMs : -1);
+                    else if (command == "prev")
+                        controller.step(-1, stamped ? execMs : -1);
+                    else if (command == "cancel")
+                        controller.cancel();
+                }
+            });
+        }
+    });
+
+    return app.exec();
+}
+
+#include "switch-server.moc"
@@ -0,0 +1,67 @@
+#include "appicons.h"
+
+#include <QDir>
+#include <QFile>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QStringList>
+
+static QString iconNameFromDesktopFile(const QString& appId)
+{
+    const QStringList desktopFileNames = {
+        appId + ".desktop",
+        appId.toLower() + ".desktop"
+    };
+
+    const QStringList desktopDirs = {
+        QStandardPaths::writableLocation(QStandardPaths::ApplicationsLocation),
+        "/usr/share/applications",
+        "/usr/local/share/applications"
+    };
+
+    for (const QString& dirPath : desktopDirs) {
+        for (const QString& fileName : desktopFileNames) {
+            QString filePath = QDir(dirPath).filePath(fileName);
+            if (!QFile::exists(filePath))
+                continue;
+
+            QSettings desktopFile(filePath, QSettings::IniFormat);
+            QString iconName = desktopFile.value("Desktop Entry/Icon").toString();
+            if (!iconName.isEmpty())
+                return iconName;
+        }
+    }
+
+    return appId;
+}
+
+QString iconForAppId(const QString& appId)
+{
+    if (appId.isEmpty())
+        return "";
+
+    const QString name = iconNameFromDesktopFile(appId);
+    if (QFile::exists(name))
+        return name;
+
+    const QStringList iconDirs = {
+        "/usr/share/icons/hicolor/256x256/apps/",
+        "/usr/share/icons/hicolor/128x128/apps/",
+        "/usr/share/icons/hicolor/64x64/apps/",
+        "/usr/share/icons/hicolor/48x48/apps/",
+        "/usr/share/icons/hicolor/scalable/apps/",
+        "/usr/share/pixmaps/",
+        "/usr/share/icons/breeze/apps/64/",
+        "/usr/share/icons/breeze/apps/48/",
+        QDir::homePath() + "/.local/share/icons/hicolor/256x256/apps/"
+    };
+
+    for (const QString& dir : iconDirs) {
+        if (QFile::exists(dir + name + ".png"))
+            return dir + name + ".png";
+        if (QFile::exists(dir + name + ".svg"))
+            return dir + name + ".svg";
+    }
+
+    return "";
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <QString>
+
+// Icon file for a toplevel's app_id: the Icon= of its desktop file, looked up
+// in the same hicolor/pixmaps/breeze directories as the launcher. Returns an
+// empty string when nothing is found.
+QString iconForAppId(const QString& appId);
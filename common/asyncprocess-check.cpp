@@ -0,0 +1,94 @@
+// asyncprocess-check: runProcess() against real children.
+//
+//   asyncprocess-check
+//
+// Three children at once, with a 10 ms timer ticking on the same event loop:
+//
+//   slow      sleep 2; finishes normally, and the timer keeps ticking
+//             the whole time (at least 150 of the 200 ticks)
+//   timeout   sleep 10 with a 300 ms timeout; killed as TimedOut well
+//             before it would have finished
+//   cap       5 MB from /dev/zero with a 1 MiB cap; exactly 1 MiB kept,
+//             marked truncated, and the child still exits cleanly
+//
+// Prints one line per check; exits non-zero if any fails. Needs sleep and
+// head on PATH.
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <cstdio>
+
+#include "asyncprocess.h"
+
+static const char* statusName(ProcessResult::Status status)
+{
+    switch (status) {
+    case ProcessResult::Finished:
+        return "finished";
+    case ProcessResult::FailedToStart:
+        return "failed to start";
+    case ProcessResult::Crashed:
+        return "crashed";
+    case ProcessResult::TimedOut:
+        return "timed out";
+    case ProcessResult::Canceled:
+        return "canceled";
+    }
+    return "?";
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QElapsedTimer clock;
+    clock.start();
+
+    int ticks = 0;
+    QTimer ticker;
+    QObject::connect(&ticker, &QTimer::timeout, &app, [&]() { ++ticks; });
+    ticker.start(10);
+
+    int failed = 0;
+    int pending = 3;
+    auto check = [&](const char* name, bool ok, const QByteArray& detail) {
+        std::printf("%-8s %s  %s\n", name, ok ? "ok  " : "FAIL", detail.constData());
+        if (!ok)
+            ++failed;
+        if (--pending == 0)
+            app.quit();
+    };
+
+    runProcess("sleep", { "2" }).then(&app, [&](const ProcessResult& result) {
+        const qint64 ms = clock.elapsed();
+        const bool ok = result.ok() && ticks >= 150;
+        check("slow", ok, QString("%1 after %2 ms, %3 timer ticks meanwhile")
+                              .arg(statusName(result.status)).arg(ms).arg(ticks).toUtf8());
+    });
+
+    ProcessOptions shortTimeout;
+    shortTimeout.timeoutMs = 300;
+    runProcess("sleep", { "10" }, shortTimeout).then(&app, [&](const ProcessResult& result) {
+        const qint64 ms = clock.elapsed();
+        const bool ok = result.status == ProcessResult::TimedOut && ms < 2000;
+        check("timeout", ok, QString("%1 after %2 ms").arg(statusName(result.status)).arg(ms).toUtf8());
+    });
+
+    ProcessOptions smallCap;
+    smallCap.maxOutputBytes = 1 << 20;
+    runProcess("head", { "-c", "5000000", "/dev/zero" }, smallCap).then(&app, [&](const ProcessResult& result) {
+        const bool ok = result.ok() && result.truncated && result.standardOutput.size() == smallCap.maxOutputBytes;
+        check("cap", ok, QString("%1, kept %2 bytes%3").arg(statusName(result.status))
+                             .arg(result.standardOutput.size()).arg(result.truncated ? ", truncated" : "").toUtf8());
+    });
+
+    QTimer::singleShot(15000, &app, [&]() {
+        std::printf("gave up: %d checks never finished\n", pending);
+        failed += pending;
+        app.quit();
+    });
+    app.exec();
+
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,107 @@
+#include "asyncprocess.h"
+
+#include <QFutureWatcher>
+#include <QProcess>
+#include <QPromise>
+#include <QTimer>
+
+namespace {
+
+// Lives from start to the child's exit, then deletes itself
+class ProcessJob : public QObject
+{
+public:
+    explicit ProcessJob(const ProcessOptions& options)
+    : m_options(options)
+    {
+        m_process.setStandardInputFile(QProcess::nullDevice());
+
+        connect(&m_process, &QProcess::readyReadStandardOutput, this, [this]() {
+            append(m_result.standardOutput, m_process.readAllStandardOutput());
+        });
+        connect(&m_process, &QProcess::readyReadStandardError, this, [this]() {
+            append(m_result.standardError, m_process.readAllStandardError());
+        });
+        connect(&m_process, &QProcess::finished, this, [this](int exitCode, QProcess::ExitStatus exitStatus) {
+            append(m_result.standardOutput, m_process.readAllStandardOutput());
+            append(m_result.standardError, m_process.readAllStandardError());
+            // A kill of ours already set TimedOut or Canceled
+            if (m_result.status == ProcessResult::FailedToStart) {
+                m_result.status = exitStatus == QProcess::NormalExit ? ProcessResult::Finished : ProcessResult::Crashed;
+                m_result.exitCode = exitCode;
+            }
+            finish();
+        });
+        connect(&m_process, &QProcess::errorOccurred, this, [this](QProcess::ProcessError error) {
+            // Other errors are followed by finished()
+            if (error == QProcess::FailedToStart)
+                finish();
+        });
+
+        m_timeout.setSingleShot(true);
+        connect(&m_timeout, &QTimer::timeout, this, [this]() { kill(ProcessResult::TimedOut); });
+
+        connect(&m_watcher, &QFutureWatcher<ProcessResult>::canceled, this, [this]() { kill(ProcessResult::Canceled); });
+    }
+
+    QFuture<ProcessResult> start(const QString& program, const QStringList& arguments)
+    {
+        QFuture<ProcessResult> future = m_promise.future();
+        m_promise.start();
+        m_watcher.setFuture(future);
+
+        m_process.start(program, arguments);
+        // FailedToStart may already have finished the job inside start()
+        if (m_options.timeoutMs > 0 && !m_finished)
+            m_timeout.start(m_options.timeoutMs);
+        return future;
+    }
+
+private:
+    void append(QByteArray& buffer, const QByteArray& data)
+    {
+        const qint64 room = m_options.maxOutputBytes - buffer.size();
+        if (data.size() > room) {
+            m_result.truncated = true;
+            buffer.append(data.left(qMax<qint64>(room, 0)));
+        } else {
+            buffer.append(data);
+        }
+    }
+
+    void kill(ProcessResult::Status status)
+    {
+        if (m_finished || m_process.state() == QProcess::NotRunning)
+            return;
+        m_result.status = status;
+        m_process.kill(); // finished() follows
+    }
+
+    void finish()
+    {
+        if (m_finished)
+            return;
+        m_finished = true;
+        m_timeout.stop();
+
+        m_promise.addResult(m_result);
+        m_promise.finish();
+        deleteLater();
+    }
+
+    ProcessOptions m_options;
+    QProcess m_process { this };
+    QPromise<ProcessResult> m_promise;
+    QFutureWatcher<ProcessResult> m_watcher;
+    QTimer m_timeout;
+    ProcessResult m_result;
+    bool m_finished = false;
+};
+
+} // namespace
+
+QFuture<ProcessResult> runProcess(const QString& program, const QStringList& arguments, const ProcessOptions& options)
+{
+    auto* job = new ProcessJob(options);
+    return job->start(program, arguments);
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <QByteArray>
+#include <QFuture>
+#include <QString>
+#include <QStringList>
+
+struct ProcessResult {
+    enum Status {
+        Finished,
+        FailedToStart,
+        Crashed,
+        TimedOut,
+        Canceled
+    };
+
+    Status status = FailedToStart;
+    int exitCode = -1;
+    QByteArray standardOutput;
+    QByteArray standardError;
+    bool truncated = false; // output went past maxOutputBytes
+
+    bool ok() const { return status == Finished && exitCode == 0; }
+};
+
+struct ProcessOptions {
+    int timeoutMs = 30000; // the child is killed after this; 0 waits forever
+    qint64 maxOutputBytes = 1 << 20; // per channel; the rest is read and dropped
+};
+
+// Starts `program` without waiting for it; the returned future finishes with
+// its result. stdin is /dev/null. Continue with
+// future.then(context, [](const ProcessResult& result) { ... }), which runs on
+// the context's thread. future.cancel() kills the child, and continuations
+// are skipped.
+//
+// Call from a thread with an event loop. Nothing here blocks, so a slow child
+// never holds up a frame.
+QFuture<ProcessResult> runProcess(const QString& program, const QStringList& arguments,
+    const ProcessOptions& options = {});
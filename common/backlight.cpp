@@ -0,0 +1,131 @@
+#include "backlight.h"
+
+#include "sysfs.h"
+
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSettings>
+#include <QStandardPaths>
+#include <algorithm>
+#include <cmath>
+
+static QString backlightDir()
+{
+    return sysfsRoot() + "/class/backlight/";
+}
+
+static int readInt(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return -1;
+    bool ok = false;
+    const int value = file.readAll().trimmed().toInt(&ok);
+    return ok ? value : -1;
+}
+
+QStringList Backlight::devices()
+{
+    // Backlights come with the GPU driver and stay; one look is enough
+    static const QStringList devices = QDir(backlightDir()).entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name);
+    return devices;
+}
+
+Backlight Backlight::forOutput(const QString& output)
+{
+    const QStringList all = devices();
+    if (all.isEmpty())
+        return Backlight();
+
+    if (!output.isEmpty()) {
+        const QString configPath = QDir(QStandardPaths::writableLocation(QStandardPaths::ConfigLocation)).filePath("hexlauncher/apps.ini");
+        QSettings settings(configPath, QSettings::IniFormat);
+        const QString configured = settings.value("Backlight/" + output).toString();
+        if (all.contains(configured))
+            return Backlight(configured);
+
+        // Native backlights hang off their connector: .../card1-eDP-1/intel_backlight
+        for (const QString& device : all) {
+            const QString connector = QFileInfo(QFileInfo(backlightDir() + device).canonicalFilePath()).dir().dirName();
+            if (connector.endsWith("-" + output))
+                return Backlight(device);
+        }
+    }
+
+    return Backlight(all.first());
+}
+
+Backlight::Backlight(const QString& device)
+: m_device(device)
+{
+    if (device.isEmpty())
+        return;
+    m_path = backlightDir() + device;
+    m_maxBrightness = std::max(0, readInt(m_path + "/max_brightness"));
+}
+
+int Backlight::brightness() const
+{
+    return isValid() ? readInt(m_path + "/brightness") : -1;
+}
+
+int Backlight::percent() const
+{
+    return percentOf(brightness());
+}
+
+int Backlight::percentOf(int value) const
+{
+    return value < 0 || !isValid() ? -1 : int(std::lround(100.0 * value / m_maxBrightness));
+}
+
+int Backlight::adjust(int deltaPercent, int value)
+{
+    if (value < 0)
+        value = brightness();
+    if (value < 0)
+        return -1;
+
+    // Same stepping as AlsaMixer::adjust()
+    const double steps = m_maxBrightness * deltaPercent / 100.0;
+    int delta = int(deltaPercent > 0 ? std::ceil(steps) : std::floor(steps));
+    if (delta == 0 && deltaPercent != 0)
+        delta = deltaPercent > 0 ? 1 : -1;
+    const int target = std::clamp(value + delta, std::min(1, m_maxBrightness), m_maxBrightness);
+
+    if (m_sysfsWritable && writeSysfs(target))
+        return target;
+
+    m_sysfsWritable = false;
+    return writeLogind(target) ? target : -1;
+}
+
+bool Backlight::writeSysfs(int value)
+{
+    QFile file(m_path + "/brightness");
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    return file.write(QByteArray::number(value)) > 0 && file.flush();
+}
+
+bool Backlight::writeLogind(int value)
+{
+    // A fake tree has no logind behind it
+    if (qEnvironmentVariableIsSet("HEX_SYSFS_ROOT"))
+        return false;
+
+    QDBusMessage call = QDBusMessage::createMethodCall("org.freedesktop.login1", "/org/freedesktop/login1/session/auto",
+        "org.freedesktop.login1.Session", "SetBrightness");
+    call << QString("backlight") << m_device << quint32(value);
+
+    const QDBusMessage reply = QDBusConnection::systemBus().call(call, QDBus::Block, 1000);
+    if (reply.type() == QDBusMessage::ErrorMessage) {
+        qWarning() << "[WARN] logind SetBrightness failed:" << reply.errorMessage();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+
+// One device under /sys/class/backlight, driven directly instead of through
+// brightnessctl. The device list is read once per process and
+// max_brightness once per device; reads and writes go to the brightness
+// file. When that file is not writable (no udev rule for the user), writes
+// go through logind's Session.SetBrightness on the system bus instead.
+//
+// With HEX_SYSFS_ROOT set (see sysfs.h) everything happens in that tree and
+// logind is left alone, so a fake tree is enough to drive it.
+class Backlight
+{
+public:
+    // Names under /sys/class/backlight, sorted
+    static QStringList devices();
+
+    // The device lighting `output` (a connector such as "eDP-1"). In order:
+    // the [Backlight] group of apps.ini (output=device), the device sitting
+    // under that connector in sysfs, then the first device by name, which is
+    // what brightnessctl picks. An empty output skips straight to the last.
+    static Backlight forOutput(const QString& output = QString());
+
+    explicit Backlight(const QString& device = QString());
+
+    bool isValid() const { return m_maxBrightness > 0; }
+    QString device() const { return m_device; }
+    QString path() const { return m_path; }
+    int maxBrightness() const { return m_maxBrightness; }
+
+    int brightness() const; // -1 when unreadable
+    int percent() const;
+    int percentOf(int value) const;
+
+    // Moves the level by deltaPercent of the range, starting from `value`
+    // (read from sysfs when -1), and never below 1 so the panel stays lit.
+    // Stepped in raw levels, rounded away from the start and at least one
+    // level per call: on a panel with max_brightness 7, 5% is a third of a
+    // level. Writes and returns the new level; -1 if it could not be read
+    // or neither sysfs nor logind took it.
+    int adjust(int deltaPercent, int value = -1);
+
+private:
+    bool writeSysfs(int value);
+    bool writeLogind(int value);
+
+    QString m_device;
+    QString m_path;
+    int m_maxBrightness = 0;
+    bool m_sysfsWritable = true; // until a write says otherwise
+};
@@ -0,0 +1,149 @@
+// battery-check: BatteryMonitor against a fake sysfs tree.
+//
+//   battery-check
+//
+// Builds a throwaway tree under HEX_SYSFS_ROOT with an AC adapter and BAT0
+// at 80% Discharging, sets the re-read period to 300 ms, and then:
+//
+//   initial   80 Discharging is read at construction
+//   write     status rewritten to Charging is picked up at once (watcher)
+//   silent    capacity changed to 79 through mmap, which inotify does not
+//             report, like firmware that sends no uevent as the charge
+//             drops: only the periodic re-read can pick it up
+//   remove    BAT0 renamed away: Unavailable
+//   add       BAT1 appears: found and read
+//
+// Prints one line per check; exits non-zero if any fails or one takes more
+// than 2 s.
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTimer>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <functional>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <vector>
+
+#include "batterymonitor.h"
+
+static bool writeFile(const QString& path, const QByteArray& contents)
+{
+    QFile file(path);
+    return file.open(QIODevice::WriteOnly) && file.write(contents) == contents.size();
+}
+
+// Overwrites the start of the file in place without write(2), so no
+// inotify event is generated
+static bool writeSilently(const QString& path, const QByteArray& contents)
+{
+    const int fd = open(QFile::encodeName(path).constData(), O_RDWR | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+    void* map = mmap(nullptr, contents.size(), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return false;
+    memcpy(map, contents.constData(), contents.size());
+    munmap(map, contents.size());
+    return true;
+}
+
+static bool makeBattery(const QString& dir, const QByteArray& capacity, const QByteArray& status)
+{
+    return QDir().mkpath(dir) && writeFile(dir + "/type", "Battery\n") && writeFile(dir + "/capacity", capacity)
+        && writeFile(dir + "/status", status);
+}
+
+struct Step
+{
+    const char* name;
+    std::function<bool()> action;
+    int percentage;
+    QString status;
+};
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QTemporaryDir sysfs;
+    const QString supplies = sysfs.path() + "/class/power_supply";
+    if (!sysfs.isValid() || !QDir().mkpath(supplies + "/AC") || !writeFile(supplies + "/AC/type", "Mains\n")
+        || !makeBattery(supplies + "/BAT0", "80\n", "Discharging\n")) {
+        std::printf("cannot build a fake sysfs tree\n");
+        return 1;
+    }
+    qputenv("HEX_SYSFS_ROOT", sysfs.path().toUtf8());
+
+    const std::vector<Step> steps = {
+        { "initial", nullptr, 80, "Discharging" },
+        { "write", [&]() { return writeFile(supplies + "/BAT0/status", "Charging\n"); }, 80, "Charging" },
+        { "silent", [&]() { return writeSilently(supplies + "/BAT0/capacity", "79\n"); }, 79, "Charging" },
+        { "remove", [&]() { return QDir().rename(supplies + "/BAT0", sysfs.path() + "/BAT0.gone"); }, -1,
+            "Unavailable" },
+        { "add", [&]() { return makeBattery(supplies + "/BAT1", "55\n", "Full\n"); }, 55, "Full" },
+    };
+
+    BatteryMonitor monitor;
+    monitor.setPollInterval(300);
+
+    int failed = 0;
+    auto check = [&](const char* name, bool ok, const QByteArray& detail) {
+        std::printf("%-8s %s  %s\n", name, ok ? "ok  " : "FAIL", detail.constData());
+        if (!ok)
+            ++failed;
+    };
+
+    size_t current = 0;
+    QElapsedTimer clock;
+    QTimer deadline;
+    deadline.setSingleShot(true);
+    deadline.setInterval(2000);
+
+    std::function<void()> start;
+    auto settle = [&](bool timedOut) {
+        const Step& step = steps[current];
+        const bool ok = monitor.percentage() == step.percentage && monitor.status() == step.status;
+        if (!ok && !timedOut)
+            return;
+
+        deadline.stop();
+        check(step.name, ok,
+            QString("%1 %2 after %3 ms").arg(monitor.percentage()).arg(monitor.status()).arg(clock.elapsed()).toUtf8());
+        // Events from this step's change may still be queued; let them
+        // arrive before the next, so "silent" sees the re-read and not them
+        if (++current < steps.size())
+            QTimer::singleShot(100, &app, start);
+        else
+            app.quit();
+    };
+
+    start = [&]() {
+        const Step& step = steps[current];
+        if (step.action && !step.action()) {
+            check(step.name, false, "cannot change the fake tree");
+            app.exit(1);
+            return;
+        }
+        clock.start();
+        deadline.start();
+        settle(false);
+    };
+
+    QObject::connect(&monitor, &BatteryMonitor::changed, &app, [&]() {
+        if (deadline.isActive())
+            settle(false);
+    });
+    QObject::connect(&deadline, &QTimer::timeout, &app, [&]() { settle(true); });
+
+    QTimer::singleShot(0, &app, start);
+    app.exec();
+
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,196 @@
+#include "batterymonitor.h"
+#include "sysfs.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFileSystemWatcher>
+#include <QSocketNotifier>
+#include <QTimer>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/netlink.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static QByteArray preadAll(int fd)
+{
+    char buffer[128];
+    ssize_t n;
+    while ((n = pread(fd, buffer, sizeof(buffer), 0)) < 0 && errno == EINTR) { }
+    return n > 0 ? QByteArray(buffer, n).trimmed() : QByteArray();
+}
+
+BatteryMonitor::BatteryMonitor(QObject* parent)
+: QObject(parent)
+{
+    if (qEnvironmentVariableIsSet("HEX_SYSFS_ROOT")) {
+        // Fake tree: no kernel behind it, so watch the files themselves
+        m_watcher = new QFileSystemWatcher(this);
+        auto reload = [this]() {
+            discover();
+            refresh();
+        };
+        connect(m_watcher, &QFileSystemWatcher::fileChanged, this, reload);
+        connect(m_watcher, &QFileSystemWatcher::directoryChanged, this, reload);
+    } else {
+        // Kernel uevents (group 1) need no privileges to receive
+        m_ueventFd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, NETLINK_KOBJECT_UEVENT);
+        sockaddr_nl addr = {};
+        addr.nl_family = AF_NETLINK;
+        addr.nl_groups = 1;
+        if (m_ueventFd >= 0 && bind(m_ueventFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) {
+            m_ueventNotifier = new QSocketNotifier(m_ueventFd, QSocketNotifier::Read, this);
+            connect(m_ueventNotifier, &QSocketNotifier::activated, this, &BatteryMonitor::readUevents);
+        } else {
+            qWarning() << "[WARN] no uevent socket, battery will not update:" << strerror(errno);
+        }
+    }
+
+    m_poll = new QTimer(this);
+    m_poll->setTimerType(Qt::VeryCoarseTimer);
+    connect(m_poll, &QTimer::timeout, this, &BatteryMonitor::refresh);
+    setPollInterval(60 * 1000);
+
+    discover();
+    refresh();
+}
+
+BatteryMonitor::~BatteryMonitor()
+{
+    closeFiles();
+    if (m_ueventFd >= 0)
+        close(m_ueventFd);
+}
+
+void BatteryMonitor::closeFiles()
+{
+    if (m_capacityFd >= 0)
+        close(m_capacityFd);
+    if (m_statusFd >= 0)
+        close(m_statusFd);
+    m_capacityFd = -1;
+    m_statusFd = -1;
+}
+
+// Finds the first battery and opens its attributes. Only repeated when a
+// power supply comes or goes (or, on a fake tree, when files change).
+void BatteryMonitor::discover()
+{
+    closeFiles();
+    m_batteryDir.clear();
+
+    const QString basePath = sysfsRoot() + "/class/power_supply/";
+    QDir powerDir(basePath);
+    const QStringList entries = powerDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name);
+    for (const QString& entry : entries) {
+        QFile typeFile(basePath + entry + "/type");
+        const bool isBattery = typeFile.open(QIODevice::ReadOnly) ? typeFile.readAll().trimmed() == "Battery"
+                                                                  : entry.startsWith("BAT");
+        if (isBattery) {
+            m_batteryDir = basePath + entry;
+            break;
+        }
+    }
+
+    if (m_watcher) {
+        if (!m_watcher->files().isEmpty())
+            m_watcher->removePaths(m_watcher->files());
+        if (!m_watcher->directories().isEmpty())
+            m_watcher->removePaths(m_watcher->directories());
+        m_watcher->addPath(basePath);
+    }
+
+    if (m_batteryDir.isEmpty())
+        return;
+
+    m_capacityFd = open(QFile::encodeName(m_batteryDir + "/capacity").constData(), O_RDONLY | O_CLOEXEC);
+    m_statusFd = open(QFile::encodeName(m_batteryDir + "/status").constData(), O_RDONLY | O_CLOEXEC);
+
+    if (m_watcher) {
+        // Directory too: scripts that replace a file by rename show up there
+        m_watcher->addPaths({ m_batteryDir, m_batteryDir + "/capacity", m_batteryDir + "/status" });
+    }
+}
+
+void BatteryMonitor::setPollInterval(int ms)
+{
+    if (ms > 0)
+        m_poll->start(ms);
+    else
+        m_poll->stop();
+}
+
+void BatteryMonitor::refresh()
+{
+    if (m_batteryDir.isEmpty()) {
+        setState(-1, "Unavailable");
+        return;
+    }
+
+    if (m_capacityFd < 0 || m_statusFd < 0) {
+        setState(-1, "Unknown");
+        return;
+    }
+
+    bool ok = false;
+    const int percent = preadAll(m_capacityFd).toInt(&ok);
+    const QByteArray status = preadAll(m_statusFd);
+    if (!ok || status.isEmpty())
+        setState(-1, "Unknown");
+    else
+        setState(percent, QString::fromUtf8(status));
+}
+
+void BatteryMonitor::setState(int percentage, const QString& status)
+{
+    if (percentage == m_percentage && status == m_status)
+        return;
+
+    m_percentage = percentage;
+    m_status = status;
+    emit changed();
+}
+
+// Messages look like "change@/devices/.../power_supply/BAT0\0ACTION=change\0
+// SUBSYSTEM=power_supply\0...". Anything from power_supply (the AC adapter
+// included) may change what the battery reports.
+void BatteryMonitor::readUevents()
+{
+    bool powerSupplyChanged = false;
+    bool rediscover = false;
+
+    char buffer[8192];
+    ssize_t n;
+    while ((n = recv(m_ueventFd, buffer, sizeof(buffer) - 1, MSG_DONTWAIT)) > 0 || (n < 0 && errno == EINTR)) {
+        if (n <= 0)
+            continue;
+        buffer[n] = '\0';
+
+        bool powerSupply = false;
+        QByteArray action;
+        for (const char* field = buffer; field < buffer + n; field += strlen(field) + 1) {
+            if (strcmp(field, "SUBSYSTEM=power_supply") == 0)
+                powerSupply = true;
+            else if (strncmp(field, "ACTION=", 7) == 0)
+                action = field + 7;
+        }
+        if (!powerSupply)
+            continue;
+
+        powerSupplyChanged = true;
+        if (action == "add" || action == "remove")
+            rediscover = true;
+    }
+
+    // ENOBUFS means events were dropped; re-read to be safe
+    if (n < 0 && errno == ENOBUFS) {
+        powerSupplyChanged = true;
+        rediscover = true;
+    }
+
+    if (rediscover)
+        discover();
+    if (powerSupplyChanged)
+        refresh();
+}
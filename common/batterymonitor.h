@@ -0,0 +1,59 @@
+#pragma once
+
+#include <QObject>
+#include <QString>
+
+class QFileSystemWatcher;
+class QSocketNotifier;
+class QTimer;
+
+// Battery charge and status from sysfs, pushed rather than polled.
+//
+// The battery is looked up once and its capacity/status files stay open;
+// they are re-read with pread() whenever the kernel announces a
+// power_supply uevent on the kobject-uevent netlink socket. Under
+// HEX_SYSFS_ROOT (a fake tree, see sysfs.h) no uevents come, so the files
+// are watched with QFileSystemWatcher instead and re-opened on change, which
+// lets a test script rewrite or replace them.
+//
+// Many ACPI firmwares send a uevent when the adapter or status changes but
+// not as the charge drops, so the files are also re-read once a minute on a
+// very coarse timer, which the kernel can fold into other wakeups.
+class BatteryMonitor : public QObject
+{
+    Q_OBJECT
+public:
+    explicit BatteryMonitor(QObject* parent = nullptr);
+    ~BatteryMonitor() override;
+
+    // 0-100, or -1 without a readable battery
+    int percentage() const { return m_percentage; }
+    // sysfs status ("Charging", "Discharging", "Full", ...), "Unavailable"
+    // without a battery, "Unknown" if it cannot be read
+    QString status() const { return m_status; }
+
+    void refresh();
+
+    // Period of the re-read above; 0 turns it off
+    void setPollInterval(int ms);
+
+signals:
+    void changed();
+
+private:
+    void discover();
+    void closeFiles();
+    void readUevents();
+    void setState(int percentage, const QString& status);
+
+    QString m_batteryDir;
+    int m_capacityFd = -1;
+    int m_statusFd = -1;
+    int m_ueventFd = -1;
+    QSocketNotifier* m_ueventNotifier = nullptr;
+    QFileSystemWatcher* m_watcher = nullptr;
+    QTimer* m_poll = nullptr;
+
+    int m_percentage = -1;
+    QString m_status = "Unknown";
+};
@@ -0,0 +1,258 @@
+#include "clockservice.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QSocketNotifier>
+#include <cerrno>
+#include <cstring>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+// ----------------- ClockService -----------------
+ClockService* ClockService::instance()
+{
+    // Owned by the application so its notifier goes before the event loop does
+    static ClockService* service = new ClockService(QCoreApplication::instance());
+    return service;
+}
+
+ClockService::ClockService(QObject* parent)
+: QObject(parent)
+{
+    m_timerFd = timerfd_create(CLOCK_REALTIME, TFD_CLOEXEC | TFD_NONBLOCK);
+    if (m_timerFd < 0) {
+        qWarning() << "[WARN] no timerfd, clocks will not tick:" << strerror(errno);
+        return;
+    }
+
+    m_notifier = new QSocketNotifier(m_timerFd, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &ClockService::expired);
+}
+
+ClockService::~ClockService()
+{
+    if (m_timerFd >= 0)
+        close(m_timerFd);
+}
+
+void ClockService::addClient(bool seconds)
+{
+    ++m_clients;
+    if (seconds)
+        ++m_secondsClients;
+
+    // The first client, or the first that needs seconds, moves the deadline in
+    if (m_clients == 1 || (seconds && m_secondsClients == 1))
+        arm();
+}
+
+void ClockService::removeClient(bool seconds)
+{
+    --m_clients;
+    if (seconds)
+        --m_secondsClients;
+
+    // Left as is when only seconds went away: the pending tick re-arms for the
+    // minute, one spare wakeup at most
+    if (m_clients == 0)
+        arm();
+}
+
+void ClockService::arm()
+{
+    if (m_timerFd < 0)
+        return;
+
+    itimerspec spec = {};
+    if (m_clients > 0) {
+        timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        spec.it_value.tv_sec = m_secondsClients > 0 ? now.tv_sec + 1 : (now.tv_sec / 60 + 1) * 60;
+    }
+
+    // An all-zero value disarms
+    if (timerfd_settime(m_timerFd, TFD_TIMER_ABSTIME | TFD_TIMER_CANCEL_ON_SET, &spec, nullptr) < 0)
+        qWarning() << "[WARN] cannot arm the clock timer:" << strerror(errno);
+}
+
+void ClockService::expired()
+{
+    // ECANCELED: the wall clock was set, the old deadline means nothing now
+    quint64 expirations;
+    if (read(m_timerFd, &expirations, sizeof(expirations)) < 0 && errno != ECANCELED)
+        return;
+
+    arm();
+    emit tick();
+}
+
+// ----------------- WorldClock -----------------
+namespace {
+
+struct City {
+    const char* name;
+    const char* zone;
+};
+
+// The widget's city list; an empty zone means the system zone
+constexpr City kCities[] = {
+    { "Local", "" }, { "UTC", "UTC" }, { "Abu Dhabi", "Asia/Dubai" }, { "Accra", "Africa/Accra" },
+    { "Almaty", "Asia/Almaty" }, { "Amsterdam", "Europe/Amsterdam" }, { "Anadyr", "Asia/Anadyr" },
+    { "Athens", "Europe/Athens" }, { "Baghdad", "Asia/Baghdad" }, { "Bangkok", "Asia/Bangkok" },
+    { "Beijing", "Asia/Shanghai" }, { "Belgrade", "Europe/Belgrade" }, { "Berlin", "Europe/Berlin" },
+    { "Bogota", "America/Bogota" }, { "Bucharest", "Europe/Bucharest" },
+    { "Buenos Aires", "America/Argentina/Buenos_Aires" }, { "Budapest", "Europe/Budapest" },
+    { "Caracas", "America/Caracas" }, { "Chennai", "Asia/Kolkata" }, { "Chongqing", "Asia/Shanghai" },
+    { "Colombo", "Asia/Colombo" }, { "Damascus", "Asia/Damascus" }, { "Dhaka", "Asia/Dhaka" },
+    { "Dili", "Asia/Dili" }, { "Dubai", "Asia/Dubai" }, { "Dublin", "Europe/Dublin" },
+    { "Edinburgh", "Europe/London" }, { "Guatemala City", "America/Guatemala" },
+    { "Hanoi", "Asia/Ho_Chi_Minh" }, { "Hong Kong", "Asia/Hong_Kong" }, { "Istanbul", "Europe/Istanbul" },
+    { "Jakarta", "Asia/Jakarta" }, { "Karachi", "Asia/Karachi" }, { "Kathmandu", "Asia/Kathmandu" },
+    { "Kiev", "Europe/Kiev" }, { "Kolkata", "Asia/Kolkata" }, { "Krasnoyarsk", "Asia/Krasnoyarsk" },
+    { "Kuala Lumpur", "Asia/Kuala_Lumpur" }, { "Kuwait City", "Asia/Kuwait" }, { "Lima", "America/Lima" },
+    { "Lisbon", "Europe/Lisbon" }, { "London", "Europe/London" }, { "Los Angeles", "America/Los_Angeles" },
+    { "Madrid", "Europe/Madrid" }, { "Managua", "America/Managua" }, { "Manila", "Asia/Manila" },
+    { "Mexico City", "America/Mexico_City" }, { "Minsk", "Europe/Minsk" },
+    { "Montevideo", "America/Montevideo" }, { "Moscow", "Europe/Moscow" }, { "Mumbai", "Asia/Kolkata" },
+    { "Muscat", "Asia/Muscat" }, { "Nairobi", "Africa/Nairobi" }, { "New Delhi", "Asia/Kolkata" },
+    { "New York", "America/New_York" }, { "Novosibirsk", "Asia/Novosibirsk" }, { "Osaka", "Asia/Tokyo" },
+    { "Oslo", "Europe/Oslo" }, { "Paris", "Europe/Paris" }, { "Perth", "Australia/Perth" },
+    { "Port Moresby", "Pacific/Port_Moresby" }, { "Praia", "Atlantic/Cape_Verde" },
+    { "Reykjavik", "Atlantic/Reykjavik" }, { "Riyadh", "Asia/Riyadh" }, { "Rome", "Europe/Rome" },
+    { "Sapporo", "Asia/Tokyo" }, { "Santiago", "America/Santiago" }, { "Sao Paulo", "America/Sao_Paulo" },
+    { "Seoul", "Asia/Seoul" }, { "Singapore", "Asia/Singapore" },
+    { "Sri Jayawardenepura", "Asia/Colombo" }, { "Stockholm", "Europe/Stockholm" },
+    { "Sydney", "Australia/Sydney" }, { "Taipei", "Asia/Taipei" }, { "Tehran", "Asia/Tehran" },
+    { "Tokyo", "Asia/Tokyo" }, { "Vladivostok", "Asia/Vladivostok" }, { "Warsaw", "Europe/Warsaw" },
+    { "Zurich", "Europe/Zurich" },
+};
+
+} // namespace
+
+WorldClock::WorldClock(QObject* parent)
+: QObject(parent)
+{
+    connect(ClockService::instance(), &ClockService::tick, this, &WorldClock::update);
+    setRegistered(true);
+    update();
+}
+
+WorldClock::~WorldClock()
+{
+    setRegistered(false);
+}
+
+QStringList WorldClock::cities()
+{
+    QStringList names;
+    for (const City& city : kCities)
+        names.append(QString::fromLatin1(city.name));
+    return names;
+}
+
+void WorldClock::setCity(const QString& city)
+{
+    if (city == m_city)
+        return;
+
+    for (const City& entry : kCities) {
+        if (city == QLatin1String(entry.name)) {
+            m_city = city;
+            emit cityChanged();
+            setTimeZone(QString::fromLatin1(entry.zone));
+            return;
+        }
+    }
+    qWarning() << "[WARN] unknown clock city" << city;
+}
+
+void WorldClock::setTimeZone(const QString& id)
+{
+    const QTimeZone zone = id.isEmpty() ? QTimeZone() : QTimeZone(id.toUtf8());
+    if (!id.isEmpty() && !zone.isValid())
+        qWarning() << "[WARN] unknown time zone" << id << "- using local time";
+    if (zone == m_zone)
+        return;
+
+    m_zone = zone;
+    emit timeZoneChanged();
+    update();
+}
+
+void WorldClock::setActive(bool active)
+{
+    if (active == m_active)
+        return;
+
+    m_active = active;
+    setRegistered(active);
+    emit activeChanged();
+
+    // Catch up on what was missed while hidden
+    if (active)
+        update();
+}
+
+void WorldClock::setShowSeconds(bool showSeconds)
+{
+    if (showSeconds == m_showSeconds)
+        return;
+
+    setRegistered(false);
+    m_showSeconds = showSeconds;
+    setRegistered(m_active);
+    emit showSecondsChanged();
+    update();
+}
+
+void WorldClock::setDateFormat(const QString& format)
+{
+    if (format == m_dateFormat)
+        return;
+
+    m_dateFormat = format;
+    emit dateFormatChanged();
+    update();
+}
+
+void WorldClock::setRegistered(bool registered)
+{
+    if (registered == m_registered)
+        return;
+
+    m_registered = registered;
+    if (registered)
+        ClockService::instance()->addClient(m_showSeconds);
+    else
+        ClockService::instance()->removeClient(m_showSeconds);
+}
+
+void WorldClock::update()
+{
+    if (!m_active)
+        return;
+
+    QDateTime now = QDateTime::currentDateTime();
+    if (m_zone.isValid())
+        now = now.toTimeZone(m_zone);
+
+    const QString time = now.toString(m_showSeconds ? "hh:mm:ss" : "hh:mm");
+    if (time != m_time) {
+        m_time = time;
+        emit timeChanged();
+    }
+
+    const QString date = now.toString(m_dateFormat);
+    if (date != m_date) {
+        m_date = date;
+        emit dateChanged();
+    }
+
+    const int hour = now.time().hour();
+    const bool isDaytime = hour >= 6 && hour < 18;
+    if (isDaytime != m_isDaytime) {
+        m_isDaytime = isDaytime;
+        emit isDaytimeChanged();
+    }
+}
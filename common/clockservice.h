@@ -0,0 +1,110 @@
+#pragma once
+
+#include <QDateTime>
+#include <QObject>
+#include <QStringList>
+#include <QTimeZone>
+
+class QSocketNotifier;
+
+// One wall-clock tick for every clock in the process.
+//
+// A single CLOCK_REALTIME timerfd is armed, absolute, for the next second
+// boundary (or the next minute when no active clock shows seconds), so ticks
+// land on the boundary instead of drifting around it the way a 1000 ms
+// QTimer does. TFD_TIMER_CANCEL_ON_SET wakes it when the wall clock is set
+// (NTP step, manual change, resume), and the clocks are told right away.
+// Nothing is armed while no clock is active.
+class ClockService : public QObject
+{
+    Q_OBJECT
+public:
+    static ClockService* instance();
+    ~ClockService() override;
+
+    // Clocks register while active; `seconds` asks for per-second ticks
+    void addClient(bool seconds);
+    void removeClient(bool seconds);
+
+signals:
+    void tick();
+
+private:
+    explicit ClockService(QObject* parent);
+    void arm();
+    void expired();
+
+    int m_timerFd = -1;
+    QSocketNotifier* m_notifier = nullptr;
+    int m_clients = 0;
+    int m_secondsClients = 0;
+};
+
+// QML-facing clock for one place. time/date/isDaytime are formatted here and
+// only change when their text does, so a tick is a property update, no JS.
+//
+// `city` picks from a fixed list (`cities`, mapped to IANA zones); "Local"
+// follows the system zone. `timeZone` takes any IANA id directly.
+class WorldClock : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(QString city READ city WRITE setCity NOTIFY cityChanged)
+    Q_PROPERTY(QString timeZone READ timeZone WRITE setTimeZone NOTIFY timeZoneChanged)
+    Q_PROPERTY(QStringList cities READ cities CONSTANT)
+    Q_PROPERTY(bool active READ isActive WRITE setActive NOTIFY activeChanged)
+    Q_PROPERTY(bool showSeconds READ showSeconds WRITE setShowSeconds NOTIFY showSecondsChanged)
+    Q_PROPERTY(QString dateFormat READ dateFormat WRITE setDateFormat NOTIFY dateFormatChanged)
+    Q_PROPERTY(QString time READ time NOTIFY timeChanged)
+    Q_PROPERTY(QString date READ date NOTIFY dateChanged)
+    Q_PROPERTY(bool isDaytime READ isDaytime NOTIFY isDaytimeChanged)
+
+public:
+    explicit WorldClock(QObject* parent = nullptr);
+    ~WorldClock() override;
+
+    QString city() const { return m_city; }
+    void setCity(const QString& city);
+
+    QString timeZone() const { return m_zone.isValid() ? QString::fromUtf8(m_zone.id()) : QString(); }
+    void setTimeZone(const QString& id);
+
+    static QStringList cities();
+
+    bool isActive() const { return m_active; }
+    void setActive(bool active);
+
+    bool showSeconds() const { return m_showSeconds; }
+    void setShowSeconds(bool showSeconds);
+
+    QString dateFormat() const { return m_dateFormat; }
+    void setDateFormat(const QString& format);
+
+    QString time() const { return m_time; }
+    QString date() const { return m_date; }
+    bool isDaytime() const { return m_isDaytime; }
+
+signals:
+    void cityChanged();
+    void timeZoneChanged();
+    void activeChanged();
+    void showSecondsChanged();
+    void dateFormatChanged();
+    void timeChanged();
+    void dateChanged();
+    void isDaytimeChanged();
+
+private:
+    void update();
+    void setRegistered(bool registered);
+
+    QString m_city = "Local";
+    QTimeZone m_zone; // invalid: system zone
+    bool m_active = true;
+    bool m_showSeconds = true;
+    bool m_registered = false;
+    QString m_dateFormat = "ddd, MMM d";
+
+    QString m_time;
+    QString m_date;
+    bool m_isDaytime = true;
+};
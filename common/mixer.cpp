@@ -0,0 +1,340 @@
+#include "mixer.h"
+
+#include <QDebug>
+#include <QSocketNotifier>
+#include <alsa/asoundlib.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#ifdef HEX_HAVE_PULSE
+#include <pulse/pulseaudio.h>
+#endif
+
+MixerState Mixer::update(const MixerState& state)
+{
+    if (state != m_state) {
+        m_state = state;
+        emit changed();
+    }
+    return m_state;
+}
+
+namespace {
+
+// ----------------- ALSA -----------------
+class AlsaMixer : public Mixer
+{
+public:
+    explicit AlsaMixer(QObject* parent)
+    : Mixer(parent)
+    {
+        if (snd_mixer_open(&m_mixer, 0) < 0) {
+            m_mixer = nullptr;
+            return;
+        }
+
+        if (snd_mixer_attach(m_mixer, "default") < 0 || snd_mixer_selem_register(m_mixer, nullptr, nullptr) < 0
+            || snd_mixer_load(m_mixer) < 0) {
+            qWarning() << "[WARN] cannot open the ALSA mixer";
+            snd_mixer_close(m_mixer);
+            m_mixer = nullptr;
+            return;
+        }
+
+        snd_mixer_selem_id_t* sid;
+        snd_mixer_selem_id_alloca(&sid);
+        snd_mixer_selem_id_set_index(sid, 0);
+        snd_mixer_selem_id_set_name(sid, "Master");
+        m_element = snd_mixer_find_selem(m_mixer, sid);
+        if (!m_element)
+            qWarning() << "[WARN] no Master mixer element";
+
+        // Control events arrive on the mixer's poll descriptors
+        const int count = snd_mixer_poll_descriptors_count(m_mixer);
+        std::vector<pollfd> fds(qMax(count, 0));
+        snd_mixer_poll_descriptors(m_mixer, fds.data(), fds.size());
+        for (const pollfd& fd : fds) {
+            auto* notifier = new QSocketNotifier(fd.fd, QSocketNotifier::Read, this);
+            connect(notifier, &QSocketNotifier::activated, this, [this]() {
+                snd_mixer_handle_events(m_mixer);
+                read();
+            });
+        }
+
+        read();
+    }
+
+    ~AlsaMixer() override
+    {
+        if (m_mixer)
+            snd_mixer_close(m_mixer);
+    }
+
+    QString name() const override { return "alsa"; }
+
+    MixerState adjust(int deltaPercent) override
+    {
+        long min = 0, max = 0, value = 0;
+        if (!m_element || !range(min, max)
+            || snd_mixer_selem_get_playback_volume(m_element, SND_MIXER_SCHN_FRONT_LEFT, &value) < 0)
+            return state();
+
+        // Raw-linear percentages like amixer's "5%+", stepped from the raw
+        // value rather than the rounded percent. On a control with few steps
+        // (0..31 is common) 5% is under two steps, and rounding to nearest
+        // could land back on the current value, so round away from it and
+        // always move at least one step.
+        const double steps = (max - min) * deltaPercent / 100.0;
+        long delta = long(deltaPercent > 0 ? std::ceil(steps) : std::floor(steps));
+        if (delta == 0 && deltaPercent != 0)
+            delta = deltaPercent > 0 ? 1 : -1;
+        snd_mixer_selem_set_playback_volume_all(m_element, std::clamp(value + delta, min, max));
+        if (snd_mixer_selem_has_playback_switch(m_element))
+            snd_mixer_selem_set_playback_switch_all(m_element, 1);
+        return read();
+    }
+
+    MixerState toggleMute() override
+    {
+        if (!m_element || !snd_mixer_selem_has_playback_switch(m_element))
+            return state();
+
+        snd_mixer_selem_set_playback_switch_all(m_element, state().muted ? 1 : 0);
+        return read();
+    }
+
+private:
+    bool range(long& min, long& max) const
+    {
+        snd_mixer_selem_get_playback_volume_range(m_element, &min, &max);
+        return max > min;
+    }
+
+    MixerState read()
+    {
+        MixerState state;
+
+        long min = 0, max = 0, value = 0;
+        if (m_element && range(min, max)
+            && snd_mixer_selem_get_playback_volume(m_element, SND_MIXER_SCHN_FRONT_LEFT, &value) == 0) {
+            state.percent = int(std::lround(100.0 * (value - min) / (max - min))); // amixer's [N%]
+
+            int on = 1;
+            if (snd_mixer_selem_has_playback_switch(m_element)
+                && snd_mixer_selem_get_playback_switch(m_element, SND_MIXER_SCHN_FRONT_LEFT, &on) == 0)
+                state.muted = !on;
+        }
+
+        return update(state);
+    }
+
+    snd_mixer_t* m_mixer = nullptr;
+    snd_mixer_elem_t* m_element = nullptr;
+};
+
+#ifdef HEX_HAVE_PULSE
+// ----------------- PulseAudio / PipeWire -----------------
+// A threaded mainloop runs the protocol; calls here lock it and wait for
+// their operations, so each change is a couple of round trips on a socket
+// that is already connected.
+class PulseMixer : public Mixer
+{
+public:
+    explicit PulseMixer(QObject* parent)
+    : Mixer(parent)
+    {
+        m_loop = pa_threaded_mainloop_new();
+        m_context = pa_context_new(pa_threaded_mainloop_get_api(m_loop), "hex-shell");
+        pa_context_set_state_callback(m_context, &PulseMixer::signalLoop, this);
+        pa_context_set_subscribe_callback(m_context, &PulseMixer::subscribed, this);
+
+        pa_threaded_mainloop_lock(m_loop);
+        bool ok = pa_context_connect(m_context, nullptr, PA_CONTEXT_NOAUTOSPAWN, nullptr) >= 0
+            && pa_threaded_mainloop_start(m_loop) >= 0;
+        while (ok) {
+            const pa_context_state_t contextState = pa_context_get_state(m_context);
+            if (contextState == PA_CONTEXT_READY)
+                break;
+            if (!PA_CONTEXT_IS_GOOD(contextState))
+                ok = false;
+            else
+                pa_threaded_mainloop_wait(m_loop);
+        }
+        if (ok) {
+            m_connected = true;
+            wait(pa_context_subscribe(m_context, pa_subscription_mask_t(PA_SUBSCRIPTION_MASK_SINK | PA_SUBSCRIPTION_MASK_SERVER),
+                &PulseMixer::succeeded, this));
+            readLocked();
+        } else {
+            qWarning() << "[WARN] cannot connect to the pulse server:" << pa_strerror(pa_context_errno(m_context));
+        }
+        pa_threaded_mainloop_unlock(m_loop);
+    }
+
+    ~PulseMixer() override
+    {
+        pa_threaded_mainloop_stop(m_loop);
+        pa_context_disconnect(m_context);
+        pa_context_unref(m_context);
+        pa_threaded_mainloop_free(m_loop);
+    }
+
+    QString name() const override { return "pulse"; }
+
+    MixerState adjust(int deltaPercent) override
+    {
+        Locker lock(m_loop);
+        Sink sink = querySink();
+        if (!sink.found)
+            return state();
+
+        const int target = std::clamp(percentOf(sink.volume) + deltaPercent, 0, 100);
+        // Scaling keeps the balance between channels
+        pa_cvolume_scale(&sink.volume, pa_volume_t(std::lround(PA_VOLUME_NORM * target / 100.0)));
+
+        // Both requests go out before waiting on either
+        pa_operation* volume = pa_context_set_sink_volume_by_name(m_context, kSink, &sink.volume, &PulseMixer::succeeded, this);
+        pa_operation* mute = pa_context_set_sink_mute_by_name(m_context, kSink, 0, &PulseMixer::succeeded, this);
+        if (!wait(volume) || !wait(mute))
+            return state();
+        return update({ target, false });
+    }
+
+    MixerState toggleMute() override
+    {
+        Locker lock(m_loop);
+        Sink sink = querySink();
+        if (!sink.found)
+            return state();
+
+        if (!wait(pa_context_set_sink_mute_by_name(m_context, kSink, !sink.muted, &PulseMixer::succeeded, this)))
+            return state();
+        return update({ percentOf(sink.volume), !sink.muted });
+    }
+
+private:
+    static constexpr const char* kSink = "@DEFAULT_SINK@";
+
+    struct Locker {
+        explicit Locker(pa_threaded_mainloop* loop)
+        : loop(loop)
+        {
+            pa_threaded_mainloop_lock(loop);
+        }
+        ~Locker() { pa_threaded_mainloop_unlock(loop); }
+        pa_threaded_mainloop* loop;
+    };
+
+    struct Sink {
+        PulseMixer* self = nullptr;
+        pa_cvolume volume {};
+        bool muted = false;
+        bool found = false;
+    };
+
+    static int percentOf(const pa_cvolume& volume)
+    {
+        return int(std::lround(100.0 * pa_cvolume_max(&volume) / PA_VOLUME_NORM));
+    }
+
+    // Callbacks run on the loop thread with the lock held
+    static void signalLoop(pa_context*, void* data)
+    {
+        pa_threaded_mainloop_signal(static_cast<PulseMixer*>(data)->m_loop, 0);
+    }
+
+    static void succeeded(pa_context*, int, void* data)
+    {
+        pa_threaded_mainloop_signal(static_cast<PulseMixer*>(data)->m_loop, 0);
+    }
+
+    static void sinkInfo(pa_context*, const pa_sink_info* info, int eol, void* data)
+    {
+        auto* sink = static_cast<Sink*>(data);
+        if (eol == 0 && info) {
+            sink->volume = info->volume;
+            sink->muted = info->mute;
+            sink->found = true;
+        }
+        pa_threaded_mainloop_signal(sink->self->m_loop, 0);
+    }
+
+    // Someone changed a sink or the default one; re-read on our thread
+    static void subscribed(pa_context*, pa_subscription_event_type_t, uint32_t, void* data)
+    {
+        auto* self = static_cast<PulseMixer*>(data);
+        QMetaObject::invokeMethod(self, [self]() {
+            Locker lock(self->m_loop);
+            self->readLocked();
+        }, Qt::QueuedConnection);
+    }
+
+    // With the lock held; false when the context went away meanwhile
+    bool wait(pa_operation* operation)
+    {
+        if (!operation)
+            return false;
+        while (pa_operation_get_state(operation) == PA_OPERATION_RUNNING)
+            pa_threaded_mainloop_wait(m_loop);
+        const bool done = pa_operation_get_state(operation) == PA_OPERATION_DONE;
+        pa_operation_unref(operation);
+        return done;
+    }
+
+    Sink querySink()
+    {
+        Sink sink;
+        sink.self = this;
+        if (m_connected)
+            wait(pa_context_get_sink_info_by_name(m_context, kSink, &PulseMixer::sinkInfo, &sink));
+        return sink;
+    }
+
+    void readLocked()
+    {
+        const Sink sink = querySink();
+        update(sink.found ? MixerState { percentOf(sink.volume), sink.muted } : MixerState {});
+    }
+
+    pa_threaded_mainloop* m_loop = nullptr;
+    pa_context* m_context = nullptr;
+    bool m_connected = false;
+};
+#endif
+
+// ----------------- Fake -----------------
+class FakeMixer : public Mixer
+{
+public:
+    explicit FakeMixer(QObject* parent)
+    : Mixer(parent)
+    {
+        update({ 50, false });
+    }
+
+    QString name() const override { return "fake"; }
+
+    MixerState adjust(int deltaPercent) override
+    {
+        return update({ std::clamp(state().percent + deltaPercent, 0, 100), false });
+    }
+
+    MixerState toggleMute() override { return update({ state().percent, !state().muted }); }
+};
+
+} // namespace
+
+Mixer* Mixer::create(QObject* parent)
+{
+    const QString backend = qEnvironmentVariable("HEX_MIXER", "alsa");
+    if (backend == "fake")
+        return new FakeMixer(parent);
+#ifdef HEX_HAVE_PULSE
+    if (backend == "pulse")
+        return new PulseMixer(parent);
+#endif
+    if (backend != "alsa")
+        qWarning() << "[WARN] mixer backend" << backend << "is not available, using alsa";
+    return new AlsaMixer(parent);
+}
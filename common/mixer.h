@@ -0,0 +1,51 @@
+#pragma once
+
+#include <QObject>
+#include <QString>
+
+struct MixerState {
+    int percent = -1; // -1: no usable control
+    bool muted = false;
+
+    bool isValid() const { return percent >= 0; }
+    bool operator==(const MixerState& other) const { return percent == other.percent && muted == other.muted; }
+    bool operator!=(const MixerState& other) const { return !(*this == other); }
+};
+
+// The playback volume of the default output, changed in-process instead of
+// through amixer. Each change is one call that returns the state it left
+// behind, so a key press costs no process spawns and no re-reads.
+//
+// Backends, picked by HEX_MIXER:
+//   alsa  (default) the "Master" simple element of the default ALSA device,
+//         exactly what `amixer sset Master` touched
+//   pulse the default sink of PulseAudio or PipeWire's pulse server; only
+//         when built with libpulse
+//   fake  in memory, starts at 50%; for running the OSD without hardware
+//
+// changed() fires on changes from anywhere, including other processes.
+class Mixer : public QObject
+{
+    Q_OBJECT
+public:
+    static Mixer* create(QObject* parent = nullptr);
+
+    virtual QString name() const = 0;
+    MixerState state() const { return m_state; }
+
+    // Moves the volume by deltaPercent, clamped to 0..100, and unmutes
+    virtual MixerState adjust(int deltaPercent) = 0;
+    virtual MixerState toggleMute() = 0;
+
+signals:
+    void changed();
+
+protected:
+    using QObject::QObject;
+
+    // Backends report every state they read or set through here
+    MixerState update(const MixerState& state);
+
+private:
+    MixerState m_state;
+};
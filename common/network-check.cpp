@@ -0,0 +1,159 @@
+// network-check: NetworkMonitor against a real kernel, in a network namespace
+// of its own.
+//
+//   unshare -rn network-check        (or as root: unshare -n network-check)
+//
+// Changes the default route with ip(8) and waits, up to 2 s each, for the
+// monitor to report it from the netlink events alone (no refresh() calls).
+// A fake sysfs tree under HEX_SYSFS_ROOT makes eth9 look like wired hardware
+// and wlan9 like a wireless interface; all three links are veth pairs, which
+// need no module beyond veth itself.
+//
+//   empty     only lo: Disconnected
+//   veth      default route over a veth pair: Unknown, veth0
+//   switch    route replaced onto eth9: Ethernet, eth9
+//   wifi      route replaced onto wlan9: Wi-Fi without an SSID (a veth link
+//             has no station, so the nl80211 query fails or never resolves)
+//   ipv6      IPv4 default gone, IPv6 default over eth9: Ethernet, eth9
+//   down      no default route left: Disconnected
+//   burst     200 refresh() calls in a row return at once and do not change
+//             the answer
+//
+// Prints one line per check; exits non-zero if any fails. Refuses to run
+// when the namespace already has a default route, so it never touches the
+// host's network.
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTimer>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <vector>
+
+#include "networkmonitor.h"
+
+struct Step
+{
+    const char* name;
+    const char* commands;
+    QString type;
+    QString iface;
+};
+
+static bool writeFile(const QString& path, const QByteArray& contents)
+{
+    QFile file(path);
+    return file.open(QIODevice::WriteOnly) && file.write(contents) == contents.size();
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    if (std::system("test -z \"$(ip route show default; ip -6 route show default)\"") != 0) {
+        std::printf("this namespace has a default route; run under unshare -rn\n");
+        return 1;
+    }
+
+    QTemporaryDir sysfs;
+    const QString net = sysfs.path() + "/class/net";
+    if (!sysfs.isValid() || !QDir().mkpath(net + "/eth9/device") || !writeFile(net + "/eth9/type", "1\n")
+        || !QDir().mkpath(net + "/wlan9/wireless")) {
+        std::printf("cannot build a fake sysfs tree\n");
+        return 1;
+    }
+    qputenv("HEX_SYSFS_ROOT", sysfs.path().toUtf8());
+
+    const std::vector<Step> steps = {
+        { "empty", "", "Disconnected", "" },
+        { "veth",
+            "ip link add veth0 type veth peer name veth1 && ip link set veth1 up && ip link set veth0 up"
+            " && ip route add default dev veth0",
+            "Unknown", "veth0" },
+        { "switch", "ip link add eth9 type veth peer name eth9p && ip link set eth9p up && ip link set eth9 up"
+            " && ip route replace default dev eth9",
+            "Ethernet", "eth9" },
+        { "wifi", "ip link add wlan9 type veth peer name wlan9p && ip link set wlan9p up && ip link set wlan9 up"
+            " && ip route replace default dev wlan9",
+            "Wi-Fi", "" },
+        { "ipv6", "ip route del default && ip -6 route add default dev eth9", "Ethernet", "eth9" },
+        { "down", "ip -6 route del default", "Disconnected", "" },
+    };
+
+    NetworkMonitor monitor;
+    int changes = 0;
+
+    int failed = 0;
+    auto check = [&](const char* name, bool ok, const QByteArray& detail) {
+        std::printf("%-8s %s  %s\n", name, ok ? "ok  " : "FAIL", detail.constData());
+        if (!ok)
+            ++failed;
+    };
+
+    size_t current = 0;
+    QElapsedTimer clock;
+    QTimer deadline;
+    deadline.setSingleShot(true);
+    deadline.setInterval(2000);
+
+    auto burst = [&]() {
+        const int before = changes;
+        QElapsedTimer timer;
+        timer.start();
+        for (int i = 0; i < 200; ++i)
+            monitor.refresh();
+        const qint64 us = timer.nsecsElapsed() / 1000;
+
+        // Let the queued queries answer before looking at the result
+        QTimer::singleShot(200, &app, [&, before, us]() {
+            const bool ok = us < 5000 && changes == before && monitor.type() == "Disconnected";
+            check("burst", ok, QString("200 calls in %1 us, %2 change(s) after").arg(us).arg(changes - before).toUtf8());
+            app.quit();
+        });
+    };
+
+    std::function<void()> start;
+    auto settle = [&](bool timedOut) {
+        const Step& step = steps[current];
+        const bool ok = monitor.type() == step.type && monitor.name() == step.iface;
+        if (!ok && !timedOut)
+            return;
+
+        deadline.stop();
+        check(step.name, ok,
+            QString("%1 \"%2\" after %3 ms").arg(monitor.type(), monitor.name()).arg(clock.elapsed()).toUtf8());
+        if (++current < steps.size())
+            QTimer::singleShot(0, &app, start);
+        else
+            burst();
+    };
+
+    start = [&]() {
+        const Step& step = steps[current];
+        if (*step.commands && std::system(step.commands) != 0) {
+            check(step.name, false, QByteArray("ip failed: ") + step.commands);
+            app.exit(1);
+            return;
+        }
+        clock.start();
+        deadline.start();
+        settle(false);
+    };
+
+    QObject::connect(&monitor, &NetworkMonitor::changed, &app, [&]() {
+        ++changes;
+        if (deadline.isActive())
+            settle(false);
+    });
+    QObject::connect(&deadline, &QTimer::timeout, &app, [&]() { settle(true); });
+
+    // The constructor's own refresh answers from the event loop
+    QTimer::singleShot(200, &app, start);
+    app.exec();
+
+    return failed == 0 ? 0 : 1;
+}
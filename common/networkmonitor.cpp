@@ -0,0 +1,401 @@
+#include "networkmonitor.h"
+#include "sysfs.h"
+
+#include <QDebug>
+#include <QFileInfo>
+#include <QSocketNotifier>
+#include <QTimer>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <functional>
+#include <linux/genetlink.h>
+#include <linux/netlink.h>
+#include <linux/nl80211.h>
+#include <linux/rtnetlink.h>
+#include <net/if.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// ----------------- Netlink plumbing -----------------
+namespace {
+
+struct NetlinkRequest {
+    nlmsghdr header;
+    char payload[256];
+};
+
+int openNetlink(int protocol, unsigned groups)
+{
+    int fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC | SOCK_NONBLOCK, protocol);
+    if (fd < 0)
+        return -1;
+
+    sockaddr_nl addr = {};
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = groups;
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+void addAttribute(nlmsghdr* header, unsigned short type, const void* data, size_t length)
+{
+    auto* attr = reinterpret_cast<nlattr*>(reinterpret_cast<char*>(header) + NLMSG_ALIGN(header->nlmsg_len));
+    attr->nla_type = type;
+    attr->nla_len = NLA_HDRLEN + length;
+    memcpy(reinterpret_cast<char*>(attr) + NLA_HDRLEN, data, length);
+    header->nlmsg_len = NLMSG_ALIGN(header->nlmsg_len) + NLA_ALIGN(attr->nla_len);
+}
+
+// Calls onAttribute(type, data, length) for each attribute in [data, data + length)
+void forEachAttribute(const char* data, size_t length, const std::function<void(int, const char*, size_t)>& onAttribute)
+{
+    while (length >= NLA_HDRLEN) {
+        const auto* attr = reinterpret_cast<const nlattr*>(data);
+        if (attr->nla_len < NLA_HDRLEN || attr->nla_len > length)
+            break;
+        onAttribute(attr->nla_type & NLA_TYPE_MASK, data + NLA_HDRLEN, attr->nla_len - NLA_HDRLEN);
+
+        const size_t step = NLA_ALIGN(attr->nla_len);
+        if (step >= length)
+            break;
+        data += step;
+        length -= step;
+    }
+}
+
+// Hands every message waiting on a non-blocking netlink socket to onMessage
+void readMessages(int fd, const std::function<void(const nlmsghdr*)>& onMessage)
+{
+    alignas(nlmsghdr) char buffer[16384];
+    for (;;) {
+        ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return;
+
+        size_t remaining = n;
+        for (auto* message = reinterpret_cast<nlmsghdr*>(buffer); NLMSG_OK(message, remaining);
+             message = NLMSG_NEXT(message, remaining))
+            onMessage(message);
+    }
+}
+
+// The reply carries no more than the request's own answer (or its error)
+bool isAnswer(const nlmsghdr* message, quint32 seq)
+{
+    return message->nlmsg_seq == seq && message->nlmsg_type != NLMSG_NOOP && message->nlmsg_type != NLMSG_DONE;
+}
+
+} // namespace
+
+// ----------------- NetworkMonitor -----------------
+NetworkMonitor::NetworkMonitor(QObject* parent)
+: QObject(parent)
+{
+    m_routeQuery = openNetlink(NETLINK_ROUTE, 0);
+    m_routeEvents = openNetlink(NETLINK_ROUTE,
+        RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR | RTMGRP_IPV4_ROUTE | RTMGRP_IPV6_ROUTE);
+    if (m_routeQuery < 0 || m_routeEvents < 0)
+        qWarning() << "[WARN] rtnetlink unavailable:" << strerror(errno);
+
+    if (m_routeEvents >= 0) {
+        m_routeNotifier = new QSocketNotifier(m_routeEvents, QSocketNotifier::Read, this);
+        connect(m_routeNotifier, &QSocketNotifier::activated, this, [this]() { drainEvents(m_routeEvents); });
+    }
+    if (m_routeQuery >= 0) {
+        m_routeQueryNotifier = new QSocketNotifier(m_routeQuery, QSocketNotifier::Read, this);
+        connect(m_routeQueryNotifier, &QSocketNotifier::activated, this, &NetworkMonitor::readRouteReplies);
+    }
+
+    // The kernel answers at once; this only keeps a lost reply from
+    // wedging every later refresh
+    m_stepTimeout = new QTimer(this);
+    m_stepTimeout->setSingleShot(true);
+    m_stepTimeout->setInterval(1000);
+    connect(m_stepTimeout, &QTimer::timeout, this, [this]() {
+        qWarning() << "[WARN] no netlink reply within a second; network state may be stale";
+        finish(m_step == Step::Ssid ? "Wi-Fi" : "Disconnected", "");
+    });
+
+    resolveNl80211();
+    refresh();
+}
+
+NetworkMonitor::~NetworkMonitor()
+{
+    for (int fd : { m_routeEvents, m_routeQuery, m_wifiEvents, m_wifiQuery }) {
+        if (fd >= 0)
+            close(fd);
+    }
+}
+
+// Looks up the nl80211 family and joins its "mlme" group, which carries
+// connect/disconnect/roam events. Without cfg80211 loaded there is no
+// family and Wi-Fi simply has no SSID. The answer arrives in
+// readWifiReplies().
+void NetworkMonitor::resolveNl80211()
+{
+    m_wifiQuery = openNetlink(NETLINK_GENERIC, 0);
+    if (m_wifiQuery < 0)
+        return;
+    m_wifiQueryNotifier = new QSocketNotifier(m_wifiQuery, QSocketNotifier::Read, this);
+    connect(m_wifiQueryNotifier, &QSocketNotifier::activated, this, &NetworkMonitor::readWifiReplies);
+
+    NetlinkRequest request = {};
+    request.header.nlmsg_len = NLMSG_LENGTH(GENL_HDRLEN);
+    request.header.nlmsg_type = GENL_ID_CTRL;
+    request.header.nlmsg_flags = NLM_F_REQUEST;
+    request.header.nlmsg_seq = ++m_seq;
+    auto* genl = static_cast<genlmsghdr*>(NLMSG_DATA(&request.header));
+    genl->cmd = CTRL_CMD_GETFAMILY;
+    genl->version = 1;
+    addAttribute(&request.header, CTRL_ATTR_FAMILY_NAME, NL80211_GENL_NAME, sizeof(NL80211_GENL_NAME));
+
+    if (send(m_wifiQuery, &request, request.header.nlmsg_len, 0) >= 0)
+        m_familySeq = request.header.nlmsg_seq;
+}
+
+void NetworkMonitor::joinMlme(quint32 group)
+{
+    m_wifiEvents = openNetlink(NETLINK_GENERIC, 0);
+    if (m_wifiEvents < 0)
+        return;
+    if (setsockopt(m_wifiEvents, SOL_NETLINK, NETLINK_ADD_MEMBERSHIP, &group, sizeof(group)) < 0) {
+        close(m_wifiEvents);
+        m_wifiEvents = -1;
+        return;
+    }
+
+    m_wifiNotifier = new QSocketNotifier(m_wifiEvents, QSocketNotifier::Read, this);
+    connect(m_wifiNotifier, &QSocketNotifier::activated, this, [this]() { drainEvents(m_wifiEvents); });
+}
+
+void NetworkMonitor::readWifiReplies()
+{
+    readMessages(m_wifiQuery, [this](const nlmsghdr* reply) {
+        if (m_familySeq && isAnswer(reply, m_familySeq)) {
+            m_familySeq = 0;
+            if (reply->nlmsg_type == NLMSG_ERROR)
+                return;
+
+            quint32 mlmeGroup = 0;
+            const char* attrs = static_cast<const char*>(NLMSG_DATA(reply)) + GENL_HDRLEN;
+            forEachAttribute(attrs, reply->nlmsg_len - NLMSG_LENGTH(GENL_HDRLEN), [&](int type, const char* data, size_t length) {
+                if (type == CTRL_ATTR_FAMILY_ID && length >= sizeof(quint16)) {
+                    memcpy(&m_nl80211Family, data, sizeof(quint16));
+                } else if (type == CTRL_ATTR_MCAST_GROUPS) {
+                    forEachAttribute(data, length, [&](int, const char* group, size_t groupLength) {
+                        QByteArray name;
+                        quint32 id = 0;
+                        forEachAttribute(group, groupLength, [&](int field, const char* value, size_t valueLength) {
+                            if (field == CTRL_ATTR_MCAST_GRP_NAME)
+                                name = QByteArray(value, qstrnlen(value, valueLength));
+                            else if (field == CTRL_ATTR_MCAST_GRP_ID && valueLength >= sizeof(quint32))
+                                memcpy(&id, value, sizeof(quint32));
+                        });
+                        if (name == NL80211_MULTICAST_GROUP_MLME)
+                            mlmeGroup = id;
+                    });
+                }
+            });
+
+            if (m_nl80211Family && mlmeGroup)
+                joinMlme(mlmeGroup);
+            // A refresh that ran before this had no way to ask for the SSID
+            if (m_nl80211Family)
+                scheduleRefresh();
+            return;
+        }
+
+        // What `iwgetid -r` prints: the SSID of the station interface, if connected
+        if (m_step == Step::Ssid && isAnswer(reply, m_stepSeq)) {
+            QString ssid;
+            if (reply->nlmsg_type != NLMSG_ERROR) {
+                const char* attrs = static_cast<const char*>(NLMSG_DATA(reply)) + GENL_HDRLEN;
+                forEachAttribute(attrs, reply->nlmsg_len - NLMSG_LENGTH(GENL_HDRLEN), [&](int type, const char* data, size_t length) {
+                    if (type == NL80211_ATTR_SSID)
+                        ssid = QString::fromUtf8(data, length);
+                });
+            }
+            finish("Wi-Fi", ssid);
+        }
+    });
+}
+
+void NetworkMonitor::drainEvents(int fd)
+{
+    // Contents do not matter: any change is answered by asking the kernel
+    // for the current route. Bursts coalesce into one refresh.
+    char buffer[16384];
+    bool any = false;
+    ssize_t n;
+    while ((n = recv(fd, buffer, sizeof(buffer), MSG_DONTWAIT)) > 0 || (n < 0 && errno == EINTR))
+        any = true;
+
+    // ENOBUFS: we missed events, so a refresh is due anyway
+    if (any || (n < 0 && errno == ENOBUFS))
+        scheduleRefresh();
+}
+
+void NetworkMonitor::scheduleRefresh()
+{
+    if (m_refreshPending)
+        return;
+
+    m_refreshPending = true;
+    QTimer::singleShot(0, this, [this]() {
+        m_refreshPending = false;
+        refresh();
+    });
+}
+
+void NetworkMonitor::refresh()
+{
+    if (m_step != Step::Idle) {
+        m_refreshAgain = true;
+        return;
+    }
+    queryRoute(Step::RouteIPv4);
+}
+
+// Equivalent of `ip route get 8.8.8.8`; the outgoing interface index comes
+// back in readRouteReplies()
+void NetworkMonitor::queryRoute(Step step)
+{
+    if (m_routeQuery < 0) {
+        finish("Disconnected", "");
+        return;
+    }
+
+    const bool ipv4 = step == Step::RouteIPv4;
+    const int family = ipv4 ? AF_INET : AF_INET6;
+    const unsigned char length = ipv4 ? 32 : 128;
+    unsigned char address[16];
+    inet_pton(family, ipv4 ? "8.8.8.8" : "2001:4860:4860::8888", address);
+
+    NetlinkRequest request = {};
+    request.header.nlmsg_len = NLMSG_LENGTH(sizeof(rtmsg));
+    request.header.nlmsg_type = RTM_GETROUTE;
+    request.header.nlmsg_flags = NLM_F_REQUEST;
+    request.header.nlmsg_seq = ++m_seq;
+    auto* route = static_cast<rtmsg*>(NLMSG_DATA(&request.header));
+    route->rtm_family = family;
+    route->rtm_dst_len = length;
+    addAttribute(&request.header, RTA_DST, address, length / 8);
+
+    m_step = step;
+    m_stepSeq = request.header.nlmsg_seq;
+    if (send(m_routeQuery, &request, request.header.nlmsg_len, 0) < 0) {
+        routeFound(0);
+        return;
+    }
+    m_stepTimeout->start();
+}
+
+void NetworkMonitor::readRouteReplies()
+{
+    readMessages(m_routeQuery, [this](const nlmsghdr* reply) {
+        if ((m_step != Step::RouteIPv4 && m_step != Step::RouteIPv6) || !isAnswer(reply, m_stepSeq))
+            return;
+
+        // An NLMSG_ERROR here is the usual "network is unreachable"
+        int ifindex = 0;
+        if (reply->nlmsg_type == RTM_NEWROUTE) {
+            const char* attrs = static_cast<const char*>(NLMSG_DATA(reply)) + NLMSG_ALIGN(sizeof(rtmsg));
+            forEachAttribute(attrs, reply->nlmsg_len - NLMSG_LENGTH(sizeof(rtmsg)), [&](int type, const char* data, size_t length) {
+                if (type == RTA_OIF && length >= sizeof(int))
+                    memcpy(&ifindex, data, sizeof(int));
+            });
+        }
+        routeFound(ifindex);
+    });
+}
+
+void NetworkMonitor::routeFound(int ifindex)
+{
+    char nameBuffer[IF_NAMESIZE];
+    if (ifindex <= 0 || !if_indextoname(ifindex, nameBuffer)) {
+        if (m_step == Step::RouteIPv4)
+            queryRoute(Step::RouteIPv6);
+        else
+            finish("Disconnected", "");
+        return;
+    }
+
+    const QString iface = QString::fromUtf8(nameBuffer);
+    const QString type = classify(iface);
+    if (type == "Wi-Fi")
+        querySsid(ifindex);
+    else
+        finish(type, iface);
+}
+
+void NetworkMonitor::querySsid(int ifindex)
+{
+    if (m_wifiQuery < 0 || !m_nl80211Family) {
+        finish("Wi-Fi", "");
+        return;
+    }
+
+    NetlinkRequest request = {};
+    request.header.nlmsg_len = NLMSG_LENGTH(GENL_HDRLEN);
+    request.header.nlmsg_type = m_nl80211Family;
+    request.header.nlmsg_flags = NLM_F_REQUEST;
+    request.header.nlmsg_seq = ++m_seq;
+    auto* genl = static_cast<genlmsghdr*>(NLMSG_DATA(&request.header));
+    genl->cmd = NL80211_CMD_GET_INTERFACE;
+    genl->version = 0;
+    const quint32 index = ifindex;
+    addAttribute(&request.header, NL80211_ATTR_IFINDEX, &index, sizeof(index));
+
+    m_step = Step::Ssid;
+    m_stepSeq = request.header.nlmsg_seq;
+    if (send(m_wifiQuery, &request, request.header.nlmsg_len, 0) < 0) {
+        finish("Wi-Fi", "");
+        return;
+    }
+    m_stepTimeout->start();
+}
+
+void NetworkMonitor::finish(const QString& type, const QString& name)
+{
+    m_stepTimeout->stop();
+    m_step = Step::Idle;
+
+    if (type != m_type || name != m_name) {
+        m_type = type;
+        m_name = name;
+        emit changed();
+    }
+
+    if (m_refreshAgain) {
+        m_refreshAgain = false;
+        refresh();
+    }
+}
+
+QString NetworkMonitor::classify(const QString& iface) const
+{
+    const QString path = sysfsRoot() + "/class/net/" + iface;
+
+    if (QFileInfo::exists(path + "/wireless") || QFileInfo::exists(path + "/phy80211")
+        || ueventValue(path + "/uevent", "DEVTYPE") == "wlan")
+        return "Wi-Fi";
+
+    // rndis_host, cdc_ether, ipheth, ...: anything network-capable on USB
+    if (QFileInfo(QFileInfo(path + "/device/subsystem").symLinkTarget()).fileName() == "usb")
+        return "USB Tethering";
+
+    // ARPHRD_ETHER backed by real hardware (veth, bridges and the like have no device)
+    QFile typeFile(path + "/type");
+    if (typeFile.open(QIODevice::ReadOnly) && typeFile.readAll().trimmed() == "1" && QFileInfo::exists(path + "/device"))
+        return "Ethernet";
+
+    return "Unknown";
+}
+
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <QObject>
+#include <QString>
+
+class QSocketNotifier;
+class QTimer;
+
+// Tracks which interface carries the default route and what kind it is.
+//
+// Listens for rtnetlink link/address/route changes and nl80211 MLME events
+// instead of polling; on each burst of events it asks the kernel for the
+// route to 8.8.8.8 (falling back to 2001:4860:4860::8888), classifies the
+// outgoing interface through sysfs and, for Wi-Fi, asks nl80211 for the SSID.
+// changed() is only emitted when the result differs.
+//
+// The queries go out on non-blocking sockets and their replies are read
+// from the event loop, one step after the other, so a slow generic netlink
+// reply never holds up the thread. A refresh asked for while one is under
+// way runs once it has finished.
+class NetworkMonitor : public QObject
+{
+    Q_OBJECT
+public:
+    explicit NetworkMonitor(QObject* parent = nullptr);
+    ~NetworkMonitor() override;
+
+    // "Wi-Fi", "Ethernet", "USB Tethering", "Unknown" or "Disconnected"
+    QString type() const { return m_type; }
+    // SSID for Wi-Fi, the interface name otherwise
+    QString name() const { return m_name; }
+
+    // Starts a re-evaluation; events already do this on their own.
+    void refresh();
+
+signals:
+    void changed();
+
+private:
+    enum class Step { Idle, RouteIPv4, RouteIPv6, Ssid };
+
+    void drainEvents(int fd);
+    void scheduleRefresh();
+    void queryRoute(Step step);
+    void readRouteReplies();
+    void routeFound(int ifindex);
+    void querySsid(int ifindex);
+    void readWifiReplies();
+    void finish(const QString& type, const QString& name);
+    QString classify(const QString& iface) const;
+    void resolveNl80211();
+    void joinMlme(quint32 group);
+
+    int m_routeEvents = -1; // rtnetlink multicast
+    int m_routeQuery = -1;
+    int m_wifiEvents = -1; // nl80211 "mlme" multicast
+    int m_wifiQuery = -1;
+    quint16 m_nl80211Family = 0;
+    quint32 m_seq = 0;
+    quint32 m_familySeq = 0; // the nl80211 family lookup, until answered
+    QSocketNotifier* m_routeNotifier = nullptr;
+    QSocketNotifier* m_routeQueryNotifier = nullptr;
+    QSocketNotifier* m_wifiNotifier = nullptr;
+    QSocketNotifier* m_wifiQueryNotifier = nullptr;
+    bool m_refreshPending = false;
+
+    // The refresh under way
+    Step m_step = Step::Idle;
+    quint32 m_stepSeq = 0;
+    bool m_refreshAgain = false;
+    QTimer* m_stepTimeout = nullptr;
+
+    QString m_type = "Disconnected";
+    QString m_name = "";
+};
@@ -0,0 +1,373 @@
+#include "statehub.h"
+
+#include <QDebug>
+#include <QSocketNotifier>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <chrono>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sched.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+static_assert(std::atomic<quint32>::is_always_lock_free, "futex word must be a plain 32-bit integer");
+
+namespace {
+
+// Shared (not FUTEX_PRIVATE): waiters and waker live in different processes
+int futexWait(const std::atomic<quint32>* word, quint32 expected, const timespec* timeout)
+{
+    return syscall(SYS_futex, word, FUTEX_WAIT, expected, timeout, nullptr, 0);
+}
+
+void futexWakeAll(const std::atomic<quint32>* word)
+{
+    syscall(SYS_futex, word, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+void copyString(char* destination, size_t size, const QString& value)
+{
+    const QByteArray utf8 = value.toUtf8();
+    const size_t length = qMin(size_t(utf8.size()), size - 1);
+    memcpy(destination, utf8.constData(), length);
+    memset(destination + length, 0, size - length);
+}
+
+QString readString(const char* source, size_t size)
+{
+    return QString::fromUtf8(source, qstrnlen(source, size));
+}
+
+// One consistent copy of the payload. A publish is a few stores, so a
+// reader that catches one spins a little, then yields, then sleeps. A
+// sequence that stays odd means the writer died mid-publish; give up after
+// a millisecond or two instead of hanging the caller (the next writer evens
+// the sequence out again).
+bool readPayload(const HexStateShm* shm, HexStateShm::Payload& copy)
+{
+    for (int attempt = 0; attempt < 100; ++attempt) {
+        if (attempt >= 80) {
+            const timespec pause = { 0, 50000 };
+            nanosleep(&pause, nullptr);
+        } else if (attempt >= 10) {
+            sched_yield();
+        }
+
+        const quint32 before = shm->sequence.load(std::memory_order_acquire);
+        if (before & 1)
+            continue;
+        memcpy(&copy, const_cast<const HexStateShm::Payload*>(&shm->payload), sizeof(copy));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (shm->sequence.load(std::memory_order_relaxed) == before)
+            return true;
+    }
+    return false;
+}
+
+} // namespace
+
+QString hexStateShmName()
+{
+    return "/hexstate-" + QString::number(getuid());
+}
+
+// ----------------- StateHubWriter -----------------
+StateHubWriter::StateHubWriter()
+{
+    const QByteArray name = hexStateShmName().toUtf8();
+    int fd = shm_open(name.constData(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        qWarning() << "[WARN] cannot create" << name << ":" << strerror(errno);
+        return;
+    }
+    // Network names and battery state are nobody else's business; this also
+    // tightens a segment an older daemon created world-readable
+    fchmod(fd, 0600);
+
+    // One writer at a time; the lock goes away with the process, which is
+    // how readers tell a live daemon from a dead one. Their probe holds a
+    // shared lock for a moment, so try a few times before giving up.
+    for (int attempt = 0; flock(fd, LOCK_EX | LOCK_NB) < 0; ++attempt) {
+        if (errno != EWOULDBLOCK || attempt == 20) {
+            qWarning() << "[WARN]" << name << "is already being published by another hexstate";
+            close(fd);
+            return;
+        }
+        usleep(1000);
+    }
+
+    void* memory = MAP_FAILED;
+    if (ftruncate(fd, sizeof(HexStateShm)) == 0)
+        memory = mmap(nullptr, sizeof(HexStateShm), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (memory == MAP_FAILED) {
+        qWarning() << "[WARN] cannot map" << name << ":" << strerror(errno);
+        close(fd);
+        return;
+    }
+
+    m_lockFd = fd;
+    m_shm = static_cast<HexStateShm*>(memory);
+
+    // A previous daemon may have left a segment behind; carry on from its
+    // sequence so sleeping readers still see it move.
+    if (m_shm->magic == HexStateShm::Magic && m_shm->version == HexStateShm::Version)
+        m_generation = m_shm->payload.generation;
+
+    // One killed mid-publish left the sequence odd, which every reader
+    // takes for a publish in progress; even it out before the first publish
+    const quint32 sequence = m_shm->sequence.load(std::memory_order_relaxed);
+    if (sequence & 1) {
+        m_shm->sequence.store(sequence + 1, std::memory_order_release);
+        futexWakeAll(&m_shm->sequence);
+    }
+    m_shm->writerPid = getpid();
+    m_shm->magic = HexStateShm::Magic;
+    m_shm->version = HexStateShm::Version;
+}
+
+StateHubWriter::~StateHubWriter()
+{
+    if (!m_shm)
+        return;
+
+    // Readers fall back to their own sources once the daemon is gone
+    const quint32 sequence = m_shm->sequence.load(std::memory_order_relaxed);
+    m_shm->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    m_shm->online = 0;
+    m_shm->payload.changedFields = HexStateField::Online;
+    m_shm->sequence.store(sequence + 2, std::memory_order_release);
+    futexWakeAll(&m_shm->sequence);
+
+    munmap(m_shm, sizeof(HexStateShm));
+    close(m_lockFd);
+}
+
+void StateHubWriter::publish(const HexState& state, quint32 changedFields)
+{
+    if (!m_shm)
+        return;
+
+    HexStateShm::Payload payload = {};
+    payload.generation = ++m_generation;
+    payload.changedFields = changedFields;
+    payload.batteryPercent = state.batteryPercent;
+    copyString(payload.batteryStatus, sizeof(payload.batteryStatus), state.batteryStatus);
+    copyString(payload.networkType, sizeof(payload.networkType), state.networkType);
+    copyString(payload.networkName, sizeof(payload.networkName), state.networkName);
+    payload.volumePercent = state.volumePercent;
+    payload.muted = state.muted;
+    payload.brightnessPercent = state.brightnessPercent;
+
+    const quint32 sequence = m_shm->sequence.load(std::memory_order_relaxed);
+    m_shm->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(&m_shm->payload, &payload, sizeof(payload));
+    m_shm->online = 1;
+    m_shm->sequence.store(sequence + 2, std::memory_order_release);
+
+    futexWakeAll(&m_shm->sequence);
+}
+
+// ----------------- StateHubClient -----------------
+StateHubClient::StateHubClient(QObject* parent)
+: QObject(parent)
+{
+    const QByteArray name = hexStateShmName().toUtf8();
+    int fd = shm_open(name.constData(), O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0)
+        return;
+
+    void* memory = mmap(nullptr, sizeof(HexStateShm), PROT_READ, MAP_SHARED, fd, 0);
+    if (memory == MAP_FAILED) {
+        close(fd);
+        return;
+    }
+
+    const auto* shm = static_cast<const HexStateShm*>(memory);
+    if (shm->magic != HexStateShm::Magic || shm->version != HexStateShm::Version) {
+        munmap(memory, sizeof(HexStateShm));
+        close(fd);
+        return;
+    }
+    m_shm = shm;
+    m_fd = fd; // kept for the liveness probe
+}
+
+StateHubClient::~StateHubClient()
+{
+    if (m_watcher.joinable()) {
+        m_stopping = true;
+        // The watcher may have checked m_stopping and not yet gone to sleep,
+        // and a single wake would then be lost; keep waking until it is out.
+        // Wakes other readers too; they just find nothing new and sleep again.
+        while (!m_watcherDone) {
+            futexWakeAll(&m_shm->sequence);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        m_watcher.join();
+    }
+
+    if (m_pidFd >= 0)
+        close(m_pidFd);
+    if (m_shm) {
+        munmap(const_cast<HexStateShm*>(m_shm), sizeof(HexStateShm));
+        close(m_fd);
+    }
+}
+
+bool StateHubClient::isAvailable() const
+{
+    return m_shm && m_shm->online && writerAlive();
+}
+
+// The daemon holds an exclusive flock on the segment for as long as it runs,
+// so a shared one only succeeds once it has gone, clean exit or not
+bool StateHubClient::writerAlive() const
+{
+    if (flock(m_fd, LOCK_SH | LOCK_NB) == 0) {
+        flock(m_fd, LOCK_UN);
+        return false;
+    }
+    return errno == EWOULDBLOCK;
+}
+
+HexState StateHubClient::state() const
+{
+    HexState state;
+    if (!m_shm)
+        return state;
+
+    HexStateShm::Payload payload;
+    if (!readPayload(m_shm, payload))
+        return m_lastState;
+    state.generation = payload.generation;
+    state.changedFields = payload.changedFields;
+    state.batteryPercent = payload.batteryPercent;
+    state.batteryStatus = readString(payload.batteryStatus, sizeof(payload.batteryStatus));
+    state.networkType = readString(payload.networkType, sizeof(payload.networkType));
+    state.networkName = readString(payload.networkName, sizeof(payload.networkName));
+    state.volumePercent = payload.volumePercent;
+    state.muted = payload.muted;
+    state.brightnessPercent = payload.brightnessPercent;
+    m_lastState = state;
+    return state;
+}
+
+bool StateHubClient::waitForChange(quint64 generation, int timeoutMs) const
+{
+    if (!m_shm)
+        return false;
+
+    timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += timeoutMs / 1000;
+    deadline.tv_nsec += (timeoutMs % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec += 1;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    for (;;) {
+        const quint32 sequence = m_shm->sequence.load(std::memory_order_acquire);
+        HexStateShm::Payload payload;
+        if (!(sequence & 1) && readPayload(m_shm, payload) && payload.generation != generation)
+            return true;
+
+        // FUTEX_WAIT takes a relative timeout
+        timespec now, remaining;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        remaining.tv_sec = deadline.tv_sec - now.tv_sec;
+        remaining.tv_nsec = deadline.tv_nsec - now.tv_nsec;
+        if (remaining.tv_nsec < 0) {
+            remaining.tv_sec -= 1;
+            remaining.tv_nsec += 1000000000L;
+        }
+        if (remaining.tv_sec < 0)
+            return false;
+
+        futexWait(&m_shm->sequence, sequence, &remaining);
+    }
+}
+
+void StateHubClient::startWatching()
+{
+    if (!m_shm || m_watcher.joinable())
+        return;
+
+    m_seenSequence = m_shm->sequence.load(std::memory_order_acquire);
+    m_watcher = std::thread([this]() { watch(); });
+    watchWriter();
+}
+
+void StateHubClient::watch()
+{
+    quint32 seen = m_seenSequence;
+    while (!m_stopping) {
+        const quint32 sequence = m_shm->sequence.load(std::memory_order_acquire);
+        HexStateShm::Payload payload;
+        if (sequence != seen && !(sequence & 1) && readPayload(m_shm, payload)) {
+            seen = sequence;
+            const quint32 fields = payload.changedFields;
+            QMetaObject::invokeMethod(this, [this, fields]() {
+                watchWriter(); // a restarted daemon has a new pid
+                emit changed(fields);
+            }, Qt::QueuedConnection);
+        }
+
+        // Sleeps until the next publish (or a spurious wake)
+        futexWait(&m_shm->sequence, sequence, nullptr);
+    }
+    m_watcherDone = true;
+}
+
+// A killed daemon never publishes its exit, but its pidfd turns readable
+// when it goes, so the owner hears about it without anyone polling
+void StateHubClient::watchWriter()
+{
+    const qint32 pid = m_shm->writerPid;
+    if (!m_shm->online || pid <= 0 || pid == m_watchedPid)
+        return;
+
+    delete m_writerExit;
+    m_writerExit = nullptr;
+    if (m_pidFd >= 0)
+        close(m_pidFd);
+    m_watchedPid = pid;
+
+    m_pidFd = int(syscall(SYS_pidfd_open, pid, 0));
+    if (m_pidFd < 0) {
+        if (errno == ESRCH)
+            writerExited();
+        else
+            qWarning() << "[WARN] cannot watch hexstate (pid" << pid << "):" << strerror(errno);
+        return;
+    }
+
+    // The pid may have been reused between the daemon's death and the
+    // pidfd; the lock tells
+    if (!writerAlive()) {
+        writerExited();
+        return;
+    }
+
+    m_writerExit = new QSocketNotifier(m_pidFd, QSocketNotifier::Read, this);
+    connect(m_writerExit, &QSocketNotifier::activated, this, &StateHubClient::writerExited);
+}
+
+void StateHubClient::writerExited()
+{
+    if (m_writerExit)
+        m_writerExit->setEnabled(false);
+
+    // Tell the owner as if the daemon had said so, so it starts its own
+    // monitors; a clean exit has already been published
+    if (m_shm->online && !writerAlive())
+        emit changed(HexStateField::Online);
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+class QSocketNotifier;
+
+// Shared system state published by the hexstate daemon.
+//
+// hexstate owns the battery, network, volume and brightness sources and
+// writes them into a POSIX shared-memory segment ("/hexstate-<uid>"). The
+// segment is guarded by a seqlock: the writer makes `sequence` odd, updates
+// the payload and makes it even again, and a reader copies the payload and
+// retries if `sequence` moved underneath it. `sequence` doubles as a futex
+// word, woken on every publish, so readers can sleep until something changes.
+//
+// Readers map the segment read-only; reading current state is a memory copy,
+// not a process spawn. The segment is private to the user (0600); readers
+// run as the same user as the daemon. The daemon holds an exclusive flock on
+// the segment while it runs, so readers can tell it has died even when it
+// could not clear `online` on the way out, and it records its pid so a
+// watching reader can hold a pidfd and hear about that death as it happens.
+namespace HexStateField {
+enum : quint32 {
+    Battery = 1 << 0,
+    Network = 1 << 1,
+    Volume = 1 << 2,
+    Brightness = 1 << 3,
+    Online = 1 << 4
+};
+}
+
+struct HexStateShm {
+    static constexpr quint32 Magic = 0x53584548; // "HEXS"
+    static constexpr quint32 Version = 2;
+
+    quint32 magic;
+    quint32 version;
+    std::atomic<quint32> sequence;
+    quint32 online; // cleared by the daemon on a clean exit
+    qint32 writerPid; // the daemon publishing now
+
+    struct Payload {
+        quint64 generation; // publishes so far
+        quint32 changedFields; // HexStateField bits of the last publish
+        qint32 batteryPercent; // -1 without a battery
+        char batteryStatus[32];
+        char networkType[32];
+        char networkName[64];
+        qint32 volumePercent; // -1 when unknown
+        quint32 muted;
+        qint32 brightnessPercent; // -1 without a backlight
+    } payload;
+};
+
+// Decoded copy of the payload
+struct HexState {
+    quint64 generation = 0;
+    quint32 changedFields = 0;
+    int batteryPercent = -1;
+    QString batteryStatus = "Unknown";
+    QString networkType = "Disconnected";
+    QString networkName;
+    int volumePercent = -1;
+    bool muted = false;
+    int brightnessPercent = -1;
+};
+
+QString hexStateShmName();
+
+// Daemon side: creates the segment and publishes into it.
+class StateHubWriter
+{
+public:
+    StateHubWriter();
+    ~StateHubWriter();
+
+    bool isOpen() const { return m_shm != nullptr; }
+
+    // Publishes `state` and wakes every waiting reader.
+    void publish(const HexState& state, quint32 changedFields);
+
+private:
+    HexStateShm* m_shm = nullptr;
+    int m_lockFd = -1;
+    quint64 m_generation = 0;
+};
+
+// Reader side. Open once; state() is a lock-free copy. While watching, a
+// helper thread sleeps on the futex and changed() fires on the owner's thread.
+class StateHubClient : public QObject
+{
+    Q_OBJECT
+public:
+    explicit StateHubClient(QObject* parent = nullptr);
+    ~StateHubClient() override;
+
+    // True when the daemon's segment exists and the daemon is running
+    bool isAvailable() const;
+
+    // The last consistent copy if the daemon died halfway through a publish
+    HexState state() const;
+
+    // Blocks until the generation moves past `generation` or timeoutMs passes.
+    // For one-shot readers that want to see the effect of their own change.
+    bool waitForChange(quint64 generation, int timeoutMs) const;
+
+    // Also notices the daemon dying without a clean exit, through a pidfd
+    // on the event loop, and reports it as changed(HexStateField::Online)
+    void startWatching();
+
+signals:
+    void changed(quint32 fields);
+
+private:
+    void watch();
+    void watchWriter();
+    void writerExited();
+    bool writerAlive() const;
+
+    const HexStateShm* m_shm = nullptr;
+    int m_fd = -1;
+    int m_pidFd = -1;
+    qint32 m_watchedPid = 0;
+    QSocketNotifier* m_writerExit = nullptr;
+    mutable HexState m_lastState;
+    std::thread m_watcher;
+    std::atomic<bool> m_stopping { false };
+    std::atomic<bool> m_watcherDone { false };
+    quint32 m_seenSequence = 0;
+};
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+// Root of the sysfs tree. HEX_SYSFS_ROOT points the monitors at a fake tree,
+// so they can be exercised without the hardware.
+inline QString sysfsRoot()
+{
+    const QString root = qEnvironmentVariable("HEX_SYSFS_ROOT");
+    return root.isEmpty() ? QStringLiteral("/sys") : root;
+}
+
+// Value of KEY=value in a sysfs uevent file, or an empty string.
+inline QString ueventValue(const QString& ueventPath, const QByteArray& key)
+{
+    QFile file(ueventPath);
+    if (!file.open(QIODevice::ReadOnly))
+        return "";
+
+    const QByteArray prefix = key + '=';
+    for (const QByteArray& line : file.readAll().split('\n')) {
+        if (line.startsWith(prefix))
+            return QString::fromUtf8(line.mid(prefix.size()));
+    }
+    return "";
+}
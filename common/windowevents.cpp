@@ -0,0 +1,91 @@
+#include "windowevents.h"
+
+#include <QDebug>
+
+WindowEventStream::WindowEventStream(QObject* parent)
+: QObject(parent)
+{
+    m_process.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    connect(&m_process, &QProcess::readyReadStandardOutput, this, &WindowEventStream::readEvents);
+    connect(&m_process, &QProcess::errorOccurred, this, [](QProcess::ProcessError error) {
+        qWarning() << "[WARN] list-windows --watch failed:" << error;
+    });
+    connect(&m_process, &QProcess::finished, this, [this](int exitCode) {
+        m_ready = false;
+        qWarning() << "[WARN] list-windows --watch exited with code" << exitCode;
+    });
+}
+
+WindowEventStream::~WindowEventStream()
+{
+    // Closing stdin makes list-windows leave its loop on its own.
+    m_process.closeWriteChannel();
+    if (!m_process.waitForFinished(100))
+        m_process.kill();
+}
+
+void WindowEventStream::start()
+{
+    if (m_process.state() != QProcess::NotRunning)
+        return;
+    m_process.start("list-windows", { "--watch" });
+}
+
+void WindowEventStream::activate(quint32 id)
+{
+    sendCommand("activate", id);
+}
+
+void WindowEventStream::close(quint32 id)
+{
+    sendCommand("close", id);
+}
+
+void WindowEventStream::sendCommand(const QByteArray& command, quint32 id)
+{
+    if (m_process.state() != QProcess::Running)
+        return;
+    m_process.write(command + ' ' + QByteArray::number(id) + '\n');
+}
+
+void WindowEventStream::readEvents()
+{
+    bool changed = false;
+
+    while (m_process.canReadLine()) {
+        const QByteArray line = m_process.readLine().chopped(1);
+
+        if (line == "ready") {
+            m_ready = true;
+            changed = true;
+            emit ready();
+            continue;
+        }
+
+        // <event>\t<id>\t<focused>\t<last_activated>\t<app_id>\t<title>
+        const QList<QByteArray> fields = line.split('\t');
+        if (fields.size() < 6)
+            continue;
+
+        const QByteArray& event = fields[0];
+        const quint32 id = fields[1].toUInt();
+        const bool focused = fields[2] == "1";
+        const quint64 lastActivated = fields[3].toULongLong();
+        const QString appId = QString::fromUtf8(fields[4]);
+        const QString title = QString::fromUtf8(fields[5]);
+
+        if (event == "closed") {
+            emit windowClosed(id, appId, title);
+        } else {
+            if (event == "added")
+                emit windowAdded(id, appId, title);
+            else if (event == "activated")
+                emit windowActivated(id, appId, title);
+            emit windowChanged(id, appId, title, focused, lastActivated);
+        }
+        changed = true;
+    }
+
+    if (changed && m_ready)
+        emit windowsChanged();
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <QObject>
+#include <QProcess>
+
+// Keeps one "list-windows --watch" child alive and turns its event lines into
+// signals, so nobody has to respawn list-windows or poll windows.ini to learn
+// that a toplevel appeared, changed or went away.
+class WindowEventStream : public QObject
+{
+    Q_OBJECT
+public:
+    explicit WindowEventStream(QObject* parent = nullptr);
+    ~WindowEventStream() override;
+
+    void start();
+    bool isReady() const { return m_ready; }
+
+    void activate(quint32 id);
+    void close(quint32 id);
+
+signals:
+    void ready();
+    void windowAdded(quint32 id, const QString& appId, const QString& title);
+    void windowChanged(quint32 id, const QString& appId, const QString& title, bool focused, quint64 lastActivated);
+    void windowActivated(quint32 id, const QString& appId, const QString& title);
+    void windowClosed(quint32 id, const QString& appId, const QString& title);
+
+    // Once per batch of events, after list-windows has rewritten windows.ini.
+    void windowsChanged();
+
+private:
+    void readEvents();
+    void sendCommand(const QByteArray& command, quint32 id);
+
+    QProcess m_process;
+    bool m_ready = false;
+};
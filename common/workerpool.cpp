@@ -0,0 +1,200 @@
+#include "workerpool.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QThread>
+#include <QTimer>
+#include <algorithm>
+#include <pthread.h>
+
+// Index of the worker running on this thread, -1 elsewhere
+static thread_local int t_workerIndex = -1;
+
+WorkerPool* WorkerPool::instance()
+{
+    // Owned by the application: the workers are joined before it goes
+    static WorkerPool* pool = new WorkerPool(QCoreApplication::instance());
+    return pool;
+}
+
+WorkerPool::WorkerPool(QObject* parent)
+: QObject(parent)
+{
+    m_clock.start();
+
+    // Two at least, so one long task cannot hold up everything else
+    const int count = std::max(2, QThread::idealThreadCount());
+    for (int i = 0; i < count; ++i)
+        m_workers.push_back(std::make_unique<Worker>());
+    for (int i = 0; i < count; ++i) {
+        m_workers[i]->thread = std::thread(&WorkerPool::workerLoop, this, i);
+        pthread_setname_np(m_workers[i]->thread.native_handle(), ("hexpool-" + std::to_string(i)).c_str());
+    }
+
+    bool ok = false;
+    const int statsSecs = qEnvironmentVariableIntValue("HEX_POOL_STATS", &ok);
+    if (ok && statsSecs > 0) {
+        auto* stats = new QTimer(this);
+        connect(stats, &QTimer::timeout, this, &WorkerPool::logStats);
+        stats->start(statsSecs * 1000);
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    for (auto& worker : m_workers)
+        worker->thread.join();
+
+    // Whatever never started finishes as canceled, so no future is left hanging
+    for (auto& worker : m_workers) {
+        for (int lane = 0; lane < LaneCount; ++lane) {
+            for (QueuedTask& task : worker->lanes[lane])
+                task.task(true);
+        }
+    }
+}
+
+const char* WorkerPool::laneName(Lane lane)
+{
+    switch (lane) {
+    case Interactive:
+        return "interactive";
+    case Decode:
+        return "decode";
+    case Prefetch:
+        return "prefetch";
+    case Indexing:
+        return "indexing";
+    default:
+        return "?";
+    }
+}
+
+void WorkerPool::enqueue(Lane lane, const CancelToken& token, Task task)
+{
+    const int index = t_workerIndex >= 0 ? t_workerIndex : int(m_nextWorker++ % m_workers.size());
+    Worker& worker = *m_workers[index];
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.lanes[lane].push_back({ std::move(task), token, m_clock.nsecsElapsed() });
+    }
+    ++m_counters[lane].queued;
+
+    // A worker going to sleep counts itself before it last checks m_pending,
+    // so either it sees this task or we see it and wake it
+    ++m_pending;
+    if (m_sleeping > 0) {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_wake.notify_one();
+    }
+}
+
+bool WorkerPool::take(int self, Lane& lane, QueuedTask& task)
+{
+    const int count = int(m_workers.size());
+
+    for (int l = 0; l < LaneCount; ++l) {
+        if (m_counters[l].queued <= 0)
+            continue;
+
+        // Our own oldest first, then the newest of the others'
+        for (int offset = 0; offset < count; ++offset) {
+            Worker& worker = *m_workers[(self + offset) % count];
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            std::deque<QueuedTask>& queue = worker.lanes[l];
+            if (queue.empty())
+                continue;
+
+            if (offset == 0) {
+                task = std::move(queue.front());
+                queue.pop_front();
+            } else {
+                task = std::move(queue.back());
+                queue.pop_back();
+            }
+            --m_counters[l].queued;
+            --m_pending;
+            lane = Lane(l);
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkerPool::execute(Lane lane, QueuedTask& task)
+{
+    Counters& counters = m_counters[lane];
+    const qint64 startedNs = m_clock.nsecsElapsed();
+    const bool canceled = m_stopping || task.token.isCanceled();
+
+    ++counters.running;
+    task.task(canceled);
+    task.task = nullptr; // captures go here, not with the next task
+    --counters.running;
+
+    if (canceled) {
+        ++counters.canceled;
+        return;
+    }
+
+    const qint64 latencyNs = m_clock.nsecsElapsed() - task.queuedNs;
+    ++counters.completed;
+    counters.totalWaitNs += startedNs - task.queuedNs;
+    counters.totalLatencyNs += latencyNs;
+    qint64 max = counters.maxLatencyNs;
+    while (latencyNs > max && !counters.maxLatencyNs.compare_exchange_weak(max, latencyNs)) {
+    }
+}
+
+void WorkerPool::workerLoop(int index)
+{
+    t_workerIndex = index;
+
+    for (;;) {
+        Lane lane;
+        QueuedTask task;
+        if (take(index, lane, task)) {
+            execute(lane, task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        ++m_sleeping;
+        m_wake.wait(lock, [this]() { return m_pending > 0 || m_stopping; });
+        --m_sleeping;
+        if (m_stopping)
+            return;
+    }
+}
+
+WorkerPool::LaneStats WorkerPool::stats(Lane lane) const
+{
+    const Counters& counters = m_counters[lane];
+    LaneStats stats;
+    stats.queued = std::max(0, counters.queued.load());
+    stats.running = counters.running;
+    stats.completed = counters.completed;
+    stats.canceled = counters.canceled;
+    if (stats.completed > 0) {
+        stats.averageWaitUs = counters.totalWaitNs / qint64(stats.completed) / 1000;
+        stats.averageLatencyUs = counters.totalLatencyNs / qint64(stats.completed) / 1000;
+    }
+    stats.maxLatencyUs = counters.maxLatencyNs / 1000;
+    return stats;
+}
+
+void WorkerPool::logStats()
+{
+    for (int l = 0; l < LaneCount; ++l) {
+        const LaneStats lane = stats(Lane(l));
+        qDebug().nospace() << "[INFO] pool " << laneName(Lane(l)) << ": queued " << lane.queued << ", running "
+                           << lane.running << ", done " << lane.completed << " (" << lane.canceled << " canceled)"
+                           << ", wait " << lane.averageWaitUs / 1000.0 << " ms, latency "
+                           << lane.averageLatencyUs / 1000.0 << " ms avg, " << lane.maxLatencyUs / 1000.0 << " ms max";
+    }
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QFuture>
+#include <QObject>
+#include <QPromise>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Shared by the owner of some background work and the tasks doing it.
+// Copies share one flag, so a single cancel() covers every task submitted
+// with the token; long tasks may poll isCanceled() to stop early.
+class CancelToken
+{
+public:
+    CancelToken()
+    : m_canceled(std::make_shared<std::atomic<bool>>(false))
+    {
+    }
+
+    void cancel() const { m_canceled->store(true, std::memory_order_relaxed); }
+    bool isCanceled() const { return m_canceled->load(std::memory_order_relaxed); }
+
+private:
+    std::shared_ptr<std::atomic<bool>> m_canceled;
+};
+
+// The process's one pool of background threads, in place of QThreadPool and
+// ad hoc std::threads.
+//
+// One worker per CPU (at least two), each with its own queue per lane. Tasks
+// submitted from a worker stay on its queue; others are spread round-robin.
+// An idle worker takes the oldest task of the most urgent non-empty lane from
+// its own queue, else steals the newest from another worker's, so a
+// keystroke's search never waits behind a queue of icon decodes. Running
+// tasks are not preempted: keep them short, or split them up.
+//
+// Results come back through the returned QFuture; continue with
+// future.then(context, ...), which runs on the context's thread and is
+// dropped if the context is gone by then. A task whose token (or future) is
+// canceled before it starts never runs, and its continuations are skipped.
+//
+// Per lane, queue depth, running tasks and latency (queued to finished) are
+// kept; stats() reads them, and HEX_POOL_STATS=<seconds> logs them at that
+// period.
+class WorkerPool : public QObject
+{
+    Q_OBJECT
+public:
+    // Most urgent first
+    enum Lane {
+        Interactive, // the user is waiting on it: search, a click
+        Decode, // something on screen needs it: icons, thumbnails, wallpaper
+        Prefetch, // about to be needed
+        Indexing, // whenever there is time
+        LaneCount
+    };
+
+    struct LaneStats {
+        int queued = 0;
+        int running = 0;
+        quint64 completed = 0;
+        quint64 canceled = 0;
+        qint64 averageWaitUs = 0; // queued to started
+        qint64 averageLatencyUs = 0; // queued to finished
+        qint64 maxLatencyUs = 0;
+    };
+
+    static WorkerPool* instance();
+    ~WorkerPool() override;
+
+    // Runs work() on a worker; it must not throw, nor touch QObjects of
+    // other threads.
+    template <typename Work>
+    auto run(Lane lane, Work work, const CancelToken& token = {}) -> QFuture<std::invoke_result_t<Work>>;
+
+    int threadCount() const { return int(m_workers.size()); }
+    LaneStats stats(Lane lane) const;
+    static const char* laneName(Lane lane);
+
+private:
+    // Told whether it was canceled before it could start
+    using Task = std::function<void(bool canceled)>;
+
+    struct QueuedTask {
+        Task task;
+        CancelToken token;
+        qint64 queuedNs = 0;
+    };
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<QueuedTask> lanes[LaneCount];
+        std::thread thread;
+    };
+
+    struct Counters {
+        std::atomic<int> queued { 0 };
+        std::atomic<int> running { 0 };
+        std::atomic<quint64> completed { 0 };
+        std::atomic<quint64> canceled { 0 };
+        std::atomic<qint64> totalWaitNs { 0 };
+        std::atomic<qint64> totalLatencyNs { 0 };
+        std::atomic<qint64> maxLatencyNs { 0 };
+    };
+
+    explicit WorkerPool(QObject* parent);
+    void enqueue(Lane lane, const CancelToken& token, Task task);
+    bool take(int self, Lane& lane, QueuedTask& task);
+    void execute(Lane lane, QueuedTask& task);
+    void workerLoop(int index);
+    void logStats();
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    Counters m_counters[LaneCount];
+    QElapsedTimer m_clock;
+
+    std::atomic<int> m_pending { 0 };
+    std::atomic<int> m_sleeping { 0 };
+    std::atomic<unsigned> m_nextWorker { 0 };
+    std::atomic<bool> m_stopping { false };
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wake;
+};
+
+template <typename Work>
+auto WorkerPool::run(Lane lane, Work work, const CancelToken& token) -> QFuture<std::invoke_result_t<Work>>
+{
+    using Result = std::invoke_result_t<Work>;
+
+    // QPromise is move-only and Task a std::function
+    auto promise = std::make_shared<QPromise<Result>>();
+    QFuture<Result> future = promise->future();
+    promise->start();
+
+    enqueue(lane, token, [promise, work = std::move(work)](bool canceled) mutable {
+        if (canceled || promise->isCanceled()) {
+            promise->future().cancel();
+        } else if constexpr (std::is_void_v<Result>) {
+            work();
+        } else {
+            promise->addResult(work());
+        }
+        promise->finish();
+    });
+    return future;
+}
@@ -39,14 +39,6 @@ Item {
         onClicked: console.log("Hexagon clicked")
     }
 
-    // --- Timer to update battery ---
-    Timer {
-        interval: 10000
-        running: true
-        repeat: true
-        onTriggered: batteryProvider.updateBattery()
-    }
-
     // --- Column for battery UI ---
     Column {
         anchors.centerIn: parent
@@ -30,14 +30,6 @@ Item {
         }
     }
 
-    // --- Auto-update Timer ---
-    Timer {
-        interval: 5000
-        running: true
-        repeat: true
-        onTriggered: networkProvider.updateNetworkInfo()
-    }
-
     // --- Network Info Display ---
     Column {
         anchors.centerIn: parent
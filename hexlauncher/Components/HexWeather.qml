@@ -7,48 +7,14 @@ Item {
     id: hexWeather
 
 
-    property string city: appModel.weatherLocation
-    property string temperature: "--°C"
-    property string condition: "Loading..."
-    property string icon: ""
+    // Fetching, caching and backoff live in WeatherProvider (weather.cpp)
+    property string city: weatherProvider.city
+    property string temperature: weatherProvider.temperature
+    property string condition: weatherProvider.condition
+    property url icon: weatherProvider.icon
     property color hexFillColor: "#222"
     property real borderWidth: 2
 
-    function updateWeather() {
-        if (city === "") return;
-        var xhr = new XMLHttpRequest();
-        var apiKey = appModel.apiKey;
-        var url = "https://api.openweathermap.org/data/2.5/weather?q=" + city + "&appid=" + apiKey + "&units=metric";
-
-        xhr.onreadystatechange = function() {
-            if (xhr.readyState === XMLHttpRequest.DONE) {
-                if (xhr.status === 200) {
-                    var response = JSON.parse(xhr.responseText);
-                    hexWeather.temperature = Math.round(response.main.temp) + "°C";
-                    hexWeather.condition = response.weather[0].main;
-                    hexWeather.icon = response.weather[0].icon;
-                } else {
-                    hexWeather.temperature = "--°C";
-                    hexWeather.condition = "N/A";
-                    hexWeather.icon = "";
-                    console.log("Failed to fetch weather: " + xhr.status);
-                }
-            }
-        }
-
-        xhr.open("GET", url);
-        xhr.send();
-    }
-
-    Timer {
-        interval: 10000
-        running: true
-        repeat: true
-        onTriggered: hexWeather.updateWeather()
-    }
-
-    Component.onCompleted: hexWeather.updateWeather()
-
     // --- Hexagon Shape ---
     Shape {
         anchors.fill: parent
@@ -86,10 +52,7 @@ Item {
             horizontalAlignment: Text.AlignHCenter
             anchors.horizontalCenter: parent.horizontalCenter
             background: Rectangle { color: "transparent" }
-            onEditingFinished: {
-                hexWeather.city = text
-                hexWeather.updateWeather()
-            }
+            onEditingFinished: weatherProvider.city = text
         }
 
         Row {
@@ -97,9 +60,10 @@ Item {
             spacing: 4
 
             Image {
-                source: hexWeather.icon !== "" ? "https://openweathermap.org/img/wn/" + hexWeather.icon + "@2x.png" : ""
+                source: hexWeather.icon
                 width: 32
                 height: 32
+                sourceSize: Qt.size(64, 64)
                 fillMode: Image.PreserveAspectFit
             }
 
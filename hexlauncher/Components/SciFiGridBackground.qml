@@ -109,7 +109,7 @@ Item {
             Timer {
                 interval: 16
                 repeat: true
-                running: true
+                running: updateScheduler.active
                 onTriggered: {
                     if (!root.closing) {
                         x += speed * 0.016 * direction + mouseXOffset * 1.2
@@ -153,7 +153,7 @@ Item {
             Timer {
                 interval: 16
                 repeat: true
-                running: true
+                running: updateScheduler.active
                 onTriggered: {
                     if (!root.closing) {
                         y += speed * 0.016 * direction + mouseYOffset * 1.2
@@ -185,7 +185,7 @@ Item {
         Timer {
             interval: 16
             repeat: true
-            running: true
+            running: updateScheduler.active
             onTriggered: {
                 if (!root.closing) {
                     hScanline.y += scanlineSpeed * 0.016 + mouseYOffset * 2.5
@@ -208,7 +208,7 @@ Item {
         Timer {
             interval: 16
             repeat: true
-            running: true
+            running: updateScheduler.active
             onTriggered: {
                 if (!root.closing) {
                     vScanline.x += scanlineSpeed * 0.016 + mouseXOffset * 2.5
@@ -73,7 +73,7 @@ Item {
     Timer {
         interval: 33 // ~30 FPS
         repeat: true
-        running: true
+        running: updateScheduler.active
         onTriggered: {
             for (var i=0;i<waves.length;i++){
                 waves[i].phase += speed * 0.033;
@@ -0,0 +1,116 @@
+#include "launchtracker.h"
+
+#include "windowevents.h"
+
+#include <QDebug>
+#include <QFileInfo>
+#include <QProcess>
+#include <QTimer>
+#include <algorithm>
+
+// Launches that never map a window (daemons, single-instance handoffs, ...)
+// are dropped after this long.
+static constexpr int kLaunchTimeoutMs = 30000;
+
+LaunchTracker::LaunchTracker(WindowEventStream* stream, QObject* parent)
+: QObject(parent)
+{
+    connect(stream, &WindowEventStream::windowAdded, this, [this](quint32 id, const QString& appId) {
+        if (!m_streamReady) {
+            m_preexisting.insert(id);
+            return;
+        }
+        considerWindow(id, appId);
+    });
+
+    // Some clients only set their app_id after the first commit.
+    connect(stream, &WindowEventStream::windowChanged, this, [this](quint32 id, const QString& appId) {
+        if (m_streamReady)
+            considerWindow(id, appId);
+    });
+
+    connect(stream, &WindowEventStream::windowClosed, this, [this](quint32 id) {
+        m_preexisting.remove(id);
+        m_claimed.remove(id);
+    });
+
+    connect(stream, &WindowEventStream::ready, this, [this]() {
+        m_streamReady = true;
+    });
+}
+
+bool LaunchTracker::launch(const QString& program, const QStringList& arguments, const QStringList& expectedAppIds)
+{
+    qint64 pid = 0;
+    if (!QProcess::startDetached(program, arguments, QString(), &pid))
+        return false;
+
+    PendingLaunch pending { m_nextSerial++, pid, program, {}, {} };
+    pending.clock.start();
+
+    for (const QString& id : expectedAppIds) {
+        if (!id.isEmpty())
+            pending.expected.append(id);
+    }
+    pending.expected.append(QFileInfo(program).fileName());
+
+    // "flatpak run org.example.App" maps a window with the app's id.
+    if (pending.expected.last() == "flatpak") {
+        for (const QString& arg : arguments) {
+            if (arg.count('.') >= 2 && !arg.startsWith('-'))
+                pending.expected.append(arg);
+        }
+    }
+
+    const quint64 serial = pending.serial;
+    m_pending.append(pending);
+
+    QTimer::singleShot(kLaunchTimeoutMs, this, [this, serial]() {
+        for (int i = 0; i < m_pending.size(); ++i) {
+            if (m_pending[i].serial == serial) {
+                qDebug() << "[INFO] no window for" << m_pending[i].program << "pid" << m_pending[i].pid
+                         << "after" << kLaunchTimeoutMs << "ms";
+                m_pending.removeAt(i);
+                return;
+            }
+        }
+    });
+
+    return true;
+}
+
+void LaunchTracker::considerWindow(quint32 id, const QString& appId)
+{
+    if (m_pending.isEmpty() || appId.isEmpty() || m_preexisting.contains(id) || m_claimed.contains(id))
+        return;
+
+    for (int i = 0; i < m_pending.size(); ++i) {
+        const PendingLaunch& pending = m_pending[i];
+        const bool matched = std::any_of(pending.expected.begin(), pending.expected.end(), [&](const QString& expected) {
+            return appIdMatches(appId, expected);
+        });
+        if (!matched)
+            continue;
+
+        const qint64 latency = pending.clock.elapsed();
+        qDebug() << "[INFO] first window of" << appId << "(pid" << pending.pid << ") after" << latency << "ms";
+
+        m_claimed.insert(id);
+        m_latencies[appId] = latency;
+        m_pending.removeAt(i);
+
+        emit windowAppeared(appId, latency);
+        emit latenciesChanged();
+        return;
+    }
+}
+
+bool LaunchTracker::appIdMatches(const QString& appId, const QString& expected)
+{
+    if (appId.compare(expected, Qt::CaseInsensitive) == 0)
+        return true;
+
+    // Reverse-DNS ids: "org.gnome.Nautilus" should match "nautilus" and vice versa.
+    auto lastComponent = [](const QString& s) { return s.section('.', -1); };
+    return lastComponent(appId).compare(lastComponent(expected), Qt::CaseInsensitive) == 0;
+}
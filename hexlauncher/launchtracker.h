@@ -0,0 +1,52 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+#include <QVariantMap>
+
+class WindowEventStream;
+
+// Correlates launches with the first toplevel they map. Each launch records
+// the spawned PID and the app_ids its window may carry (StartupWMClass,
+// desktop id, program name); toplevel events from WindowEventStream resolve
+// it. Nothing here polls: a launch is forgotten by a one-shot timeout if no
+// window ever shows up.
+class LaunchTracker : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(QVariantMap latencies READ latencies NOTIFY latenciesChanged)
+
+public:
+    explicit LaunchTracker(WindowEventStream* stream, QObject* parent = nullptr);
+
+    bool launch(const QString& program, const QStringList& arguments, const QStringList& expectedAppIds);
+
+    // app_id -> launch-to-first-window latency in ms of its most recent launch
+    QVariantMap latencies() const { return m_latencies; }
+
+signals:
+    void windowAppeared(const QString& appId, qint64 latencyMs);
+    void latenciesChanged();
+
+private:
+    struct PendingLaunch {
+        quint64 serial;
+        qint64 pid;
+        QString program;
+        QStringList expected;
+        QElapsedTimer clock;
+    };
+
+    void considerWindow(quint32 id, const QString& appId);
+    static bool appIdMatches(const QString& appId, const QString& expected);
+
+    QList<PendingLaunch> m_pending;
+    QSet<quint32> m_preexisting; // toplevels already mapped when the stream became ready
+    QSet<quint32> m_claimed; // toplevels already attributed to a launch
+    QVariantMap m_latencies;
+    quint64 m_nextSerial = 1;
+    bool m_streamReady = false;
+};
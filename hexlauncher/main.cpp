@@ -10,6 +10,7 @@
 #include <QLocalSocket>
 #include <QProcess>
 #include <QQmlApplicationEngine>
+#include <QQmlEngine>
 #include <QQmlContext>
 #include <QQuickWindow>
 #include <QRegularExpression>
@@ -17,10 +18,26 @@
 #include <QStandardPaths>
 #include <QTimer>
 #include <algorithm>
+#include <ctime>
+#include <unistd.h>
+
+#include "batterymonitor.h"
+#include "clockservice.h"
+#include "launchtracker.h"
+#include "networkmonitor.h"
+#include "statehub.h"
+#include "thumbnails.h"
+#include "updatescheduler.h"
+#include "weather.h"
+#include "windowevents.h"
+#include "workerpool.h"
 
 class AppModel : public QAbstractListModel {
     Q_OBJECT
     Q_PROPERTY(int count READ rowCount NOTIFY countChanged)
+    // True while a search or list is being built; until then the rows are
+    // the previous query's, and launching from them would start the wrong app
+    Q_PROPERTY(bool pending READ isPending NOTIFY pendingChanged)
     Q_PROPERTY(int hexWidth READ getHexWidth CONSTANT)
     Q_PROPERTY(int hexHeight READ getHexHeight CONSTANT)
     Q_PROPERTY(int hexMargin READ getHexMargin CONSTANT)
@@ -45,13 +62,15 @@ public:
     enum Roles {
         NameRole = Qt::DisplayRole,
         IconRole = Qt::UserRole + 1,
-        ExecRole
+        ExecRole,
+        AppIdRole
     };
 
     struct AppEntry {
         QString name;
         QString icon;
         QString exec;
+        QString appId; // app_id its window is expected to carry (StartupWMClass or desktop id)
     };
 
     explicit AppModel(QObject* parent = nullptr)
@@ -76,6 +95,8 @@ public:
             return app.icon;
         case ExecRole:
             return app.exec;
+        case AppIdRole:
+            return app.appId;
         }
         return {};
     }
@@ -89,6 +110,7 @@ public:
         map["name"] = app.name;
         map["icon"] = app.icon;
         map["exec"] = app.exec;
+        map["appId"] = app.appId;
         return map;
     }
 
@@ -97,13 +119,16 @@ public:
         return {
             { NameRole, "name" },
             { IconRole, "icon" },
-            { ExecRole, "exec" }
+            { ExecRole, "exec" },
+            { AppIdRole, "appId" }
         };
     }
 
     Q_INVOKABLE void loadFromIni(const QString& path)
     {
         m_configPath = path;
+        m_listToken.cancel(); // a search still running would land on top
+        setPending(false);
         apps.clear();
         QSettings settings(path, QSettings::IniFormat);
 
@@ -143,7 +168,8 @@ public:
             AppEntry entry {
                 settings.value("Name").toString(),
                 resolveIcon(settings.value("Icon").toString()),
-                sanitizeExec(settings.value("Exec").toString())
+                sanitizeExec(settings.value("Exec").toString()),
+                settings.value("StartupWMClass").toString()
             };
             settings.endGroup();
             apps.append(entry);
@@ -153,7 +179,7 @@ public:
     }
 
     // Helper function to calculate relevance
-    int relevanceScore(const QString &content, const QString &query) {
+    static int relevanceScore(const QString &content, const QString &query) {
         QString lowerContent = content.toLower();
         QString lowerQuery = query.toLower();
 
@@ -170,7 +196,7 @@ public:
     };
 
     // Helper function to calculate relevance with app name prioritized
-    int relevanceScore(const QString &name, const QString &content, const QString &query) {
+    static int relevanceScore(const QString &name, const QString &content, const QString &query) {
         QString lowerName = name.toLower();
         QString lowerContent = content.toLower();
         QString lowerQuery = query.toLower();
@@ -185,15 +211,28 @@ public:
         return 0; // no match
     }
 
+    // Desktop files are read on the pool, not per keystroke on the GUI
+    // thread; the list is swapped in when done. A newer query or list
+    // cancels one still being built.
     Q_INVOKABLE void searchDesktopFiles(const QString &query)
     {
-        apps.clear();
+        const int maxCount = m_iconGrid * m_iconGrid;
+        setAppsAsync([query, maxCount](const CancelToken& token) { return searchApps(query, maxCount, token); });
+    }
+
+    Q_INVOKABLE void loadAllDesktopFiles()
+    {
+        setAppsAsync([](const CancelToken& token) { return allApps(token); });
+    }
+
+    static QList<AppEntry> searchApps(const QString &query, int maxCount, const CancelToken &token)
+    {
+        QList<AppEntry> apps;
         const QStringList locations = {
             "/usr/share/applications",
             QStandardPaths::writableLocation(QStandardPaths::ApplicationsLocation)
         };
 
-        int maxCount = m_iconGrid * m_iconGrid;
         bool foundAny = false;
 
         QVector<ScoredApp> scoredApps;
@@ -220,7 +259,7 @@ public:
             QFileInfoList fileList = dir.entryInfoList(QStringList() << "*.desktop", QDir::Files);
 
             for (const QFileInfo &fileInfo : fileList) {
-                if (scoredApps.size() >= maxCount)
+                if (scoredApps.size() >= maxCount || token.isCanceled())
                     break;
 
                 QFile file(fileInfo.absoluteFilePath());
@@ -271,6 +310,7 @@ public:
                 QString name = desktopData.value("Name", "");
                 QString exec = desktopData.value("Exec", "");
                 QString icon = desktopData.value("Icon", "");
+                QString appId = desktopData.value("StartupWMClass", fileInfo.completeBaseName());
 
                 // Combine searchable content including translations and keywords
                 QString searchContent;
@@ -287,7 +327,7 @@ public:
                 if (matchesQuery(combinedContent)) {
                     QString keyMain = computeKey(name, exec);
                     if (!seenApps.contains(keyMain)) {
-                        AppEntry entry { name, resolveIcon(icon), sanitizeExec(exec) };
+                        AppEntry entry { name, resolveIcon(icon), sanitizeExec(exec), appId };
                         int score = relevanceScore(name, searchContent, query);
                         scoredApps.append({ entry, score });
                         seenApps.insert(keyMain);
@@ -324,7 +364,7 @@ public:
                     if (actionScore <= 0)
                         actionScore = 5; // minimal score
 
-                        AppEntry actionEntry { actionName, resolveIcon(actionIcon), sanitizeExec(actionExec) };
+                        AppEntry actionEntry { actionName, resolveIcon(actionIcon), sanitizeExec(actionExec), appId };
                     scoredApps.append({ actionEntry, actionScore });
 
                     seenApps.insert(actionKey);
@@ -344,15 +384,14 @@ public:
             apps.append(s.app);
 
         if (!foundAny)
-            apps.append({ "No results found", "", "" });
+            apps.append({ "No results found", "", "", "" });
 
-        emit countChanged();
+        return apps;
     }
 
-
-    Q_INVOKABLE void loadAllDesktopFiles()
+    static QList<AppEntry> allApps(const CancelToken &token)
     {
-        apps.clear();
+        QList<AppEntry> apps;
 
         const QStringList locations = {
             "/usr/share/applications",
@@ -364,6 +403,9 @@ public:
             QFileInfoList fileList = dir.entryInfoList(QStringList() << "*.desktop", QDir::Files);
 
             for (const QFileInfo& fileInfo : fileList) {
+                if (token.isCanceled())
+                    return apps;
+
                 QSettings desktopFile(fileInfo.absoluteFilePath(), QSettings::IniFormat);
                 desktopFile.beginGroup("Desktop Entry");
 
@@ -385,10 +427,12 @@ public:
                 QString name = desktopFile.value("Name").toString();
                 QString exec = desktopFile.value("Exec").toString();
                 QString icon = desktopFile.value("Icon").toString();
+                QString appId = desktopFile.value("StartupWMClass", fileInfo.completeBaseName()).toString();
 
                 apps.append({ name,
                     resolveIcon(icon),
-                    sanitizeExec(exec) });
+                    sanitizeExec(exec),
+                    appId });
 
                 desktopFile.endGroup();
             }
@@ -399,7 +443,7 @@ public:
             return a.name.toLower() < b.name.toLower();
         });
 
-        emit countChanged();
+        return apps;
     }
 
     int getHexWidth() const { return m_hexWidth; }
@@ -419,11 +463,13 @@ public:
     QString getWeatherLocation() const { return m_weatherLocation; }
     QString getMainFont() const { return m_mainFont; }
     QString getSubFont() const { return m_subFont; }
+    bool isPending() const { return m_pending; }
 
 
 
 Q_SIGNALS:
     void countChanged();
+    void pendingChanged();
 
 private:
     QList<AppEntry> apps;
@@ -438,8 +484,37 @@ private:
     QString m_weatherLocation;
     QString m_mainFont;
     QString m_subFont;
+    CancelToken m_listToken;
+    bool m_pending = false;
+
+    void setAppsAsync(std::function<QList<AppEntry>(const CancelToken&)> build)
+    {
+        m_listToken.cancel();
+        m_listToken = CancelToken();
+        setPending(true);
+
+        const CancelToken token = m_listToken;
+        WorkerPool::instance()
+            ->run(WorkerPool::Interactive, [build, token]() { return build(token); }, token)
+            .then(this, [this, token](const QList<AppEntry>& result) {
+                // Canceled while it ran: a newer list is on its way
+                if (token.isCanceled())
+                    return;
+                apps = result;
+                emit countChanged();
+                setPending(false);
+            });
+    }
 
-    QString resolveIcon(const QString& name)
+    void setPending(bool pending)
+    {
+        if (pending == m_pending)
+            return;
+        m_pending = pending;
+        emit pendingChanged();
+    }
+
+    static QString resolveIcon(const QString& name)
     {
         if (QFile::exists(name))
             return name;
@@ -467,7 +542,7 @@ private:
         return "";
     }
 
-    QString sanitizeExec(const QString& exec) const
+    static QString sanitizeExec(const QString& exec)
     {
         QStringList parts = exec.split(' ', Qt::SkipEmptyParts);
         auto it = std::remove_if(parts.begin(), parts.end(), [](const QString& part) {
@@ -480,6 +555,21 @@ private:
 
 class LauncherHelper : public QObject {
     Q_OBJECT
+    Q_PROPERTY(QVariantMap launchLatencies READ launchLatencies NOTIFY launchLatenciesChanged)
+
+public:
+    explicit LauncherHelper(LaunchTracker* tracker, QObject* parent = nullptr)
+        : QObject(parent)
+        , m_tracker(tracker)
+    {
+        connect(m_tracker, &LaunchTracker::latenciesChanged, this, &LauncherHelper::launchLatenciesChanged);
+    }
+
+    QVariantMap launchLatencies() const { return m_tracker->latencies(); }
+
+signals:
+    void launchLatenciesChanged();
+
 public slots:
     void launch(const QString& command)
     {
@@ -494,7 +584,10 @@ public slots:
         }
     }
 
-    Q_INVOKABLE void launchAndRefresh(const QString& command, QObject* modelObj)
+    // Launch while the launcher stays open. The running-window strip follows
+    // the window event stream, so there is nothing to refresh here; the
+    // tracker only matches the new toplevel to this launch.
+    Q_INVOKABLE void launchAndRefresh(const QString& command, const QString& appId)
     {
         QString cleaned = command;
         cleaned.remove(QRegularExpression(R"(%[a-zA-Z])"));
@@ -504,32 +597,11 @@ public slots:
             return;
 
         QString program = parts.takeFirst();
-        QProcess::startDetached(program, parts);
-
-        // Refresh multiple times after app launch
-        QTimer* timer = new QTimer(modelObj); // parent to modelObj for safe cleanup
-        int* refreshCount = new int(0); // counter on heap for lambda capture
-
-        timer->setInterval(400); // adjust delay between refreshes if needed
-
-        QObject::connect(timer, &QTimer::timeout, [timer, modelObj, refreshCount]() {
-            QProcess proc;
-            proc.start("list-windows");
-            proc.waitForFinished(700);
-
-            QMetaObject::invokeMethod(modelObj, "refresh", Qt::QueuedConnection);
-            (*refreshCount)++;
-
-            if (*refreshCount >= 3) {
-                timer->stop();
-                timer->deleteLater();
-                delete refreshCount;
-            }
-        });
-
-        // Start after slight delay
-        QTimer::singleShot(700, timer, SLOT(start()));
+        m_tracker->launch(program, parts, { appId });
     }
+
+private:
+    LaunchTracker* m_tracker;
 };
 
 class RunningWindowModel : public QAbstractListModel {
@@ -540,7 +612,8 @@ public:
         TitleRole = Qt::UserRole + 1,
         AppIdRole,
         FocusedRole,
-        IconRole
+        IconRole,
+        ThumbnailRole
     };
 
     Q_INVOKABLE void refresh()
@@ -549,49 +622,51 @@ public:
         loadFromIni(iniPath);
     }
 
+    // Both go by the stream's id, which stays with the window when its
+    // title changes or another window shares it. windows.ini carries the ids
+    // of the list-windows that wrote it, so they are only used once this
+    // stream is ready; its first windowsChanged has reloaded the model by then.
     Q_INVOKABLE void activate(int index)
     {
-        if (index < 0 || index >= windows.size())
+        if (index < 0 || index >= windows.size() || !m_events->isReady())
             return;
 
-        QString title = windows[index].title;
-        QString program = "list-windows";
-        QStringList arguments = { "--activate", title };
-
-        QProcess::startDetached(program, arguments);
+        m_events->activate(windows[index].id);
     }
 
     Q_INVOKABLE void close(int index)
     {
-        if (index < 0 || index >= windows.size())
+        if (index < 0 || index >= windows.size() || !m_events->isReady())
             return;
 
-        QString title = windows[index].title;
-        QString program = "list-windows";
-        QStringList closeArgs = { "--close", title };
-
-        if (QProcess::startDetached(program, closeArgs)) {
-            // Refresh once after 300ms
-            QTimer::singleShot(300, this, &RunningWindowModel::refresh);
-        }
+        // The "closed" event from the window stream refreshes the model.
+        m_events->close(windows[index].id);
     }
 
 
 
     struct WindowEntry {
+        quint32 id;
         QString title;
         QString app_id;
         bool focused;
         QString icon;
     };
 
-    RunningWindowModel(QObject* parent = nullptr)
+    RunningWindowModel(WindowEventStream* events, ThumbnailCapture* thumbnails, QObject* parent = nullptr)
         : QAbstractListModel(parent)
+        , m_events(events)
+        , m_thumbnails(thumbnails)
     {
-        // First immediate refresh
-        refresh(); // immediate attempt
-        QTimer::singleShot(300, this, &RunningWindowModel::refresh); // catch INI write
+        // Last known state; the window stream refreshes again once it is ready
+        refresh();
 
+        connect(m_thumbnails, &ThumbnailCapture::thumbnailChanged, this, [this](quint32 windowId) {
+            for (int row = 0; row < windows.size(); ++row) {
+                if (windows[row].id == windowId)
+                    emit dataChanged(index(row), index(row), { ThumbnailRole });
+            }
+        });
     }
 
     int rowCount(const QModelIndex& parent = QModelIndex()) const override
@@ -615,6 +690,8 @@ public:
             return win.focused;
         case IconRole:
             return win.icon;
+        case ThumbnailRole:
+            return m_thumbnails->thumbnailUrl(win.id);
         default:
             return {};
         }
@@ -626,11 +703,14 @@ public:
             { TitleRole, "title" },
             { AppIdRole, "app_id" },
             { FocusedRole, "focused" },
-            { IconRole, "icon" }
+            { IconRole, "icon" },
+            { ThumbnailRole, "thumbnail" }
         };
     }
 
 private:
+    WindowEventStream* m_events;
+    ThumbnailCapture* m_thumbnails;
     QList<WindowEntry> windows;
 
     void loadFromIni(const QString& path)
@@ -644,12 +724,13 @@ private:
         QSettings ini(path, QSettings::IniFormat);
         for (const QString& group : ini.childGroups()) {
             ini.beginGroup(group);
+            quint32 id = ini.value("ID").toUInt();
             QString title = ini.value("Title").toString();
             QString app_id = ini.value("AppID").toString();
             bool focused = ini.value("Focused").toBool();
             QString iconName = findIconNameFromDesktopFile(app_id);
             QString iconPath = resolveIcon(iconName);
-            windows.append({ title, app_id, focused, iconPath });
+            windows.append({ id, title, app_id, focused, iconPath });
             ini.endGroup();
         }
 
@@ -719,66 +800,42 @@ private:
     }
 };
 
+// Network and battery come from the hexstate daemon when it runs (a memory
+// read, pushed on change); otherwise the providers run their own monitors.
 class NetworkInfoProvider : public QObject {
     Q_OBJECT
     Q_PROPERTY(QString networkType READ networkType NOTIFY networkChanged)
     Q_PROPERTY(QString networkName READ networkName NOTIFY networkChanged)
 
 public:
-    explicit NetworkInfoProvider(QObject* parent = nullptr)
+    explicit NetworkInfoProvider(StateHubClient* hub, QObject* parent = nullptr)
         : QObject(parent)
+        , m_hub(hub)
     {
-        updateNetworkInfo();
+        if (!m_hub->isAvailable()) {
+            startMonitor();
+            return;
+        }
+
+        connect(m_hub, &StateHubClient::changed, this, [this](quint32 fields) {
+            if (m_monitor)
+                return;
+            // The daemon went away: carry on with our own monitor
+            if (!m_hub->isAvailable())
+                startMonitor();
+            if (fields & (HexStateField::Network | HexStateField::Online))
+                emit networkChanged();
+        });
     }
 
-    QString networkType() const { return m_type; }
-    QString networkName() const { return m_name; }
+    QString networkType() const { return m_monitor ? m_monitor->type() : m_hub->state().networkType; }
+    QString networkName() const { return m_monitor ? m_monitor->name() : m_hub->state().networkName; }
 
 public slots:
     void updateNetworkInfo()
     {
-        QProcess proc;
-        proc.start("ip", { "route", "get", "8.8.8.8" });
-        proc.waitForFinished();
-        QString output = QString::fromUtf8(proc.readAllStandardOutput()).trimmed();
-
-        QRegularExpression ifaceRegex(R"(dev\s+(\w+))");
-        QRegularExpressionMatch match = ifaceRegex.match(output);
-        if (!match.hasMatch()) {
-            m_type = "Disconnected";
-            m_name = "";
-            emit networkChanged();
-            return;
-        }
-
-        QString iface = match.captured(1);
-        QString newType;
-        QString newName;
-
-        if (iface.startsWith("wlan")) {
-            newType = "Wi-Fi";
-
-            QProcess wifiProc;
-            wifiProc.start("iwgetid", QStringList() << "-r");
-            wifiProc.waitForFinished();
-            newName = QString::fromUtf8(wifiProc.readAllStandardOutput()).trimmed();
-
-        } else if (iface.startsWith("eth")) {
-            newType = "Ethernet";
-            newName = iface;
-        } else if (iface.startsWith("usb") || iface.contains("rndis") || iface.contains("enx") || iface.contains("enp")) {
-            newType = "USB Tethering";
-            newName = iface;
-        } else {
-            newType = "Unknown";
-            newName = iface;
-        }
-
-        if (newType != m_type || newName != m_name) {
-            m_type = newType;
-            m_name = newName;
-            emit networkChanged();
-        }
+        if (m_monitor)
+            m_monitor->refresh();
     }
 
     void openNetworkManager()
@@ -790,8 +847,15 @@ signals:
     void networkChanged();
 
 private:
-    QString m_type = "Disconnected";
-    QString m_name = "";
+    void startMonitor()
+    {
+        // Event driven: rtnetlink/nl80211 tell the monitor when to look again
+        m_monitor = new NetworkMonitor(this);
+        connect(m_monitor, &NetworkMonitor::changed, this, &NetworkInfoProvider::networkChanged);
+    }
+
+    StateHubClient* m_hub;
+    NetworkMonitor* m_monitor = nullptr;
 };
 
 class BatteryInfoProvider : public QObject {
@@ -800,62 +864,49 @@ class BatteryInfoProvider : public QObject {
     Q_PROPERTY(QString status READ status NOTIFY batteryChanged)
 
 public:
-    explicit BatteryInfoProvider(QObject* parent = nullptr)
+    explicit BatteryInfoProvider(StateHubClient* hub, QObject* parent = nullptr)
         : QObject(parent)
+        , m_hub(hub)
     {
-        updateBattery();
+        if (!m_hub->isAvailable()) {
+            startMonitor();
+            return;
+        }
+
+        connect(m_hub, &StateHubClient::changed, this, [this](quint32 fields) {
+            if (m_monitor)
+                return;
+            // The daemon went away: carry on with our own monitor
+            if (!m_hub->isAvailable())
+                startMonitor();
+            if (fields & (HexStateField::Battery | HexStateField::Online))
+                emit batteryChanged();
+        });
     }
 
-    int percentage() const { return m_percentage; }
-    QString status() const { return m_status; }
+    int percentage() const { return m_monitor ? m_monitor->percentage() : m_hub->state().batteryPercent; }
+    QString status() const { return m_monitor ? m_monitor->status() : m_hub->state().batteryStatus; }
 
 public slots:
     void updateBattery()
     {
-        QString basePath = "/sys/class/power_supply/";
-
-        // Try to find battery directory (BAT0 or BAT1)
-        QString batteryDir;
-        QDir powerDir(basePath);
-        for (const QString& entry : powerDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
-            if (entry.startsWith("BAT")) {
-                batteryDir = basePath + entry;
-                break;
-            }
-        }
-
-        if (batteryDir.isEmpty()) {
-            m_percentage = -1;
-            m_status = "Unavailable";
-            emit batteryChanged();
-            return;
-        }
-
-        QFile capacityFile(batteryDir + "/capacity");
-        QFile statusFile(batteryDir + "/status");
-
-        if (capacityFile.open(QIODevice::ReadOnly) && statusFile.open(QIODevice::ReadOnly)) {
-            int percent = QString(capacityFile.readAll()).trimmed().toInt();
-            QString stat = QString(statusFile.readAll()).trimmed();
-
-            if (percent != m_percentage || stat != m_status) {
-                m_percentage = percent;
-                m_status = stat;
-                emit batteryChanged();
-            }
-        } else {
-            m_percentage = -1;
-            m_status = "Unknown";
-            emit batteryChanged();
-        }
+        if (m_monitor)
+            m_monitor->refresh();
     }
 
 signals:
     void batteryChanged();
 
 private:
-    int m_percentage = -1;
-    QString m_status = "Unknown";
+    void startMonitor()
+    {
+        // Pushed by power_supply uevents, plus its own once-a-minute re-read
+        m_monitor = new BatteryMonitor(this);
+        connect(m_monitor, &BatteryMonitor::changed, this, &BatteryInfoProvider::batteryChanged);
+    }
+
+    StateHubClient* m_hub;
+    BatteryMonitor* m_monitor = nullptr;
 };
 
 class PowerControl : public QObject {
@@ -887,6 +938,45 @@ public:
 };
 
 
+// HEX_EXEC_STAMP: set by whoever exec'd us just before the exec (open-bench
+// does), that moment in CLOCK_MONOTONIC ms, the clock hexswitch stamps its
+// presses in. Taken out of the environment so the apps started from here do
+// not inherit it. -1 if unset.
+double takeExecStamp()
+{
+    bool stamped = false;
+    const double execMs = qEnvironmentVariable("HEX_EXEC_STAMP").toDouble(&stamped);
+    qunsetenv("HEX_EXEC_STAMP");
+    return stamped && execMs > 0 ? execMs : -1;
+}
+
+// Milliseconds since this process was exec'd: from execMs (takeExecStamp())
+// if known, otherwise /proc/self/stat starttime against CLOCK_BOOTTIME, which
+// only has clock-tick (usually 10 ms) resolution.
+double msSinceProcessStart(double execMs)
+{
+    if (execMs > 0) {
+        timespec now {};
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return now.tv_sec * 1000.0 + now.tv_nsec / 1e6 - execMs;
+    }
+
+    QFile stat("/proc/self/stat");
+    if (!stat.open(QIODevice::ReadOnly))
+        return -1;
+
+    // Field 22; skip past the parenthesised comm, which may contain spaces
+    const QByteArray line = stat.readAll();
+    const QList<QByteArray> fields = line.mid(line.lastIndexOf(')') + 2).split(' ');
+    if (fields.size() < 20)
+        return -1;
+
+    const double startSec = fields[19].toULongLong() / double(sysconf(_SC_CLK_TCK));
+    timespec now {};
+    clock_gettime(CLOCK_BOOTTIME, &now);
+    return (now.tv_sec + now.tv_nsec / 1e9 - startSec) * 1000.0;
+}
+
 // Ensure default keys in [Widgets] section
 void ensureWidgetsSection(const QString &path)
 {
@@ -918,6 +1008,7 @@ void ensureWallpaperSection(const QString &path)
 
 int main(int argc, char* argv[])
 {
+    const double execMs = takeExecStamp();
     QGuiApplication app(argc, argv);
     const QString serverName = "hexlauncher-single-instance";
 
@@ -932,13 +1023,15 @@ int main(int argc, char* argv[])
     if (!server.listen(serverName))
         return 1;
 
-    // Launch list-windows on start
-    QString program = "list-windows";
-    if (!QProcess::startDetached(program)) {
-        qWarning() << "[WARN] Failed to start list-windows!";
-    } else {
-        qDebug() << "[INFO] list-windows started successfully.";
-    }
+    // Keep list-windows running for the lifetime of the launcher; it rewrites
+    // windows.ini and reports every toplevel change as it happens.
+    WindowEventStream windowEvents;
+    windowEvents.start();
+    LaunchTracker launchTracker(&windowEvents);
+    ThumbnailCapture thumbnails(&windowEvents);
+    UpdateScheduler scheduler;
+    StateHubClient stateHub;
+    stateHub.startWatching();
 
     //  Define config path once
     QString configDir = QStandardPaths::writableLocation(QStandardPaths::ConfigLocation) + "/hexlauncher";
@@ -967,6 +1060,7 @@ int main(int argc, char* argv[])
     settings.endGroup();
 
     //   Set up QML context
+    qmlRegisterType<WorldClock>("Hex", 1, 0, "WorldClock");
     QQmlApplicationEngine engine;
     engine.rootContext()->setContextProperty("appModel", model);
     engine.rootContext()->setContextProperty("configPath", configPath);
@@ -979,16 +1073,24 @@ int main(int argc, char* argv[])
     engine.rootContext()->setContextProperty("showsciFiBg", showsciFiBg);
 
     // Other models and providers
-    RunningWindowModel* winModel = new RunningWindowModel;
+    engine.addImageProvider("thumbnails", new ThumbnailImageProvider(&thumbnails));
+
+    RunningWindowModel* winModel = new RunningWindowModel(&windowEvents, &thumbnails);
+    QObject::connect(&windowEvents, &WindowEventStream::windowsChanged, winModel, &RunningWindowModel::refresh);
     engine.rootContext()->setContextProperty("runningWindows", winModel);
 
-    NetworkInfoProvider* networkProvider = new NetworkInfoProvider;
+    NetworkInfoProvider* networkProvider = new NetworkInfoProvider(&stateHub);
     engine.rootContext()->setContextProperty("networkProvider", networkProvider);
 
-    BatteryInfoProvider* batteryProvider = new BatteryInfoProvider;
+    BatteryInfoProvider* batteryProvider = new BatteryInfoProvider(&stateHub);
     engine.rootContext()->setContextProperty("batteryProvider", batteryProvider);
 
-    LauncherHelper launcher;
+    engine.rootContext()->setContextProperty("updateScheduler", &scheduler);
+
+    WeatherProvider* weatherProvider = new WeatherProvider(configPath, &scheduler);
+    engine.rootContext()->setContextProperty("weatherProvider", weatherProvider);
+
+    LauncherHelper launcher(&launchTracker);
     engine.rootContext()->setContextProperty("launcher", &launcher);
 
     PowerControl powerControl;
@@ -1021,6 +1123,16 @@ int main(int argc, char* argv[])
     layerWindow->setExclusiveZone(0);
 
     window->setFlags(Qt::FramelessWindowHint | Qt::WindowStaysOnTopHint);
+
+    // Widgets, animations and capture only run while the launcher can be seen
+    scheduler.watchWindow(window);
+    QObject::connect(&scheduler, &UpdateScheduler::activeChanged, &thumbnails, &ThumbnailCapture::setActive);
+
+    // Open latency: exec -> first frame, to compare against hexswitch-server
+    QObject::connect(window, &QQuickWindow::frameSwapped, window, [execMs]() {
+        qDebug() << "[INFO] launcher open latency" << msSinceProcessStart(execMs) << "ms";
+    }, Qt::ConnectionType(Qt::DirectConnection | Qt::SingleShotConnection));
+
     window->showFullScreen();
 
     return app.exec();
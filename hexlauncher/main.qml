@@ -131,6 +131,21 @@ Window {
     ListModel {
         id: pageModel
     }
+
+    // A search lands after the keystroke that asked for it. Refresh the page
+    // even if the count stayed the same, and run an Enter that came early.
+    Connections {
+        target: appModel
+        function onPendingChanged() {
+            if (appModel.pending)
+                return;
+            updatePageModel();
+            if (searchField.launchWhenReady) {
+                searchField.launchWhenReady = false;
+                searchField.launchFirst();
+            }
+        }
+    }
     //----------------------------------------Widgets--------------------------------------------
 
     Item {
@@ -302,13 +317,31 @@ Window {
                             Item {
                                 anchors.fill: parent
 
+                                // Live thumbnail, when the compositor can provide one
                                 Image {
-                                    property string cleanedIcon: model.icon.startsWith("qrc:/") ? model.icon.slice(4) : model.icon
+                                    id: thumbnailImage
 
                                     anchors.centerIn: parent
-                                    width: hexagon.width * 0.5
+                                    width: hexagon.width * 0.8
                                     height: hexagon.height * 0.5
                                     fillMode: Image.PreserveAspectFit
+                                    cache: false
+                                    source: model.thumbnail
+                                    visible: status === Image.Ready
+                                }
+
+                                // App icon; shrinks to a badge once the thumbnail shows
+                                Image {
+                                    property string cleanedIcon: model.icon.startsWith("qrc:/") ? model.icon.slice(4) : model.icon
+                                    property bool badge: thumbnailImage.visible
+
+                                    anchors.horizontalCenter: parent.horizontalCenter
+                                    anchors.verticalCenter: badge ? undefined : parent.verticalCenter
+                                    anchors.bottom: badge ? parent.bottom : undefined
+                                    anchors.bottomMargin: hexagon.height * 0.08
+                                    width: hexagon.width * (badge ? 0.2 : 0.5)
+                                    height: hexagon.height * (badge ? 0.2 : 0.5)
+                                    fillMode: Image.PreserveAspectFit
                                     source: cleanedIcon.startsWith("/") ? "file:" + cleanedIcon : cleanedIcon
                                 }
 
@@ -481,6 +514,24 @@ Window {
         TextField {
             id: searchField
 
+            // Enter pressed while the search for the current text was still
+            // running: launch its first result once it is in
+            property bool launchWhenReady: false
+
+            function launchFirst() {
+                if (pageModel.count > 0) {
+                    const item = repeater.itemAt(0);
+                    if (item && item.parentSequential) {
+                        item.parentSequential.running = true;
+                    } else {
+                        // Fallback in case the animation is not found (e.g. during initial load)
+                        const firstApp = pageModel.get(0);
+                        launcher.launch(firstApp.exec);
+                        Qt.quit();
+                    }
+                }
+            }
+
             // logic to show what appmodel to load
             function updateAppList() {
                 if (text === "") {
@@ -506,6 +557,7 @@ Window {
             selectionColor: "#00aaff"
             background: null
             onTextChanged: {
+                launchWhenReady = false; // that Enter was for other text
                 root.currentIndex = 0; //selected first item on each search text input.
                 updateAppList(); //updates model on search text
             }
@@ -559,18 +611,11 @@ Window {
                     event.accepted = true;
                     keyHandler.focus = true;
                 } else if (event.key === Qt.Key_Return || event.key === Qt.Key_Enter) {
-                    //opens searched app
-                    if (pageModel.count > 0) {
-                        const item = repeater.itemAt(0);
-                        if (item && item.parentSequential) {
-                            item.parentSequential.running = true;
-                        } else {
-                            // Fallback in case the animation is not found (e.g. during initial load)
-                            const firstApp = pageModel.get(0);
-                            launcher.launch(firstApp.exec);
-                            Qt.quit();
-                        }
-                    }
+                    //opens searched app, once the search for this text is in
+                    if (appModel.pending)
+                        launchWhenReady = true;
+                    else
+                        launchFirst();
                     event.accepted = true;
                 }
             }
@@ -787,11 +832,13 @@ Window {
                         }
                         onExited: hovered = false
                         onClicked: (mouse) => {
+                            // The tile may still be from the previous query
+                            if (appModel.pending)
+                                return;
                             if (mouse.button === Qt.LeftButton) {
                                 parentSequential.running = true; // Run animation and quit
                             } else if (mouse.button === Qt.RightButton) {
-                                launcher.launchAndRefresh(appModel.get(absoluteIndex).exec, runningWindows); // Just launch the app
-                                runningWindows.refresh();
+                                launcher.launchAndRefresh(appModel.get(absoluteIndex).exec, appModel.get(absoluteIndex).appId); // Just launch the app
                             }
                         }
                     }
@@ -1198,7 +1245,10 @@ Window {
             case Qt.Key_Enter:
                 let localIndex = currentIndex - currentPage * itemsPerPage;
                 let appItem = repeater.itemAt(localIndex);
-                if (appItem && appItem.parentSequential) {
+                // Nothing until the search for the current text is in
+                if (appModel.pending) {
+                    event.accepted = true;
+                } else if (appItem && appItem.parentSequential) {
                     appItem.parentSequential.running = true;
                     event.accepted = true;
                 }
@@ -0,0 +1,159 @@
+// thumbnail-check: ThumbnailCapture against a real compositor.
+//
+//   thumbnail-check [timeout-ms]
+//
+// Opens two windows with the same app_id and title, one red and one blue,
+// and runs the launcher's capture and window stream (list-windows --watch,
+// so list-windows must be on PATH) next to them:
+//
+//   twins     each window's stream id gets a thumbnail of its own colour
+//   repaint   the red window turns green; only its thumbnail changes, and
+//             the blue one is not repainted
+//
+// Prints one line per check; exits non-zero if any fails or the timeout
+// (default 10 s) passes first. Needs ext-foreign-toplevel-list,
+// ext-image-copy-capture and wlr-foreign-toplevel-management, which a
+// headless sway (1.11 or later) on the pixman renderer has:
+//
+//   WLR_BACKENDS=headless WLR_RENDERER=pixman WLR_LIBINPUT_NO_DEVICES=1 \
+//       sway -c /dev/null &
+//   WAYLAND_DISPLAY=wayland-1 QT_QPA_PLATFORM=wayland thumbnail-check
+
+#include <QGuiApplication>
+#include <QPainter>
+#include <QRasterWindow>
+#include <QTimer>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+
+#include "thumbnails.h"
+#include "windowevents.h"
+
+class SolidWindow : public QRasterWindow
+{
+public:
+    explicit SolidWindow(const QColor& color)
+        : m_color(color)
+    {
+        setTitle("thumbnail-check");
+        resize(400, 300);
+    }
+
+    void setColor(const QColor& color)
+    {
+        m_color = color;
+        update();
+    }
+
+protected:
+    void paintEvent(QPaintEvent*) override
+    {
+        QPainter(this).fillRect(rect(), m_color);
+    }
+
+private:
+    QColor m_color;
+};
+
+// The centre pixel of the thumbnail the model would show for this window
+static QColor thumbnailColor(ThumbnailCapture& capture, ThumbnailImageProvider& provider, quint32 windowId)
+{
+    const QString url = capture.thumbnailUrl(windowId);
+    if (url.isEmpty())
+        return {};
+    const QImage image = provider.requestImage(url.mid(QStringLiteral("image://thumbnails/").size()), nullptr, {});
+    return image.isNull() ? QColor() : image.pixelColor(image.width() / 2, image.height() / 2);
+}
+
+static bool isMostly(const QColor& color, const QColor& expected)
+{
+    return color.isValid() && qAbs(color.red() - expected.red()) < 32 && qAbs(color.green() - expected.green()) < 32
+        && qAbs(color.blue() - expected.blue()) < 32;
+}
+
+int main(int argc, char* argv[])
+{
+    QGuiApplication::setDesktopFileName("hex-thumbnail-check"); // the app_id
+    QGuiApplication app(argc, argv);
+
+    const int timeoutMs = argc > 1 ? std::max(1000, atoi(argv[1])) : 10000;
+
+    WindowEventStream stream;
+    ThumbnailCapture capture(&stream);
+    ThumbnailImageProvider provider(&capture);
+    if (!capture.isSupported()) {
+        std::printf("compositor lacks ext-image-copy-capture or ext-foreign-toplevel-list\n");
+        return 1;
+    }
+    capture.setActive(true);
+
+    SolidWindow red(Qt::red);
+    SolidWindow blue(Qt::blue);
+    quint32 redId = 0;
+    quint32 blueId = 0;
+    std::map<quint32, int> repaints;
+
+    int failed = 0;
+    auto check = [&](const char* name, bool ok, const QByteArray& detail) {
+        std::printf("%-8s %s  %s\n", name, ok ? "ok  " : "FAIL", detail.constData());
+        if (!ok)
+            ++failed;
+    };
+
+    // Shown one after the other, so the stream ids tell them apart
+    QObject::connect(&stream, &WindowEventStream::windowAdded, &app, [&](quint32 id, const QString& appId) {
+        if (appId != QGuiApplication::desktopFileName())
+            return;
+        if (!redId) {
+            redId = id;
+            blue.show();
+        } else if (!blueId) {
+            blueId = id;
+        }
+    });
+    QObject::connect(&stream, &WindowEventStream::ready, &app, [&]() { red.show(); });
+
+    enum { Twins, Repaint, Done } phase = Twins;
+    QObject::connect(&capture, &ThumbnailCapture::thumbnailChanged, &app, [&](quint32 windowId) {
+        ++repaints[windowId];
+        if (!redId || !blueId)
+            return;
+
+        const QColor redThumb = thumbnailColor(capture, provider, redId);
+        const QColor blueThumb = thumbnailColor(capture, provider, blueId);
+        if (phase == Twins && redThumb.isValid() && blueThumb.isValid()) {
+            check("twins", isMostly(redThumb, Qt::red) && isMostly(blueThumb, Qt::blue),
+                QString("window %1 %2, window %3 %4").arg(redId).arg(redThumb.name()).arg(blueId).arg(blueThumb.name()).toUtf8());
+            phase = Repaint;
+            repaints.clear();
+            red.setColor(Qt::green);
+        } else if (phase == Repaint && windowId == redId && isMostly(redThumb, Qt::green)) {
+            // Give a stray repaint of the other window a moment to show up
+            phase = Done;
+            QTimer::singleShot(500, &app, [&]() {
+                const QColor blueNow = thumbnailColor(capture, provider, blueId);
+                check("repaint", repaints[blueId] == 0 && isMostly(blueNow, Qt::blue),
+                    QString("window %1 %2 after %3 update(s); window %4 %5 after %6")
+                        .arg(redId).arg(thumbnailColor(capture, provider, redId).name()).arg(repaints[redId])
+                        .arg(blueId).arg(blueNow.name()).arg(repaints[blueId]).toUtf8());
+                app.quit();
+            });
+        }
+    });
+
+    QTimer::singleShot(timeoutMs, &app, [&]() {
+        std::printf("gave up after %d ms: %s\n", timeoutMs,
+            !redId || !blueId ? "the stream never reported both windows"
+            : phase == Twins  ? "no thumbnail for both windows"
+                              : "the repainted window's thumbnail never turned green");
+        ++failed;
+        app.quit();
+    });
+
+    stream.start();
+    app.exec();
+
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,644 @@
+#include "thumbnails.h"
+
+#include "ext-foreign-toplevel-list-v1-client-protocol.h"
+#include "ext-image-capture-source-v1-client-protocol.h"
+#include "ext-image-copy-capture-v1-client-protocol.h"
+
+#include <QAbstractEventDispatcher>
+#include <QDebug>
+#include <QPainter>
+#include <QSocketNotifier>
+#include <QTimer>
+#include <QUrl>
+#include <cmath>
+#include <cstring>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <wayland-client.h>
+
+#include "windowevents.h"
+#include "workerpool.h"
+
+static constexpr int kThumbnailWidth = 320;
+static constexpr int kThumbnailHeight = 200;
+static constexpr int kCacheBytes = 24 * 1024 * 1024;
+static constexpr uint32_t kNoFormat = UINT32_MAX;
+
+// The mapped side of a capture buffer. Shared with the worker that scales
+// from it, so the pages stay valid even if the capture stops meanwhile; the
+// wl_buffer itself is only ever touched on the GUI thread.
+struct ThumbnailCapture::ShmBuffer {
+    ~ShmBuffer()
+    {
+        if (data)
+            munmap(data, size);
+    }
+
+    void* data = nullptr;
+    size_t size = 0;
+    int width = 0;
+    int height = 0;
+    int stride = 0;
+    uint32_t format = kNoFormat;
+};
+
+struct ThumbnailCapture::Toplevel {
+    ThumbnailCapture* owner = nullptr;
+    ext_foreign_toplevel_handle_v1* handle = nullptr;
+    QString identifier;
+    QString appId;
+    QString title;
+    quint64 order = 0; // announcement order, for pairing with stream windows
+    bool announced = false; // first done seen
+    bool paired = false;
+    quint64 serial = 0; // bumped on every new thumbnail, busts QML's cache
+
+    // Capture state, only while the launcher is shown
+    ext_image_capture_source_v1* source = nullptr;
+    ext_image_copy_capture_session_v1* session = nullptr;
+    ext_image_copy_capture_frame_v1* frame = nullptr;
+    wl_buffer* buffer = nullptr;
+    std::shared_ptr<ShmBuffer> mapping;
+    QSize bufferSize;
+    uint32_t shmFormat = kNoFormat;
+    uint32_t pendingFormat = kNoFormat;
+    QRegion damage;
+    bool fullDamage = true; // next capture must fill the whole buffer
+    bool scaling = false; // a worker is reading the mapping
+};
+
+// Scales the damaged part of a captured frame into the existing thumbnail.
+// Falls back to a full rescale when there is no usable base or most of the
+// window changed anyway.
+QImage ThumbnailCapture::scaleDamage(const ShmBuffer& buffer, const QRegion& damage, QImage thumb)
+{
+    const QImage frame(static_cast<const uchar*>(buffer.data), buffer.width, buffer.height, buffer.stride,
+        buffer.format == WL_SHM_FORMAT_ARGB8888 ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32);
+    const QSize target = frame.size().scaled(kThumbnailWidth, kThumbnailHeight, Qt::KeepAspectRatio);
+
+    qint64 damagedArea = 0;
+    for (const QRect& r : damage)
+        damagedArea += qint64(r.width()) * r.height();
+
+    if (thumb.size() != target || damagedArea * 2 > qint64(frame.width()) * frame.height()) {
+        return frame.scaled(target, Qt::IgnoreAspectRatio, Qt::SmoothTransformation)
+            .convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    }
+
+    const qreal sx = qreal(target.width()) / frame.width();
+    const qreal sy = qreal(target.height()) / frame.height();
+
+    QPainter painter(&thumb);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    for (const QRect& r : damage) {
+        // Snap to whole thumbnail pixels so neighbouring patches line up
+        QRect dst(QPoint(std::floor(r.left() * sx), std::floor(r.top() * sy)),
+            QPoint(std::ceil((r.right() + 1) * sx) - 1, std::ceil((r.bottom() + 1) * sy) - 1));
+        dst &= thumb.rect();
+        if (dst.isEmpty())
+            continue;
+
+        QRect src(QPoint(std::floor(dst.left() / sx), std::floor(dst.top() / sy)),
+            QPoint(std::ceil((dst.right() + 1) / sx) - 1, std::ceil((dst.bottom() + 1) / sy) - 1));
+        src &= frame.rect();
+
+        painter.drawImage(dst.topLeft(), frame.copy(src).scaled(dst.size(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation));
+    }
+    painter.end();
+    return thumb;
+}
+
+// ----------------- Wayland listeners -----------------
+struct ThumbnailListeners {
+    using Toplevel = ThumbnailCapture::Toplevel;
+
+    static void handleClosed(void* data, ext_foreign_toplevel_handle_v1* handle)
+    {
+        static_cast<Toplevel*>(data)->owner->removeToplevel(handle);
+    }
+
+    static void handleDone(void* data, ext_foreign_toplevel_handle_v1*)
+    {
+        auto* toplevel = static_cast<Toplevel*>(data);
+        if (!toplevel->announced) {
+            toplevel->announced = true;
+            toplevel->owner->pairWindows();
+        }
+        if (toplevel->owner->m_active)
+            toplevel->owner->startCapture(toplevel);
+    }
+
+    static void handleTitle(void* data, ext_foreign_toplevel_handle_v1*, const char* title)
+    {
+        static_cast<Toplevel*>(data)->title = QString::fromUtf8(title);
+    }
+
+    static void handleAppId(void* data, ext_foreign_toplevel_handle_v1*, const char* appId)
+    {
+        static_cast<Toplevel*>(data)->appId = QString::fromUtf8(appId);
+    }
+
+    static void handleIdentifier(void* data, ext_foreign_toplevel_handle_v1*, const char* identifier)
+    {
+        static_cast<Toplevel*>(data)->identifier = QString::fromUtf8(identifier);
+    }
+
+    static constexpr ext_foreign_toplevel_handle_v1_listener handleListener = {
+        .closed = handleClosed,
+        .done = handleDone,
+        .title = handleTitle,
+        .app_id = handleAppId,
+        .identifier = handleIdentifier
+    };
+
+    static void listToplevel(void* data, ext_foreign_toplevel_list_v1*, ext_foreign_toplevel_handle_v1* handle)
+    {
+        auto* self = static_cast<ThumbnailCapture*>(data);
+        auto toplevel = std::make_unique<Toplevel>();
+        toplevel->owner = self;
+        toplevel->handle = handle;
+        toplevel->order = ++self->m_toplevelOrder;
+        ext_foreign_toplevel_handle_v1_add_listener(handle, &handleListener, toplevel.get());
+        self->m_toplevels.emplace(handle, std::move(toplevel));
+    }
+
+    static void listFinished(void*, ext_foreign_toplevel_list_v1*) { }
+
+    static constexpr ext_foreign_toplevel_list_v1_listener listListener = {
+        .toplevel = listToplevel,
+        .finished = listFinished
+    };
+
+    static void sessionBufferSize(void* data, ext_image_copy_capture_session_v1*, uint32_t width, uint32_t height)
+    {
+        static_cast<Toplevel*>(data)->bufferSize = QSize(width, height);
+    }
+
+    static void sessionShmFormat(void* data, ext_image_copy_capture_session_v1*, uint32_t format)
+    {
+        // Only formats QImage can wrap as-is; prefer the opaque one
+        auto* toplevel = static_cast<Toplevel*>(data);
+        if (format == WL_SHM_FORMAT_XRGB8888)
+            toplevel->pendingFormat = format;
+        else if (format == WL_SHM_FORMAT_ARGB8888 && toplevel->pendingFormat != WL_SHM_FORMAT_XRGB8888)
+            toplevel->pendingFormat = format;
+    }
+
+    static void sessionDmabufDevice(void*, ext_image_copy_capture_session_v1*, wl_array*) { }
+    static void sessionDmabufFormat(void*, ext_image_copy_capture_session_v1*, uint32_t, wl_array*) { }
+
+    static void sessionDone(void* data, ext_image_copy_capture_session_v1*)
+    {
+        auto* toplevel = static_cast<Toplevel*>(data);
+        ThumbnailCapture* self = toplevel->owner;
+
+        toplevel->shmFormat = toplevel->pendingFormat;
+        toplevel->pendingFormat = kNoFormat;
+        if (toplevel->shmFormat == kNoFormat || toplevel->bufferSize.isEmpty()) {
+            qWarning() << "[WARN] no usable shm format to capture" << toplevel->appId;
+            self->stopCapture(toplevel);
+            return;
+        }
+
+        self->allocateBuffer(toplevel);
+        if (!toplevel->frame && !toplevel->scaling)
+            self->requestFrame(toplevel);
+    }
+
+    static void sessionStopped(void* data, ext_image_copy_capture_session_v1*)
+    {
+        auto* toplevel = static_cast<Toplevel*>(data);
+        toplevel->owner->stopCapture(toplevel);
+    }
+
+    static constexpr ext_image_copy_capture_session_v1_listener sessionListener = {
+        .buffer_size = sessionBufferSize,
+        .shm_format = sessionShmFormat,
+        .dmabuf_device = sessionDmabufDevice,
+        .dmabuf_format = sessionDmabufFormat,
+        .done = sessionDone,
+        .stopped = sessionStopped
+    };
+
+    static void frameTransform(void*, ext_image_copy_capture_frame_v1*, uint32_t) { }
+
+    static void frameDamage(void* data, ext_image_copy_capture_frame_v1*, int32_t x, int32_t y, int32_t width, int32_t height)
+    {
+        static_cast<Toplevel*>(data)->damage += QRect(x, y, width, height);
+    }
+
+    static void framePresentationTime(void*, ext_image_copy_capture_frame_v1*, uint32_t, uint32_t, uint32_t) { }
+
+    static void frameReady(void* data, ext_image_copy_capture_frame_v1*)
+    {
+        auto* toplevel = static_cast<Toplevel*>(data);
+        toplevel->owner->frameReady(toplevel);
+    }
+
+    static void frameFailed(void* data, ext_image_copy_capture_frame_v1*, uint32_t reason)
+    {
+        auto* toplevel = static_cast<Toplevel*>(data);
+        toplevel->owner->frameFailed(toplevel, reason);
+    }
+
+    static constexpr ext_image_copy_capture_frame_v1_listener frameListener = {
+        .transform = frameTransform,
+        .damage = frameDamage,
+        .presentation_time = framePresentationTime,
+        .ready = frameReady,
+        .failed = frameFailed
+    };
+
+    static void registryGlobal(void* data, wl_registry* registry, uint32_t name, const char* interface, uint32_t)
+    {
+        auto* self = static_cast<ThumbnailCapture*>(data);
+        if (strcmp(interface, wl_shm_interface.name) == 0) {
+            self->m_shm = static_cast<wl_shm*>(wl_registry_bind(registry, name, &wl_shm_interface, 1));
+        } else if (strcmp(interface, ext_foreign_toplevel_list_v1_interface.name) == 0) {
+            self->m_toplevelList = static_cast<ext_foreign_toplevel_list_v1*>(
+                wl_registry_bind(registry, name, &ext_foreign_toplevel_list_v1_interface, 1));
+            ext_foreign_toplevel_list_v1_add_listener(self->m_toplevelList, &listListener, self);
+        } else if (strcmp(interface, ext_foreign_toplevel_image_capture_source_manager_v1_interface.name) == 0) {
+            self->m_sourceManager = static_cast<ext_foreign_toplevel_image_capture_source_manager_v1*>(
+                wl_registry_bind(registry, name, &ext_foreign_toplevel_image_capture_source_manager_v1_interface, 1));
+        } else if (strcmp(interface, ext_image_copy_capture_manager_v1_interface.name) == 0) {
+            self->m_copyManager = static_cast<ext_image_copy_capture_manager_v1*>(
+                wl_registry_bind(registry, name, &ext_image_copy_capture_manager_v1_interface, 1));
+        }
+    }
+
+    static void registryGlobalRemove(void*, wl_registry*, uint32_t) { }
+
+    static constexpr wl_registry_listener registryListener = {
+        .global = registryGlobal,
+        .global_remove = registryGlobalRemove
+    };
+};
+
+// ----------------- ThumbnailCapture -----------------
+ThumbnailCapture::ThumbnailCapture(WindowEventStream* windows, QObject* parent)
+: QObject(parent)
+{
+    m_cache.setMaxCost(kCacheBytes);
+
+    // Pair after each batch, so a start-up dump is paired as a whole and in
+    // id order rather than window by window
+    connect(windows, &WindowEventStream::windowAdded, this, [this](quint32 id, const QString& appId, const QString& title) {
+        m_unpaired[id] = { appId, title };
+    });
+    connect(windows, &WindowEventStream::windowChanged, this,
+        [this](quint32 id, const QString& appId, const QString& title, bool, quint64) {
+            auto it = m_unpaired.find(id);
+            if (it != m_unpaired.end())
+                it->second = { appId, title };
+        });
+    connect(windows, &WindowEventStream::windowClosed, this, [this](quint32 id) {
+        m_unpaired.erase(id);
+        m_identifiers.erase(id);
+    });
+    connect(windows, &WindowEventStream::windowsChanged, this, &ThumbnailCapture::pairWindows);
+
+    // A connection of our own: Qt's is not ours to dispatch, and capture
+    // traffic should not sit in the queue of the launcher's surfaces.
+    m_display = wl_display_connect(nullptr);
+    if (!m_display) {
+        qWarning() << "[WARN] thumbnails: cannot connect to the Wayland display";
+        return;
+    }
+
+    m_registry = wl_display_get_registry(m_display);
+    wl_registry_add_listener(m_registry, &ThumbnailListeners::registryListener, this);
+    wl_display_roundtrip(m_display);
+
+    if (!m_toplevelList || !isSupported()) {
+        qDebug() << "[INFO] compositor lacks ext-image-copy-capture; running windows keep their icons";
+        return;
+    }
+
+    // Initial toplevels
+    wl_display_roundtrip(m_display);
+
+    m_notifier = new QSocketNotifier(wl_display_get_fd(m_display), QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &ThumbnailCapture::dispatch);
+
+    // Requests made while handling Qt events go out before the loop sleeps
+    connect(QAbstractEventDispatcher::instance(thread()), &QAbstractEventDispatcher::aboutToBlock, this, [this]() {
+        wl_display_dispatch_pending(m_display);
+        wl_display_flush(m_display);
+    });
+}
+
+ThumbnailCapture::~ThumbnailCapture()
+{
+    if (!m_display)
+        return;
+
+    // Scaling jobs keep their own reference to the mapping; what has not
+    // started is dropped, and results of the rest go nowhere
+    m_scaleToken.cancel();
+
+    for (auto& [handle, toplevel] : m_toplevels) {
+        stopCapture(toplevel.get());
+        ext_foreign_toplevel_handle_v1_destroy(handle);
+    }
+    m_toplevels.clear();
+
+    if (m_copyManager)
+        ext_image_copy_capture_manager_v1_destroy(m_copyManager);
+    if (m_sourceManager)
+        ext_foreign_toplevel_image_capture_source_manager_v1_destroy(m_sourceManager);
+    if (m_toplevelList)
+        ext_foreign_toplevel_list_v1_destroy(m_toplevelList);
+    if (m_shm)
+        wl_shm_destroy(m_shm);
+    wl_registry_destroy(m_registry);
+    wl_display_disconnect(m_display);
+}
+
+void ThumbnailCapture::dispatch()
+{
+    if (wl_display_dispatch(m_display) < 0) {
+        qWarning() << "[WARN] thumbnails: lost the Wayland connection";
+        m_notifier->setEnabled(false);
+    }
+}
+
+void ThumbnailCapture::setActive(bool active)
+{
+    if (active == m_active || !isSupported())
+        return;
+
+    m_active = active;
+    for (auto& [handle, toplevel] : m_toplevels) {
+        if (active)
+            startCapture(toplevel.get());
+        else
+            stopCapture(toplevel.get());
+    }
+    wl_display_flush(m_display);
+}
+
+void ThumbnailCapture::startCapture(Toplevel* toplevel)
+{
+    if (toplevel->session)
+        return;
+
+    toplevel->source = ext_foreign_toplevel_image_capture_source_manager_v1_create_source(m_sourceManager, toplevel->handle);
+    toplevel->session = ext_image_copy_capture_manager_v1_create_session(m_copyManager, toplevel->source, 0);
+    ext_image_copy_capture_session_v1_add_listener(toplevel->session, &ThumbnailListeners::sessionListener, toplevel);
+}
+
+void ThumbnailCapture::stopCapture(Toplevel* toplevel)
+{
+    if (toplevel->frame)
+        ext_image_copy_capture_frame_v1_destroy(toplevel->frame);
+    if (toplevel->session)
+        ext_image_copy_capture_session_v1_destroy(toplevel->session);
+    if (toplevel->source)
+        ext_image_capture_source_v1_destroy(toplevel->source);
+    if (toplevel->buffer)
+        wl_buffer_destroy(toplevel->buffer);
+
+    toplevel->frame = nullptr;
+    toplevel->session = nullptr;
+    toplevel->source = nullptr;
+    toplevel->buffer = nullptr;
+    toplevel->mapping.reset();
+    toplevel->bufferSize = QSize();
+    toplevel->shmFormat = kNoFormat;
+    toplevel->pendingFormat = kNoFormat;
+    toplevel->damage = QRegion();
+    toplevel->fullDamage = true;
+}
+
+void ThumbnailCapture::allocateBuffer(Toplevel* toplevel)
+{
+    const int width = toplevel->bufferSize.width();
+    const int height = toplevel->bufferSize.height();
+    const ShmBuffer* current = toplevel->mapping.get();
+    if (toplevel->buffer && current && current->width == width && current->height == height
+        && current->format == toplevel->shmFormat)
+        return;
+
+    if (toplevel->buffer)
+        wl_buffer_destroy(toplevel->buffer);
+    toplevel->buffer = nullptr;
+    toplevel->mapping.reset();
+    toplevel->fullDamage = true;
+
+    auto mapping = std::make_shared<ShmBuffer>();
+    mapping->width = width;
+    mapping->height = height;
+    mapping->stride = width * 4;
+    mapping->size = size_t(mapping->stride) * height;
+    mapping->format = toplevel->shmFormat;
+
+    int fd = memfd_create("hex-thumbnail", MFD_CLOEXEC);
+    if (fd < 0 || ftruncate(fd, mapping->size) < 0) {
+        qWarning() << "[WARN] thumbnails: cannot allocate a" << width << "x" << height << "buffer";
+        if (fd >= 0)
+            close(fd);
+        return;
+    }
+
+    void* data = mmap(nullptr, mapping->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+        close(fd);
+        return;
+    }
+    mapping->data = data;
+
+    wl_shm_pool* pool = wl_shm_create_pool(m_shm, fd, int32_t(mapping->size));
+    toplevel->buffer = wl_shm_pool_create_buffer(pool, 0, width, height, mapping->stride, mapping->format);
+    wl_shm_pool_destroy(pool);
+    close(fd);
+
+    toplevel->mapping = std::move(mapping);
+}
+
+void ThumbnailCapture::requestFrame(Toplevel* toplevel)
+{
+    if (!toplevel->session || !toplevel->buffer || toplevel->frame)
+        return;
+
+    toplevel->damage = QRegion();
+    toplevel->frame = ext_image_copy_capture_session_v1_create_frame(toplevel->session);
+    ext_image_copy_capture_frame_v1_add_listener(toplevel->frame, &ThumbnailListeners::frameListener, toplevel);
+    ext_image_copy_capture_frame_v1_attach_buffer(toplevel->frame, toplevel->buffer);
+
+    // We never write to the buffer, so after the first copy only the
+    // window's own damage needs copying. The compositor holds the frame
+    // back until there is some.
+    if (toplevel->fullDamage)
+        ext_image_copy_capture_frame_v1_damage_buffer(toplevel->frame, 0, 0, toplevel->bufferSize.width(), toplevel->bufferSize.height());
+    ext_image_copy_capture_frame_v1_capture(toplevel->frame);
+}
+
+void ThumbnailCapture::frameReady(Toplevel* toplevel)
+{
+    ext_image_copy_capture_frame_v1_destroy(toplevel->frame);
+    toplevel->frame = nullptr;
+
+    QRegion damage = toplevel->fullDamage ? QRegion(QRect(QPoint(0, 0), toplevel->bufferSize)) : toplevel->damage;
+    toplevel->fullDamage = false;
+    if (damage.isEmpty() || !toplevel->mapping) {
+        requestFrame(toplevel);
+        return;
+    }
+
+    QImage base;
+    {
+        QMutexLocker lock(&m_cacheMutex);
+        if (QImage* cached = m_cache.object(toplevel->identifier))
+            base = *cached;
+    }
+
+    toplevel->scaling = true;
+    std::shared_ptr<ShmBuffer> mapping = toplevel->mapping;
+    const QString identifier = toplevel->identifier;
+
+    WorkerPool::instance()
+        ->run(WorkerPool::Decode, [mapping, damage, base]() { return scaleDamage(*mapping, damage, base); }, m_scaleToken)
+        .then(this, [this, identifier](const QImage& thumb) {
+            Toplevel* toplevel = nullptr;
+            for (auto& [handle, t] : m_toplevels) {
+                if (t->identifier == identifier)
+                    toplevel = t.get();
+            }
+            if (!toplevel)
+                return;
+
+            {
+                QMutexLocker lock(&m_cacheMutex);
+                m_cache.insert(identifier, new QImage(thumb), thumb.sizeInBytes());
+            }
+            toplevel->serial = ++m_serial;
+            toplevel->scaling = false;
+            if (const quint32 windowId = windowIdOf(identifier))
+                emit thumbnailChanged(windowId);
+
+            requestFrame(toplevel);
+            wl_display_flush(m_display);
+        });
+}
+
+void ThumbnailCapture::frameFailed(Toplevel* toplevel, uint32_t reason)
+{
+    ext_image_copy_capture_frame_v1_destroy(toplevel->frame);
+    toplevel->frame = nullptr;
+    toplevel->fullDamage = true;
+
+    switch (reason) {
+    case EXT_IMAGE_COPY_CAPTURE_FRAME_V1_FAILURE_REASON_BUFFER_CONSTRAINTS:
+        // New constraints follow, and their done event asks for a frame
+        break;
+    case EXT_IMAGE_COPY_CAPTURE_FRAME_V1_FAILURE_REASON_STOPPED:
+        stopCapture(toplevel);
+        break;
+    default: {
+        // Transient failure: try again a little later rather than spinning
+        const QString identifier = toplevel->identifier;
+        QTimer::singleShot(1000, this, [this, identifier]() {
+            for (auto& [handle, t] : m_toplevels) {
+                if (t->identifier == identifier)
+                    requestFrame(t.get());
+            }
+            wl_display_flush(m_display);
+        });
+        break;
+    }
+    }
+}
+
+void ThumbnailCapture::removeToplevel(ext_foreign_toplevel_handle_v1* handle)
+{
+    auto it = m_toplevels.find(handle);
+    if (it == m_toplevels.end())
+        return;
+
+    stopCapture(it->second.get());
+    {
+        QMutexLocker lock(&m_cacheMutex);
+        m_cache.remove(it->second->identifier);
+    }
+    if (const quint32 windowId = windowIdOf(it->second->identifier))
+        m_identifiers.erase(windowId);
+    ext_foreign_toplevel_handle_v1_destroy(handle);
+    m_toplevels.erase(it);
+}
+
+// Oldest unpaired stream window with oldest unpaired toplevel of the same
+// app_id and title. Stream ids grow in creation order, so id order is age.
+void ThumbnailCapture::pairWindows()
+{
+    for (auto window = m_unpaired.begin(); window != m_unpaired.end();) {
+        Toplevel* match = nullptr;
+        for (auto& [handle, toplevel] : m_toplevels) {
+            if (toplevel->announced && !toplevel->paired && toplevel->appId == window->second.appId
+                && toplevel->title == window->second.title && (!match || toplevel->order < match->order))
+                match = toplevel.get();
+        }
+        if (!match) {
+            ++window;
+            continue;
+        }
+
+        match->paired = true;
+        m_identifiers[window->first] = match->identifier;
+
+        // An idle window sends no new frame, so show what is already there
+        bool cached;
+        {
+            QMutexLocker lock(&m_cacheMutex);
+            cached = m_cache.contains(match->identifier);
+        }
+        if (cached)
+            emit thumbnailChanged(window->first);
+        window = m_unpaired.erase(window);
+    }
+}
+
+quint32 ThumbnailCapture::windowIdOf(const QString& identifier) const
+{
+    for (const auto& [windowId, paired] : m_identifiers) {
+        if (paired == identifier)
+            return windowId;
+    }
+    return 0;
+}
+
+QString ThumbnailCapture::thumbnailUrl(quint32 windowId) const
+{
+    auto pair = m_identifiers.find(windowId);
+    if (pair == m_identifiers.end())
+        return "";
+
+    QMutexLocker lock(&m_cacheMutex);
+    for (const auto& [handle, toplevel] : m_toplevels) {
+        if (toplevel->identifier != pair->second || !m_cache.contains(toplevel->identifier))
+            continue;
+        return "image://thumbnails/" + QString::fromUtf8(QUrl::toPercentEncoding(toplevel->identifier))
+            + "?" + QString::number(toplevel->serial);
+    }
+    return "";
+}
+
+QImage ThumbnailCapture::thumbnail(const QString& identifier) const
+{
+    QMutexLocker lock(&m_cacheMutex);
+    const QImage* image = m_cache.object(identifier);
+    return image ? *image : QImage();
+}
+
+QImage ThumbnailImageProvider::requestImage(const QString& id, QSize* size, const QSize& requestedSize)
+{
+    // Drop the "?serial" cache buster
+    const QString identifier = QUrl::fromPercentEncoding(id.section('?', 0, 0).toUtf8());
+    QImage image = m_capture->thumbnail(identifier);
+
+    if (size)
+        *size = image.size();
+    if (!image.isNull() && requestedSize.isValid() && requestedSize != image.size())
+        image = image.scaled(requestedSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    return image;
+}
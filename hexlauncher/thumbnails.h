@@ -0,0 +1,126 @@
+#pragma once
+
+#include <QCache>
+#include <QImage>
+#include <QMutex>
+#include <QObject>
+#include <QQuickImageProvider>
+#include <QRegion>
+#include <map>
+#include <memory>
+
+#include "workerpool.h"
+
+struct wl_display;
+struct wl_registry;
+struct wl_shm;
+struct ext_foreign_toplevel_list_v1;
+struct ext_foreign_toplevel_handle_v1;
+struct ext_foreign_toplevel_image_capture_source_manager_v1;
+struct ext_image_copy_capture_manager_v1;
+struct ext_image_capture_source_v1;
+struct ext_image_copy_capture_session_v1;
+struct ext_image_copy_capture_frame_v1;
+
+class QSocketNotifier;
+class WindowEventStream;
+
+// Live window thumbnails for the running-window strip.
+//
+// Uses its own Wayland connection: ext-foreign-toplevel-list to see the
+// toplevels and ext-image-copy-capture to copy them into shm buffers.
+// (wlr-screencopy can only capture whole outputs, so it is no use here.)
+// One frame is kept in flight per window and the compositor only completes
+// it once the window has new damage, so an idle window costs nothing.
+// Damaged rectangles are downscaled on a worker thread into the existing
+// thumbnail; the results live in a byte-bounded LRU cache.
+//
+// Thumbnails are keyed by the window stream's id, the one the running-window
+// model uses. The two protocols share no key, so each stream window is
+// paired with an ext toplevel of the same app_id and title, oldest with
+// oldest (both sides announce windows in creation order), and keeps that
+// pair when its title changes. Two terminals with the same title get their
+// own thumbnails.
+//
+// setActive(false) tears every capture session down; only the toplevel list
+// stays bound, which is event-driven.
+class ThumbnailCapture : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ThumbnailCapture(WindowEventStream* windows, QObject* parent = nullptr);
+    ~ThumbnailCapture() override;
+
+    bool isSupported() const { return m_copyManager && m_sourceManager && m_shm; }
+
+    void setActive(bool active);
+
+    // "image://thumbnails/..." for the window with this stream id, or an
+    // empty string if it has no thumbnail (yet).
+    QString thumbnailUrl(quint32 windowId) const;
+
+    // Used by the image provider, possibly from a loader thread.
+    QImage thumbnail(const QString& identifier) const;
+
+signals:
+    void thumbnailChanged(quint32 windowId);
+
+private:
+    struct ShmBuffer;
+    struct Toplevel;
+
+    friend struct ThumbnailListeners;
+
+    void dispatch();
+    void startCapture(Toplevel* toplevel);
+    void stopCapture(Toplevel* toplevel);
+    void allocateBuffer(Toplevel* toplevel);
+    void requestFrame(Toplevel* toplevel);
+    void frameReady(Toplevel* toplevel);
+    void frameFailed(Toplevel* toplevel, uint32_t reason);
+    void removeToplevel(ext_foreign_toplevel_handle_v1* handle);
+    void pairWindows();
+    quint32 windowIdOf(const QString& identifier) const;
+
+    static QImage scaleDamage(const ShmBuffer& buffer, const QRegion& damage, QImage thumb);
+
+    wl_display* m_display = nullptr;
+    wl_registry* m_registry = nullptr;
+    wl_shm* m_shm = nullptr;
+    ext_foreign_toplevel_list_v1* m_toplevelList = nullptr;
+    ext_foreign_toplevel_image_capture_source_manager_v1* m_sourceManager = nullptr;
+    ext_image_copy_capture_manager_v1* m_copyManager = nullptr;
+    QSocketNotifier* m_notifier = nullptr;
+
+    std::map<ext_foreign_toplevel_handle_v1*, std::unique_ptr<Toplevel>> m_toplevels;
+    quint64 m_toplevelOrder = 0;
+
+    // Stream windows not yet paired (id -> app_id, title), and the pairs
+    struct StreamWindow {
+        QString appId;
+        QString title;
+    };
+    std::map<quint32, StreamWindow> m_unpaired;
+    std::map<quint32, QString> m_identifiers; // stream id -> ext identifier
+
+    mutable QMutex m_cacheMutex;
+    QCache<QString, QImage> m_cache; // identifier -> thumbnail, cost in bytes
+    quint64 m_serial = 0;
+    bool m_active = false;
+    CancelToken m_scaleToken;
+};
+
+class ThumbnailImageProvider : public QQuickImageProvider
+{
+public:
+    explicit ThumbnailImageProvider(const ThumbnailCapture* capture)
+        : QQuickImageProvider(QQuickImageProvider::Image)
+        , m_capture(capture)
+    {
+    }
+
+    QImage requestImage(const QString& id, QSize* size, const QSize& requestedSize) override;
+
+private:
+    const ThumbnailCapture* m_capture;
+};
@@ -0,0 +1,158 @@
+#include "updatescheduler.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QEvent>
+#include <QFile>
+#include <QPointer>
+#include <QTimer>
+#include <QWindow>
+#include <algorithm>
+
+static constexpr qint64 kMaxSlackMs = 60000;
+
+static qint64 slackFor(qint64 delayMs)
+{
+    return std::min(delayMs / 10, kMaxSlackMs);
+}
+
+// Voluntary context switches of every thread: each one is the process
+// going to sleep and, later, being woken
+static quint64 contextSwitches()
+{
+    quint64 total = 0;
+    const QStringList tasks = QDir("/proc/self/task").entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QString& task : tasks) {
+        QFile status("/proc/self/task/" + task + "/status");
+        if (!status.open(QIODevice::ReadOnly))
+            continue;
+        for (const QByteArray& line : status.readAll().split('\n')) {
+            if (line.startsWith("voluntary_ctxt_switches:"))
+                total += line.mid(line.indexOf(':') + 1).trimmed().toULongLong();
+        }
+    }
+    return total;
+}
+
+UpdateScheduler::UpdateScheduler(QObject* parent)
+: QObject(parent)
+, m_timer(new QTimer(this))
+{
+    m_clock.start();
+    m_timer->setSingleShot(true);
+    connect(m_timer, &QTimer::timeout, this, [this]() {
+        ++m_wakeups;
+        runDue();
+        reschedule();
+    });
+
+    bool ok = false;
+    const int statsSecs = qEnvironmentVariableIntValue("HEX_WAKEUP_STATS", &ok);
+    if (ok && statsSecs > 0) {
+        m_lastSwitches = contextSwitches();
+        auto* stats = new QTimer(this);
+        connect(stats, &QTimer::timeout, this, &UpdateScheduler::logStats);
+        stats->start(statsSecs * 1000);
+    }
+}
+
+void UpdateScheduler::watchWindow(QWindow* window)
+{
+    m_window = window;
+    window->installEventFilter(this);
+    connect(window, &QWindow::visibleChanged, this, &UpdateScheduler::updateActive);
+    connect(window, &QObject::destroyed, this, [this]() { m_window = nullptr; });
+    updateActive();
+}
+
+bool UpdateScheduler::eventFilter(QObject* watched, QEvent* event)
+{
+    // Exposure changes (minimised, covered, output off) arrive as Expose
+    if (watched == m_window && event->type() == QEvent::Expose)
+        QMetaObject::invokeMethod(this, &UpdateScheduler::updateActive, Qt::QueuedConnection);
+    return QObject::eventFilter(watched, event);
+}
+
+void UpdateScheduler::updateActive()
+{
+    const bool active = !m_window || (m_window->isVisible() && m_window->isExposed());
+    if (active == m_active)
+        return;
+
+    m_active = active;
+    emit activeChanged(active);
+
+    if (active)
+        runDue();
+    reschedule();
+}
+
+void UpdateScheduler::runIn(QObject* owner, qint64 delayMs, const Callback& callback)
+{
+    m_entries.removeIf([owner](const Entry& entry) { return entry.owner == owner; });
+    m_entries.append({ owner, callback, m_clock.elapsed() + qMax<qint64>(0, delayMs), slackFor(delayMs) });
+    // Once per owner: runIn() is called again after every fetch
+    if (!m_owners.contains(owner)) {
+        m_owners.insert(owner);
+        connect(owner, &QObject::destroyed, this, [this, owner]() { remove(owner); });
+    }
+    reschedule();
+}
+
+void UpdateScheduler::remove(QObject* owner)
+{
+    m_entries.removeIf([owner](const Entry& entry) { return entry.owner == owner; });
+    m_owners.remove(owner);
+    reschedule();
+}
+
+void UpdateScheduler::runDue()
+{
+    const qint64 now = m_clock.elapsed();
+
+    // Callbacks may add or drop entries, so collect first
+    QList<QPair<QPointer<QObject>, Callback>> run;
+    m_entries.removeIf([&](const Entry& entry) {
+        if (entry.dueMs > now)
+            return false;
+        run.append({ entry.owner, entry.callback });
+        return true;
+    });
+
+    for (const auto& [owner, callback] : run) {
+        if (owner)
+            callback();
+    }
+}
+
+void UpdateScheduler::reschedule()
+{
+    qint64 deadline = -1;
+    for (const Entry& entry : m_entries) {
+        const qint64 latest = entry.dueMs + entry.slackMs;
+        if (deadline < 0 || latest < deadline)
+            deadline = latest;
+    }
+
+    if (!m_active || deadline < 0) {
+        m_timer->stop();
+        return;
+    }
+    m_timer->start(int(qMax<qint64>(0, deadline - m_clock.elapsed())));
+}
+
+void UpdateScheduler::logStats()
+{
+    const qint64 now = m_clock.elapsed();
+    const quint64 switches = contextSwitches();
+    const double secs = (now - m_lastStatsMs) / 1000.0;
+    if (secs <= 0)
+        return;
+
+    qDebug().nospace() << "[INFO] wakeups/s: process " << (switches - m_lastSwitches) / secs << ", scheduler "
+                       << (m_wakeups - m_lastWakeups) / secs << (m_active ? " (shown)" : " (hidden)");
+
+    m_lastSwitches = switches;
+    m_lastWakeups = m_wakeups;
+    m_lastStatsMs = now;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+#include <QSet>
+#include <functional>
+
+class QTimer;
+class QWindow;
+
+// Decides when the launcher's widgets may do periodic work.
+//
+// `active` follows the launcher window: visible and exposed. While it is
+// false nothing registered here runs and the scheduler holds no timer at
+// all; QML animations bind `running` to it. Work that came due while hidden
+// runs once on re-show.
+//
+// Timed work is coalesced: each entry may run up to a tenth of its delay
+// late (capped at a minute), and the one shared timer fires at the earliest
+// point that still satisfies every entry, running everything due by then.
+//
+// HEX_WAKEUP_STATS=<seconds> logs process and scheduler wakeups per second
+// (voluntary context switches over all threads) at that period.
+class UpdateScheduler : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool active READ isActive NOTIFY activeChanged)
+
+public:
+    using Callback = std::function<void()>;
+
+    explicit UpdateScheduler(QObject* parent = nullptr);
+
+    void watchWindow(QWindow* window);
+    bool isActive() const { return m_active; }
+
+    // Once, delayMs from now; replaces the owner's previous entry, and goes
+    // away with the owner
+    void runIn(QObject* owner, qint64 delayMs, const Callback& callback);
+
+    // Timer expiries since start; what the scheduler itself costs
+    quint64 wakeups() const { return m_wakeups; }
+
+signals:
+    void activeChanged(bool active);
+
+protected:
+    bool eventFilter(QObject* watched, QEvent* event) override;
+
+private:
+    struct Entry {
+        QObject* owner;
+        Callback callback;
+        qint64 dueMs;
+        qint64 slackMs;
+    };
+
+    void remove(QObject* owner);
+    void updateActive();
+    void runDue();
+    void reschedule();
+    void logStats();
+
+    QWindow* m_window = nullptr;
+    bool m_active = true;
+    QList<Entry> m_entries;
+    QSet<QObject*> m_owners; // watched for destroyed()
+    QTimer* m_timer;
+    QElapsedTimer m_clock;
+    quint64 m_wakeups = 0;
+
+    quint64 m_lastSwitches = 0;
+    quint64 m_lastWakeups = 0;
+    qint64 m_lastStatsMs = 0;
+};
@@ -0,0 +1,291 @@
+// weather-check: WeatherProvider against a local HTTP stand-in.
+//
+//   weather-check
+//
+// Serves the weather endpoint from a QTcpServer on 127.0.0.1 and points a
+// throwaway apps.ini (WeatherEndpoint, WeatherTtl=60, WeatherRetry=1) and
+// cache directory (XDG_CACHE_HOME) at it. Each check starts a fresh
+// provider, the way a launcher start would:
+//
+//   fresh     no cache: a plain request, 200 with an ETag; shown and cached
+//   cached    cache younger than the TTL: shown at once, no request at all
+//   etag      cache older than the TTL: If-None-Match with the cached ETag,
+//             answered 304; still shown, and the cache marked fresh again
+//   backoff   three 503s in a row: the last known conditions stay up, and
+//             the retries come 1 s, 2 s, then 4 s apart
+//   recover   the next answer is 200 with a new ETag: shown, and no further
+//             request follows (the TTL is a minute away again)
+//
+// Prints one line per check; exits non-zero if any fails or the whole run
+// takes longer than 30 s.
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSettings>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTemporaryDir>
+#include <QTimer>
+#include <cstdio>
+#include <functional>
+#include <memory>
+
+#include "updatescheduler.h"
+#include "weather.h"
+
+// Answers every GET from a script: 503, or a body with an ETag that is
+// 304'd when the request already names it
+class StandIn : public QObject
+{
+    Q_OBJECT
+public:
+    struct Request
+    {
+        QByteArray ifNoneMatch;
+        qint64 atMs;
+        int status;
+    };
+
+    explicit StandIn(QObject* parent = nullptr)
+        : QObject(parent)
+    {
+        m_clock.start();
+        connect(&m_server, &QTcpServer::newConnection, this, [this]() {
+            while (QTcpSocket* socket = m_server.nextPendingConnection()) {
+                connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+                connect(socket, &QTcpSocket::readyRead, this, [this, socket]() { serve(socket); });
+            }
+        });
+    }
+
+    bool listen() { return m_server.listen(QHostAddress::LocalHost); }
+    quint16 port() const { return m_server.serverPort(); }
+
+    void answerWith(double temperature, const QByteArray& etag)
+    {
+        m_failing = false;
+        m_temperature = temperature;
+        m_etag = etag;
+    }
+    void fail() { m_failing = true; }
+
+    qint64 now() const { return m_clock.elapsed(); }
+    QList<Request> requests;
+
+signals:
+    void requested();
+
+private:
+    void serve(QTcpSocket* socket)
+    {
+        QByteArray& buffer = m_buffers[socket];
+        buffer += socket->readAll();
+        if (!buffer.contains("\r\n\r\n"))
+            return;
+
+        QByteArray ifNoneMatch;
+        for (const QByteArray& line : buffer.left(buffer.indexOf("\r\n\r\n")).split('\n')) {
+            if (line.toLower().startsWith("if-none-match:"))
+                ifNoneMatch = line.mid(line.indexOf(':') + 1).trimmed();
+        }
+        m_buffers.remove(socket);
+
+        QByteArray head;
+        QByteArray body;
+        int status;
+        if (m_failing) {
+            status = 503;
+            head = "HTTP/1.1 503 Service Unavailable\r\n";
+        } else if (!ifNoneMatch.isEmpty() && ifNoneMatch == m_etag) {
+            status = 304;
+            head = "HTTP/1.1 304 Not Modified\r\nETag: " + m_etag + "\r\n";
+        } else {
+            status = 200;
+            body = QJsonDocument(QJsonObject {
+                                     { "main", QJsonObject { { "temp", m_temperature } } },
+                                     { "weather", QJsonArray { QJsonObject { { "main", "Clouds" }, { "icon", "03d" } } } },
+                                 })
+                       .toJson(QJsonDocument::Compact);
+            head = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nETag: " + m_etag + "\r\n";
+        }
+        socket->write(head + "Content-Length: " + QByteArray::number(body.size()) + "\r\nConnection: close\r\n\r\n"
+            + body);
+        socket->disconnectFromHost();
+
+        requests.append({ ifNoneMatch, now(), status });
+        emit requested();
+    }
+
+    QTcpServer m_server;
+    QHash<QTcpSocket*, QByteArray> m_buffers;
+    QElapsedTimer m_clock;
+    bool m_failing = false;
+    double m_temperature = 0;
+    QByteArray m_etag;
+};
+
+static QJsonObject readCache(const QString& path)
+{
+    QFile file(path);
+    return file.open(QIODevice::ReadOnly) ? QJsonDocument::fromJson(file.readAll()).object() : QJsonObject();
+}
+
+// Makes the cached answer look an hour old
+static bool ageCache(const QString& path)
+{
+    QJsonObject cache = readCache(path);
+    if (cache.isEmpty())
+        return false;
+    cache["fetched"] = cache.value("fetched").toInteger() - 3600;
+    QFile file(path);
+    return file.open(QIODevice::WriteOnly) && file.write(QJsonDocument(cache).toJson()) > 0;
+}
+
+int main(int argc, char* argv[])
+{
+    QTemporaryDir home;
+    qputenv("XDG_CACHE_HOME", home.path().toUtf8());
+    QCoreApplication app(argc, argv);
+
+    StandIn standIn;
+    if (!home.isValid() || !standIn.listen()) {
+        std::printf("cannot set up the stand-in\n");
+        return 1;
+    }
+
+    const QString configPath = home.path() + "/apps.ini";
+    {
+        QSettings settings(configPath, QSettings::IniFormat);
+        settings.beginGroup("gen");
+        settings.setValue("ApiKey", "check");
+        settings.setValue("weatherLocation", "Testville");
+        settings.setValue("WeatherEndpoint", QString("http://127.0.0.1:%1/weather").arg(standIn.port()));
+        settings.setValue("WeatherTtl", 60);
+        settings.setValue("WeatherRetry", 1);
+        settings.endGroup();
+    }
+    const QString cachePath = home.path() + "/hexlauncher/weather.json";
+
+    UpdateScheduler scheduler; // no window: always active
+    std::unique_ptr<WeatherProvider> provider;
+
+    int failed = 0;
+    auto check = [&](const char* name, bool ok, const QByteArray& detail) {
+        std::printf("%-8s %s  %s\n", name, ok ? "ok  " : "FAIL", detail.constData());
+        if (!ok)
+            ++failed;
+    };
+    auto describe = [&]() {
+        QStringList seen;
+        for (const StandIn::Request& request : standIn.requests)
+            seen << QString("%1@%2ms").arg(request.status).arg(request.atMs);
+        return QString("%1, requests %2").arg(provider ? provider->temperature() : QString("-"), seen.join(' ')).toUtf8();
+    };
+
+    // Each phase waits for a number of requests, then a quiet moment
+    enum Phase { Fresh, Cached, Etag, Backoff, Recover, Done } phase = Fresh;
+    std::function<void()> next;
+    bool cachedShown = false;
+    QTimer quiet;
+    quiet.setSingleShot(true);
+
+    auto begin = [&](Phase newPhase) {
+        phase = newPhase;
+        standIn.requests.clear();
+        provider.reset();
+        provider = std::make_unique<WeatherProvider>(configPath, &scheduler);
+    };
+
+    next = [&]() {
+        switch (phase) {
+        case Fresh: {
+            const QJsonObject cache = readCache(cachePath);
+            const bool ok = standIn.requests.size() == 1 && standIn.requests[0].ifNoneMatch.isEmpty()
+                && provider->temperature() == "21°C" && cache.value("etag").toString() == "\"v1\"";
+            check("fresh", ok, describe() + ", cached etag " + cache.value("etag").toString().toUtf8());
+
+            begin(Cached);
+            cachedShown = provider->temperature() == "21°C";
+            quiet.start(1000);
+            break;
+        }
+        case Cached:
+            check("cached", cachedShown && standIn.requests.isEmpty(), describe());
+            if (!ageCache(cachePath)) {
+                check("etag", false, "cannot age the cache");
+                app.exit(1);
+                return;
+            }
+            begin(Etag);
+            break;
+        case Etag: {
+            const qint64 age = QDateTime::currentSecsSinceEpoch() - readCache(cachePath).value("fetched").toInteger();
+            const bool ok = standIn.requests.size() == 1 && standIn.requests[0].ifNoneMatch == "\"v1\""
+                && standIn.requests[0].status == 304 && provider->temperature() == "21°C" && age < 60;
+            check("etag", ok, describe() + QString(", cache %1 s old").arg(age).toUtf8());
+
+            ageCache(cachePath);
+            standIn.fail();
+            begin(Backoff);
+            break;
+        }
+        case Backoff: {
+            const auto& r = standIn.requests;
+            const qint64 gap1 = r[1].atMs - r[0].atMs;
+            const qint64 gap2 = r[2].atMs - r[1].atMs;
+            const bool ok = provider->temperature() == "21°C" && gap1 >= 1000 && gap1 < 1500 && gap2 >= 2000
+                && gap2 < 2800;
+            // The third gap ends with the request "recover" answers
+            standIn.answerWith(25.2, "\"v2\"");
+            check("backoff", ok, describe());
+            phase = Recover;
+            break;
+        }
+        case Recover: {
+            const auto& r = standIn.requests;
+            const qint64 gap3 = r[3].atMs - r[2].atMs;
+            const bool ok = r.size() == 4 && r[3].status == 200 && gap3 >= 4000 && gap3 < 5500
+                && provider->temperature() == "25°C" && readCache(cachePath).value("etag").toString() == "\"v2\"";
+            check("recover", ok, describe());
+            phase = Done;
+            app.quit();
+            break;
+        }
+        case Done:
+            break;
+        }
+    };
+
+    QObject::connect(&quiet, &QTimer::timeout, &app, [&]() { next(); });
+    QObject::connect(&standIn, &StandIn::requested, &app, [&]() {
+        const int count = standIn.requests.size();
+        if ((phase == Fresh || phase == Etag) && count == 1)
+            quiet.start(300); // let the reply be handled and cached
+        else if (phase == Backoff && count == 3)
+            next();
+        else if (phase == Recover && count == 4)
+            quiet.start(1500); // and nothing after it
+        else if (phase == Cached || (phase == Recover && count > 4))
+            quiet.start(0);
+    });
+
+    QTimer::singleShot(30000, &app, [&]() {
+        std::printf("gave up after 30 s in phase %d: %s\n", int(phase), describe().constData());
+        ++failed;
+        app.quit();
+    });
+
+    standIn.answerWith(21.4, "\"v1\"");
+    begin(Fresh);
+    app.exec();
+
+    provider.reset();
+    return failed == 0 ? 0 : 1;
+}
+
+#include "weather-check.moc"
@@ -0,0 +1,249 @@
+#include "weather.h"
+#include "updatescheduler.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QSaveFile>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QUrlQuery>
+#include <cmath>
+
+static constexpr int kRequestTimeoutMs = 15000;
+static constexpr qint64 kMaxRetrySecs = 30 * 60;
+
+// OpenWeatherMap icon codes ("10d", "01n", ...) to the bundled icons
+static QUrl iconFor(const QString& code)
+{
+    const QString kind = code.left(2);
+    const bool night = code.endsWith('n');
+
+    QString name;
+    if (kind == "01")
+        name = night ? "clear-night" : "clear-day";
+    else if (kind == "02")
+        name = night ? "partly-cloudy-night" : "partly-cloudy-day";
+    else if (kind == "03" || kind == "04")
+        name = "cloudy";
+    else if (kind == "09" || kind == "10")
+        name = "rain";
+    else if (kind == "11")
+        name = "thunderstorm";
+    else if (kind == "13")
+        name = "snow";
+    else if (kind == "50")
+        name = "mist";
+    else
+        return QUrl();
+
+    return QUrl("qrc:/images/weather/" + name + ".svg");
+}
+
+WeatherProvider::WeatherProvider(const QString& configPath, UpdateScheduler* scheduler, QObject* parent)
+: QObject(parent)
+, m_network(new QNetworkAccessManager(this))
+, m_scheduler(scheduler)
+{
+    QSettings settings(configPath, QSettings::IniFormat);
+    settings.beginGroup("gen");
+    m_apiKey = settings.value("ApiKey", "").toString();
+    m_city = settings.value("weatherLocation", "Madhubani").toString();
+    m_endpoint = QUrl(settings.value("WeatherEndpoint", "https://api.openweathermap.org/data/2.5/weather").toString());
+    m_ttlSecs = qMax<qint64>(60, settings.value("WeatherTtl", 600).toLongLong());
+    m_retrySecs = qBound<qint64>(1, settings.value("WeatherRetry", 30).toLongLong(), kMaxRetrySecs);
+    settings.endGroup();
+
+    m_cachePath = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + "/hexlauncher/weather.json";
+
+    // Show the last known conditions before anything goes out on the network
+    loadCache();
+    refresh();
+}
+
+void WeatherProvider::setCity(const QString& city)
+{
+    const QString trimmed = city.trimmed();
+    if (trimmed == m_city)
+        return;
+
+    m_city = trimmed;
+    emit cityChanged();
+
+    // A reply still on its way is for the old place; left alone it would be
+    // shown, and cached, under the new name. Disconnected first, since
+    // abort() emits finished() and that would count as a failure.
+    if (m_reply) {
+        m_reply->disconnect(this);
+        m_reply->abort();
+        m_reply->deleteLater();
+        m_reply = nullptr;
+    }
+
+    // Nothing cached applies to the new place
+    m_response = QJsonObject();
+    m_fetched = QDateTime();
+    m_etag.clear();
+    m_lastModified.clear();
+    m_failures = 0;
+    m_temperature = "--°C";
+    m_condition = "Loading...";
+    m_icon = QUrl();
+    emit weatherChanged();
+
+    fetch();
+}
+
+void WeatherProvider::refresh()
+{
+    // Due at once when stale; runs when the launcher is next shown if hidden
+    scheduleNext();
+}
+
+void WeatherProvider::fetch()
+{
+    if (m_city.isEmpty() || m_reply)
+        return;
+
+    QUrl url = m_endpoint;
+    QUrlQuery query(url);
+    query.addQueryItem("q", m_city);
+    query.addQueryItem("appid", m_apiKey);
+    query.addQueryItem("units", "metric");
+    url.setQuery(query);
+
+    QNetworkRequest request(url);
+    request.setTransferTimeout(kRequestTimeoutMs);
+    if (!m_response.isEmpty()) {
+        // Only worth asking conditionally if there is something to fall back on
+        if (!m_etag.isEmpty())
+            request.setRawHeader("If-None-Match", m_etag);
+        if (!m_lastModified.isEmpty())
+            request.setRawHeader("If-Modified-Since", m_lastModified);
+    }
+
+    m_reply = m_network->get(request);
+    connect(m_reply, &QNetworkReply::finished, this, [this, reply = m_reply.data()]() { finished(reply); });
+}
+
+void WeatherProvider::finished(QNetworkReply* reply)
+{
+    reply->deleteLater();
+    if (reply != m_reply)
+        return; // superseded by setCity()
+    m_reply = nullptr;
+
+    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (reply->error() != QNetworkReply::NoError) {
+        failed(reply->errorString());
+        return;
+    }
+
+    if (status == 304) {
+        m_fetched = QDateTime::currentDateTimeUtc();
+    } else if (status == 200) {
+        const QJsonObject response = QJsonDocument::fromJson(reply->readAll()).object();
+        if (!response.value("main").toObject().contains("temp")) {
+            failed("unexpected response");
+            return;
+        }
+        m_response = response;
+        m_fetched = QDateTime::currentDateTimeUtc();
+        m_etag = reply->rawHeader("ETag");
+        m_lastModified = reply->rawHeader("Last-Modified");
+        apply(m_response);
+    } else {
+        failed("HTTP " + QString::number(status));
+        return;
+    }
+
+    m_failures = 0;
+    saveCache();
+    emit weatherChanged(); // "updated" moves even on a 304
+    scheduleNext();
+}
+
+void WeatherProvider::failed(const QString& reason)
+{
+    ++m_failures;
+    qWarning() << "[WARN] weather fetch failed:" << reason;
+
+    // Keep showing the last known conditions; only say so if there are none
+    if (m_response.isEmpty()) {
+        m_temperature = "--°C";
+        m_condition = "N/A";
+        m_icon = QUrl();
+        emit weatherChanged();
+    }
+    scheduleNext();
+}
+
+void WeatherProvider::scheduleNext()
+{
+    qint64 delaySecs;
+    if (m_failures > 0) {
+        // 30 s, 1 min, 2 min, ... capped at 30 min
+        delaySecs = qMin(kMaxRetrySecs, m_retrySecs << qMin(m_failures - 1, 11));
+    } else {
+        const qint64 age = m_fetched.isValid() ? m_fetched.secsTo(QDateTime::currentDateTimeUtc()) : m_ttlSecs;
+        delaySecs = qBound<qint64>(0, m_ttlSecs - age, m_ttlSecs);
+    }
+    m_scheduler->runIn(this, delaySecs * 1000, [this]() { fetch(); });
+}
+
+// ----------------- Cache -----------------
+void WeatherProvider::loadCache()
+{
+    QFile file(m_cachePath);
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+
+    const QJsonObject cache = QJsonDocument::fromJson(file.readAll()).object();
+    if (cache.value("city").toString() != m_city || cache.value("endpoint").toString() != m_endpoint.toString())
+        return;
+
+    const QJsonObject response = cache.value("response").toObject();
+    if (!response.value("main").toObject().contains("temp"))
+        return;
+
+    m_response = response;
+    m_fetched = QDateTime::fromSecsSinceEpoch(cache.value("fetched").toInteger()).toUTC();
+    m_etag = cache.value("etag").toString().toUtf8();
+    m_lastModified = cache.value("lastModified").toString().toUtf8();
+    apply(m_response);
+}
+
+void WeatherProvider::saveCache() const
+{
+    QDir().mkpath(QFileInfo(m_cachePath).path());
+
+    QJsonObject cache;
+    cache["city"] = m_city;
+    cache["endpoint"] = m_endpoint.toString();
+    cache["fetched"] = m_fetched.toSecsSinceEpoch();
+    cache["etag"] = QString::fromUtf8(m_etag);
+    cache["lastModified"] = QString::fromUtf8(m_lastModified);
+    cache["response"] = m_response;
+
+    QSaveFile file(m_cachePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "[WARN] cannot write" << m_cachePath;
+        return;
+    }
+    file.write(QJsonDocument(cache).toJson(QJsonDocument::Compact));
+    file.commit();
+}
+
+void WeatherProvider::apply(const QJsonObject& response)
+{
+    const QJsonObject weather = response.value("weather").toArray().at(0).toObject();
+    m_temperature = QString::number(std::lround(response.value("main").toObject().value("temp").toDouble())) + "°C";
+    m_condition = weather.value("main").toString("N/A");
+    m_icon = iconFor(weather.value("icon").toString());
+}
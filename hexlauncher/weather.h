@@ -0,0 +1,83 @@
+#pragma once
+
+#include <QDateTime>
+#include <QJsonObject>
+#include <QObject>
+#include <QPointer>
+#include <QUrl>
+
+class QNetworkAccessManager;
+class QNetworkReply;
+class UpdateScheduler;
+
+// Current conditions from an OpenWeatherMap-compatible endpoint.
+//
+// The last response is kept in ~/.cache/hexlauncher/weather.json and shown
+// straight away at startup; the network is only asked again once it is older
+// than the TTL, and then with If-None-Match/If-Modified-Since so an unchanged
+// answer is a bodyless 304. Failures back off exponentially. Condition icons
+// are bundled, nothing is fetched for them. Fetches go through the
+// UpdateScheduler, so none happen while the launcher is hidden.
+//
+// [gen] keys in apps.ini: ApiKey, weatherLocation, WeatherEndpoint (point it
+// at a local server to test), WeatherTtl and WeatherRetry (seconds; the
+// first retry after a failure, doubled on each one after).
+class WeatherProvider : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(QString city READ city WRITE setCity NOTIFY cityChanged)
+    Q_PROPERTY(QString temperature READ temperature NOTIFY weatherChanged)
+    Q_PROPERTY(QString condition READ condition NOTIFY weatherChanged)
+    Q_PROPERTY(QUrl icon READ icon NOTIFY weatherChanged)
+    Q_PROPERTY(QDateTime updated READ updated NOTIFY weatherChanged)
+
+public:
+    WeatherProvider(const QString& configPath, UpdateScheduler* scheduler, QObject* parent = nullptr);
+
+    QString city() const { return m_city; }
+    void setCity(const QString& city);
+
+    QString temperature() const { return m_temperature; }
+    QString condition() const { return m_condition; }
+    QUrl icon() const { return m_icon; }
+    QDateTime updated() const { return m_fetched; }
+
+public slots:
+    // Fetch now unless the cached answer is still fresh
+    void refresh();
+
+signals:
+    void cityChanged();
+    void weatherChanged();
+
+private:
+    void fetch();
+    void finished(QNetworkReply* reply);
+    void failed(const QString& reason);
+    void scheduleNext();
+
+    void loadCache();
+    void saveCache() const;
+    void apply(const QJsonObject& response);
+
+    QNetworkAccessManager* m_network;
+    UpdateScheduler* m_scheduler;
+    QPointer<QNetworkReply> m_reply;
+
+    QString m_cachePath;
+    QUrl m_endpoint;
+    QString m_apiKey;
+    qint64 m_ttlSecs = 600;
+    qint64 m_retrySecs = 30;
+    int m_failures = 0;
+
+    QString m_city;
+    QJsonObject m_response;
+    QDateTime m_fetched;
+    QByteArray m_etag;
+    QByteArray m_lastModified;
+
+    QString m_temperature = "--°C";
+    QString m_condition = "Loading...";
+    QUrl m_icon;
+};
@@ -0,0 +1,154 @@
+// hexstate: owns the battery, network, volume and brightness sources and
+// publishes them through the shared-memory state hub (see statehub.h), so
+// the launcher, the OSD and the rest of the shell read a struct instead of
+// spawning amixer/brightnessctl/ip or polling sysfs each on their own.
+//
+// Every source is event driven: rtnetlink/nl80211 for the network,
+// kobject uevents for power_supply and backlight, the mixer backend's own
+// change events for the volume (see mixer.h). The one exception is the
+// battery charge, which BatteryMonitor also re-reads once a minute. Start it
+// once per session, e.g. from the compositor's autostart.
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QFileSystemWatcher>
+#include <QSocketNotifier>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <linux/netlink.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "backlight.h"
+#include "batterymonitor.h"
+#include "mixer.h"
+#include "networkmonitor.h"
+#include "statehub.h"
+
+// ----------------- Brightness -----------------
+// The default backlight (see Backlight::forOutput). Writes through sysfs or
+// logind make the backlight core send a "change" uevent, so no polling is
+// needed; under HEX_SYSFS_ROOT the file is watched instead.
+class BrightnessSource : public QObject {
+    Q_OBJECT
+
+public:
+    explicit BrightnessSource(QObject* parent = nullptr)
+        : QObject(parent)
+    {
+        if (qEnvironmentVariableIsSet("HEX_SYSFS_ROOT")) {
+            auto* watcher = new QFileSystemWatcher(this);
+            if (m_backlight.isValid())
+                watcher->addPaths({ m_backlight.path(), m_backlight.path() + "/brightness" });
+            connect(watcher, &QFileSystemWatcher::fileChanged, this, &BrightnessSource::read);
+            connect(watcher, &QFileSystemWatcher::directoryChanged, this, &BrightnessSource::read);
+        } else {
+            m_ueventFd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, NETLINK_KOBJECT_UEVENT);
+            sockaddr_nl addr = {};
+            addr.nl_family = AF_NETLINK;
+            addr.nl_groups = 1;
+            if (m_ueventFd >= 0 && bind(m_ueventFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) {
+                auto* notifier = new QSocketNotifier(m_ueventFd, QSocketNotifier::Read, this);
+                connect(notifier, &QSocketNotifier::activated, this, &BrightnessSource::readUevents);
+            }
+        }
+
+        read();
+    }
+
+    ~BrightnessSource() override
+    {
+        if (m_ueventFd >= 0)
+            close(m_ueventFd);
+    }
+
+    int percent() const { return m_percent; }
+
+signals:
+    void changed();
+
+private:
+    void readUevents()
+    {
+        bool backlight = false;
+        char buffer[8192];
+        ssize_t n;
+        while ((n = recv(m_ueventFd, buffer, sizeof(buffer) - 1, MSG_DONTWAIT)) > 0 || (n < 0 && errno == EINTR)) {
+            if (n <= 0)
+                continue;
+            buffer[n] = '\0';
+            for (const char* field = buffer; field < buffer + n; field += strlen(field) + 1) {
+                if (strcmp(field, "SUBSYSTEM=backlight") == 0)
+                    backlight = true;
+            }
+        }
+
+        if (backlight || (n < 0 && errno == ENOBUFS))
+            read();
+    }
+
+    void read()
+    {
+        const int percent = m_backlight.percent();
+        if (percent != m_percent) {
+            m_percent = percent;
+            emit changed();
+        }
+    }
+
+    Backlight m_backlight = Backlight::forOutput();
+    int m_ueventFd = -1;
+    int m_percent = -1;
+};
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    // Clean exit clears the online flag so readers fall back; take the
+    // signals through a signalfd so quitting happens on the event loop
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGTERM);
+    sigaddset(&signals, SIGINT);
+    sigprocmask(SIG_BLOCK, &signals, nullptr);
+    const int signalFd = signalfd(-1, &signals, SFD_CLOEXEC);
+    QSocketNotifier signalNotifier(signalFd, QSocketNotifier::Read);
+    QObject::connect(&signalNotifier, &QSocketNotifier::activated, &app, &QCoreApplication::quit);
+
+    StateHubWriter hub;
+    if (!hub.isOpen())
+        return 1;
+
+    BatteryMonitor battery;
+    NetworkMonitor network;
+    Mixer* volume = Mixer::create(&app);
+    BrightnessSource brightness;
+
+    HexState state;
+    auto publish = [&](quint32 fields) {
+        state.batteryPercent = battery.percentage();
+        state.batteryStatus = battery.status();
+        state.networkType = network.type();
+        state.networkName = network.name();
+        state.volumePercent = volume->state().percent;
+        state.muted = volume->state().muted;
+        state.brightnessPercent = brightness.percent();
+        hub.publish(state, fields);
+    };
+
+    QObject::connect(&battery, &BatteryMonitor::changed, [&]() { publish(HexStateField::Battery); });
+    QObject::connect(&network, &NetworkMonitor::changed, [&]() { publish(HexStateField::Network); });
+    QObject::connect(volume, &Mixer::changed, [&]() { publish(HexStateField::Volume); });
+    QObject::connect(&brightness, &BrightnessSource::changed, [&]() { publish(HexStateField::Brightness); });
+
+    publish(HexStateField::Battery | HexStateField::Network | HexStateField::Volume | HexStateField::Brightness
+        | HexStateField::Online);
+    qDebug() << "[INFO] hexstate publishing" << hexStateShmName();
+
+    return app.exec();
+}
+
+#include "main.moc"
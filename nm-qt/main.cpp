@@ -4,13 +4,15 @@
 #include <QListWidget>
 #include <QMessageBox>
 #include <QMetaType>
-#include <QProcess>
 #include <QPushButton>
 #include <QSet>
 #include <QTimer>
 #include <QVBoxLayout>
 #include <QWidget>
-#include <QtConcurrent/QtConcurrent>
+#include <functional>
+
+#include "asyncprocess.h"
+#include "workerpool.h"
 
 struct WiFiInfo {
     QString ssid;
@@ -21,12 +23,8 @@ struct WiFiInfo {
 
 Q_DECLARE_METATYPE(WiFiInfo)
 
-QList<WiFiInfo> getWiFiInfoList()
+QList<WiFiInfo> parseWiFiInfoList(const QString& output)
 {
-    QProcess proc;
-    proc.start("nmcli", { "-t", "-f", "SSID,SECURITY,SIGNAL,ACTIVE", "dev", "wifi", "list" });
-    proc.waitForFinished(5000);
-    QString output = proc.readAllStandardOutput();
     QStringList lines = output.split('\n', Qt::SkipEmptyParts);
 
     QSet<QString> seenSsids;
@@ -67,49 +65,45 @@ QString formatNetworkEntry(const WiFiInfo& info)
     return QString("%1 (%2, %3%) %4").arg(info.ssid, security).arg(info.signal).arg(strength);
 }
 
-bool deleteExistingConnectionProfile(const QString& ssid)
-{
-    QProcess proc;
-    proc.start("nmcli", { "connection", "delete", "id", ssid });
-    proc.waitForFinished(3000);
-
-    QString err = proc.readAllStandardError();
-    if (!err.isEmpty() && !err.contains("not found", Qt::CaseInsensitive)) {
-        qDebug() << "Delete error:" << err;
-        return false;
-    }
-    return true;
-}
-
-bool connectToWiFi(const QString& ssid, const QString& password = QString())
+// Deletes any stale profile first, then connects; `done` runs on the GUI
+// thread. nmcli waits up to 10 s itself, so the GUI must not.
+void connectToWiFi(QWidget* window, const QString& ssid, const QString& password, std::function<void(bool)> done)
 {
-    deleteExistingConnectionProfile(ssid);
-
-    QProcess proc;
-    QStringList args = { "-w", "10", "dev", "wifi", "connect", ssid };
-    if (!password.isEmpty())
-        args << "password" << password;
-
-    proc.start("nmcli", args);
-    if (!proc.waitForFinished(10000)) {
-        QMessageBox::critical(nullptr, "Timeout", "WiFi connection timed out.");
-        return false;
-    }
-
-    QString out = proc.readAllStandardOutput();
-    QString err = proc.readAllStandardError();
-
-    if (out.contains("successfully activated", Qt::CaseInsensitive))
-        return true;
-
-    if (err.contains("key-mgmt", Qt::CaseInsensitive)) {
-        QMessageBox::critical(nullptr, "Connection Error", "Missing or incorrect WiFi password.");
-    } else {
-        QMessageBox::critical(nullptr, "Failed", out + "\n" + err);
-    }
-
-    qDebug() << "Connect error:" << out << err;
-    return false;
+    runProcess("nmcli", { "connection", "delete", "id", ssid }, { 3000, 64 * 1024 })
+        .then(window, [window, ssid, password, done](const ProcessResult& deleted) {
+            QString err = deleted.standardError;
+            if (!err.isEmpty() && !err.contains("not found", Qt::CaseInsensitive))
+                qDebug() << "Delete error:" << err;
+
+            QStringList args = { "-w", "10", "dev", "wifi", "connect", ssid };
+            if (!password.isEmpty())
+                args << "password" << password;
+
+            runProcess("nmcli", args, { 12000, 64 * 1024 }).then(window, [window, done](const ProcessResult& result) {
+                if (result.status == ProcessResult::TimedOut) {
+                    QMessageBox::critical(window, "Timeout", "WiFi connection timed out.");
+                    done(false);
+                    return;
+                }
+
+                QString out = result.standardOutput;
+                QString err = result.standardError;
+
+                if (out.contains("successfully activated", Qt::CaseInsensitive)) {
+                    done(true);
+                    return;
+                }
+
+                if (err.contains("key-mgmt", Qt::CaseInsensitive)) {
+                    QMessageBox::critical(window, "Connection Error", "Missing or incorrect WiFi password.");
+                } else {
+                    QMessageBox::critical(window, "Failed", out + "\n" + err);
+                }
+
+                qDebug() << "Connect error:" << out << err;
+                done(false);
+            });
+        });
 }
 
 int main(int argc, char* argv[])
@@ -132,6 +126,7 @@ int main(int argc, char* argv[])
     QTimer scanTimer;
     int scanCount = 0;
     const int maxScans = 3;
+    CancelToken scanToken;
 
     auto scanWiFi = [&]() {
         if (scanCount >= maxScans) {
@@ -140,41 +135,48 @@ int main(int argc, char* argv[])
         }
 
         scanCount++;
+        // Only the latest scan fills the list
+        scanToken.cancel();
+        scanToken = CancelToken();
+        const CancelToken token = scanToken;
         listWidget.clear();
         listWidget.addItem("🔄 Scanning...");
 
-        QtConcurrent::run([&listWidget]() {
-            try {
-                QList<WiFiInfo> wifiList = getWiFiInfoList();
-
-                std::sort(wifiList.begin(), wifiList.end(), [](const WiFiInfo& a, const WiFiInfo& b) {
-                    return a.signal > b.signal;
-                });
-
-                QMetaObject::invokeMethod(&listWidget, [wifiList, &listWidget]() {
-                    listWidget.clear();
-
-                    for (const WiFiInfo& info : wifiList) {
-                        QString text = formatNetworkEntry(info);
-                        QListWidgetItem* item = new QListWidgetItem(text);
-                        QVariant var;
-                        var.setValue(info);
-                        item->setData(Qt::UserRole, var);
-
-                        if (info.isActive) {
-                            item->setText("✅ " + item->text());
-                            QFont f = item->font();
-                            f.setBold(true);
-                            item->setFont(f);
+        runProcess("nmcli", { "-t", "-f", "SSID,SECURITY,SIGNAL,ACTIVE", "dev", "wifi", "list" }, { 5000, 1 << 20 })
+            .then(&listWidget, [&listWidget, token](const ProcessResult& result) {
+                const QString output = QString::fromUtf8(result.standardOutput);
+                WorkerPool::instance()
+                    ->run(WorkerPool::Interactive, [output]() {
+                        QList<WiFiInfo> wifiList = parseWiFiInfoList(output);
+                        std::sort(wifiList.begin(), wifiList.end(), [](const WiFiInfo& a, const WiFiInfo& b) {
+                            return a.signal > b.signal;
+                        });
+                        return wifiList;
+                    }, token)
+                    .then(&listWidget, [&listWidget, token](const QList<WiFiInfo>& wifiList) {
+                        if (token.isCanceled())
+                            return;
+
+                        listWidget.clear();
+
+                        for (const WiFiInfo& info : wifiList) {
+                            QString text = formatNetworkEntry(info);
+                            QListWidgetItem* item = new QListWidgetItem(text);
+                            QVariant var;
+                            var.setValue(info);
+                            item->setData(Qt::UserRole, var);
+
+                            if (info.isActive) {
+                                item->setText("✅ " + item->text());
+                                QFont f = item->font();
+                                f.setBold(true);
+                                item->setFont(f);
+                            }
+
+                            listWidget.addItem(item);
                         }
-
-                        listWidget.addItem(item);
-                    }
-                });
-            } catch (...) {
-                qDebug() << "Exception occurred during WiFi scan.";
-            }
-        });
+                    });
+            });
     };
 
     QObject::connect(&scanBtn, &QPushButton::clicked, [&]() {
@@ -191,13 +193,17 @@ int main(int argc, char* argv[])
             return;
         }
 
-        if (info.security.isEmpty()) {
-            if (connectToWiFi(info.ssid)) {
-                QMessageBox::information(&window, "Connected", "Connected to " + info.ssid);
+        auto reportResult = [&window, &scanWiFi, ssid = info.ssid](bool connected) {
+            if (connected) {
+                QMessageBox::information(&window, "Connected", "Connected to " + ssid);
                 scanWiFi();
             } else {
-                QMessageBox::critical(&window, "Failed", "Failed to connect to " + info.ssid);
+                QMessageBox::critical(&window, "Failed", "Failed to connect to " + ssid);
             }
+        };
+
+        if (info.security.isEmpty()) {
+            connectToWiFi(&window, info.ssid, QString(), reportResult);
             return;
         }
 
@@ -205,14 +211,8 @@ int main(int argc, char* argv[])
         QString password = QInputDialog::getText(&window, "WiFi Password",
             "Enter password for " + info.ssid,
             QLineEdit::Password, "", &ok);
-        if (ok && !password.isEmpty()) {
-            if (connectToWiFi(info.ssid, password)) {
-                QMessageBox::information(&window, "Connected", "Connected to " + info.ssid);
-                scanWiFi();
-            } else {
-                QMessageBox::critical(&window, "Failed", "Failed to connect to " + info.ssid);
-            }
-        }
+        if (ok && !password.isEmpty())
+            connectToWiFi(&window, info.ssid, password, reportResult);
     });
 
     QTimer::singleShot(0, scanWiFi);
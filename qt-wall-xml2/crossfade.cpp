@@ -0,0 +1,212 @@
+#include "crossfade.h"
+
+#include "workerpool.h"
+
+#include <QByteArray>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <memory>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HEX_CROSSFADE_X86 1
+#endif
+
+namespace Crossfade {
+
+// (from * (256 - t) + to * t) >> 8 per channel: exact at both ends and
+// within 16 bits, so the vector paths can stay in epi16
+static inline quint32 blendPixel(quint32 from, quint32 to, quint32 t) {
+    const quint32 s = 256 - t;
+    const quint32 rb = (((from & 0x00ff00ff) * s + (to & 0x00ff00ff) * t) >> 8) & 0x00ff00ff;
+    const quint32 ag = (((from >> 8) & 0x00ff00ff) * s + ((to >> 8) & 0x00ff00ff) * t) & 0xff00ff00;
+    return rb | ag;
+}
+
+static void blendScalar(quint32 *out, const quint32 *from, const quint32 *to, int count, int t) {
+    for (int i = 0; i < count; ++i)
+        out[i] = blendPixel(from[i], to[i], quint32(t));
+}
+
+#ifdef HEX_CROSSFADE_X86
+static void blendSse2(quint32 *out, const quint32 *from, const quint32 *to, int count, int t) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i weightTo = _mm_set1_epi16(short(t));
+    const __m128i weightFrom = _mm_set1_epi16(short(256 - t));
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(from + i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(to + i));
+        const __m128i lo = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(a, zero), weightFrom),
+                                                        _mm_mullo_epi16(_mm_unpacklo_epi8(b, zero), weightTo)), 8);
+        const __m128i hi = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(a, zero), weightFrom),
+                                                        _mm_mullo_epi16(_mm_unpackhi_epi8(b, zero), weightTo)), 8);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_packus_epi16(lo, hi));
+    }
+    blendScalar(out + i, from + i, to + i, count - i, t);
+}
+
+// Unpack and pack both work within 128-bit lanes, so pixel order survives
+__attribute__((target("avx2")))
+static void blendAvx2(quint32 *out, const quint32 *from, const quint32 *to, int count, int t) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i weightTo = _mm256_set1_epi16(short(t));
+    const __m256i weightFrom = _mm256_set1_epi16(short(256 - t));
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(from + i));
+        const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(to + i));
+        const __m256i lo = _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(a, zero), weightFrom),
+                                                              _mm256_mullo_epi16(_mm256_unpacklo_epi8(b, zero), weightTo)), 8);
+        const __m256i hi = _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(a, zero), weightFrom),
+                                                              _mm256_mullo_epi16(_mm256_unpackhi_epi8(b, zero), weightTo)), 8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), _mm256_packus_epi16(lo, hi));
+    }
+    blendSse2(out + i, from + i, to + i, count - i, t);
+}
+#endif
+
+bool available(Kernel kernel) {
+#ifdef HEX_CROSSFADE_X86
+    if (kernel == Avx2)
+        return __builtin_cpu_supports("avx2");
+    return true; // SSE2 is part of x86-64
+#else
+    return kernel == Scalar;
+#endif
+}
+
+Kernel kernel() {
+    static const Kernel picked = []() {
+        const QByteArray forced = qgetenv("HEX_BLEND");
+        if (forced == "scalar")
+            return Scalar;
+        if (forced == "sse2" && available(Sse2))
+            return Sse2;
+        if (available(Avx2))
+            return Avx2;
+        return available(Sse2) ? Sse2 : Scalar;
+    }();
+    return picked;
+}
+
+const char *kernelName(Kernel kernel) {
+    switch (kernel) {
+    case Avx2:
+        return "avx2";
+    case Sse2:
+        return "sse2";
+    case Scalar:
+        break;
+    }
+    return "scalar";
+}
+
+void blendRow(Kernel kernel, quint32 *out, const quint32 *from, const quint32 *to, int count, int t) {
+#ifdef HEX_CROSSFADE_X86
+    if (kernel == Avx2 && available(Avx2)) {
+        blendAvx2(out, from, to, count, t);
+        return;
+    }
+    if (kernel == Sse2) {
+        blendSse2(out, from, to, count, t);
+        return;
+    }
+#endif
+    Q_UNUSED(kernel);
+    blendScalar(out, from, to, count, t);
+}
+
+static bool pixelLayoutOk(const QImage &image) {
+    return image.format() == QImage::Format_RGB32 || image.format() == QImage::Format_ARGB32_Premultiplied;
+}
+
+bool supported(const QImage &out, const QImage &from, const QImage &to) {
+    return pixelLayoutOk(out) && pixelLayoutOk(from) && pixelLayoutOk(to) && !out.isNull()
+        && from.size() == out.size() && to.size() == out.size();
+}
+
+namespace {
+struct Planes {
+    uchar *out;
+    const uchar *from;
+    const uchar *to;
+    qsizetype outStride, fromStride, toStride;
+    int width;
+};
+}
+
+static void blendRows(const Planes &p, int firstRow, int endRow, int t) {
+    const Kernel k = kernel();
+    for (int y = firstRow; y < endRow; ++y) {
+        blendRow(k, reinterpret_cast<quint32 *>(p.out + y * p.outStride),
+                 reinterpret_cast<const quint32 *>(p.from + y * p.fromStride),
+                 reinterpret_cast<const quint32 *>(p.to + y * p.toStride), p.width, t);
+    }
+}
+
+namespace {
+// Stripes go to whoever claims them first, the painting thread included.
+// A pool task that only starts once the painter has taken every stripe
+// finds nothing left and returns, so a paint waits on stripes already being
+// blended, never on a decode that happened to be queued ahead of its task.
+struct StripeJob {
+    Planes planes;
+    int height;
+    int stripes;
+    int t;
+    std::atomic<int> next { 0 };
+    std::atomic<int> unfinished { 0 };
+
+    void work() {
+        for (int i; (i = next.fetch_add(1, std::memory_order_relaxed)) < stripes;) {
+            blendRows(planes, height * i / stripes, height * (i + 1) / stripes, t);
+            if (unfinished.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                unfinished.notify_all();
+        }
+    }
+};
+}
+
+void blend(QImage &out, const QImage &from, const QImage &to, qreal progress, int stripes) {
+    const int t = int(std::lround(std::clamp(progress, 0.0, 1.0) * 256));
+    const int height = out.height();
+
+    // One core keeps up with 1440p at any sane frame rate; past that the
+    // frame is memory bound and more cores help
+    if (stripes <= 0)
+        stripes = qint64(out.width()) * height > 2560 * 1440 ? std::min(4, WorkerPool::instance()->threadCount() + 1) : 1;
+    stripes = std::clamp(stripes, 1, std::max(1, height));
+
+    // Raw rows only: QImage's non-const accessors may detach, which must
+    // not happen on a worker
+    const Planes planes = { out.bits(), from.constBits(), to.constBits(),
+                            out.bytesPerLine(), from.bytesPerLine(), to.bytesPerLine(), out.width() };
+
+    if (stripes == 1) {
+        blendRows(planes, 0, height, t);
+        return;
+    }
+
+    auto job = std::make_shared<StripeJob>();
+    job->planes = planes;
+    job->height = height;
+    job->stripes = stripes;
+    job->t = t;
+    job->unfinished = stripes;
+
+    // No futures: the pool tasks only help. Those that have not started by
+    // the time the painter is done are canceled and never run.
+    CancelToken helpers;
+    for (int i = 1; i < stripes; ++i)
+        WorkerPool::instance()->run(WorkerPool::Interactive, [job]() { job->work(); }, helpers);
+    job->work();
+    for (int left; (left = job->unfinished.load(std::memory_order_acquire)) > 0;)
+        job->unfinished.wait(left);
+    helpers.cancel();
+}
+
+} // namespace Crossfade
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <QImage>
+
+// The crossfade step of a wallpaper transition, written straight into the
+// backing store: out = from + (to - from) * t per 8-bit channel, in one
+// pass, instead of QPainter compositing two full-screen layers per frame.
+//
+// from, to and out must be the same size, each RGB32 or
+// ARGB32_Premultiplied (one pixel layout; premultiplied colour lerps
+// correctly). crossfadeSupported() says whether a set qualifies.
+//
+// The kernel is picked once per process from what the CPU supports: AVX2,
+// SSE2, or plain C++ elsewhere. HEX_BLEND=scalar|sse2|avx2 forces one (an
+// unsupported choice falls back) for benchmarks. Outputs of more than
+// 1440p are split into horizontal stripes; the calling thread blends them
+// with whatever pool workers are free, and blends any stripe no worker
+// has started itself. `stripes` overrides that (1: no threads).
+namespace Crossfade {
+
+enum Kernel { Scalar, Sse2, Avx2 };
+
+Kernel kernel();
+bool available(Kernel kernel);
+const char *kernelName(Kernel kernel);
+
+bool supported(const QImage &out, const QImage &from, const QImage &to);
+
+// progress 0 is `from`, 1 is `to`; stripes 0 picks by size
+void blend(QImage &out, const QImage &from, const QImage &to, qreal progress, int stripes = 0);
+
+// One run of pixels with a given kernel; t is 0..256
+void blendRow(Kernel kernel, quint32 *out, const quint32 *from, const quint32 *to, int count, int t);
+
+} // namespace Crossfade
@@ -3,11 +3,10 @@
 #include <QPainter>
 #include <QBackingStore>
 #include <QResizeEvent>
-#include <QXmlStreamReader>
-#include <QFile>
 #include <QTimer>
 #include <QDateTime>
 #include <QImage>
+#include <QImageReader>
 #include <QDebug>
 #include <QFileInfo>
 #include <QStringList>
@@ -15,26 +14,33 @@
 #include <QDir>
 #include <QSettings>
 #include <QStandardPaths>
-
-struct StaticEvent {
-    int duration;
-    QString file;
-};
-
-struct TransitionEvent {
-    int duration;
-    QString fromFile;
-    QString toFile;
-};
-
-struct Event {
-    enum Type { Static, Transition } type;
-    QVariant data;
-};
-
-Q_DECLARE_METATYPE(StaticEvent)
-Q_DECLARE_METATYPE(TransitionEvent)
-
+#include <QSet>
+#include <algorithm>
+#include <climits>
+#include <ctime>
+
+#include "crossfade.h"
+#include "scaledimage.h"
+#include "timeline.h"
+#include "walltimer.h"
+#include "workerpool.h"
+
+// Rendering is driven by the slideshow itself rather than a fixed poll:
+//
+// - the end of the current event is armed as an absolute wall-clock time
+//   (walltimer.h), so a static event costs one wakeup however long it is,
+//   and suspend, resume or a clock step re-evaluate the timeline at once
+// - during a transition frames are requested with requestUpdate(), which on
+//   Wayland waits for the compositor's frame callback, at up to
+//   [Wallpaper] fps frames a second (apps.ini, default 30). A frame that
+//   could not change a single 8-bit alpha step is skipped, so a half-hour
+//   crossfade wakes every few seconds while a short one runs at full rate.
+//
+// HEX_WALL_STATS=1 logs each finished phase: wakeups, frames and CPU time.
+// To compare the two phases, run a slideshow with short events (e.g. 120 s
+// static, 30 s transition) for a few cycles and average the "static" and
+// "transition" lines separately. Leave out the first line, which is marked:
+// it also counts startup and the first decode.
 class WallpaperWindow : public QWindow {
     Q_OBJECT
 
@@ -43,6 +49,7 @@ public:
     ~WallpaperWindow();
 
 protected:
+    bool event(QEvent *event) override;
     void exposeEvent(QExposeEvent *event) override;
     void resizeEvent(QResizeEvent *event) override;
 
@@ -51,20 +58,33 @@ private slots:
 
 private:
     void renderWallpaper();
-    bool loadXml(const QString &xmlPath);
-    int totalDuration() const;
-    void cacheImage(const QString &path);
+    qreal transitionProgress() const;
+    void scheduleNext(qint64 nowMs, qint64 untilBoundaryMs);
+    void logPhase(bool transition);
+    QImage cachedImage(const QString &path);
+    void prefetch(const QString &path);
+    void decode(const ScaledImageKey &key, WorkerPool::Lane lane, bool wanted);
+    void trimCache();
+    ScaledImageKey keyFor(const QString &path) const;
 
     QBackingStore *m_backingStore;
 
-    QDateTime m_startTime;
-    QVector<Event> m_events;
+    Timeline m_timeline; // timeline.h
 
-    QHash<QString, QImage> m_imageCache;
-    QStringList m_cacheOrder;
-    const int m_cacheLimit = 3;
+    // Scaled to the output (scaledimage.h); a resize or scale change makes
+    // new entries and lets the old ones age out. Bounded by [Wallpaper]
+    // cacheMB in apps.ini, by default room for four output-sized images.
+    QHash<ScaledImageKey, QImage> m_imageCache;
+    QList<ScaledImageKey> m_cacheOrder;
+    qint64 m_cacheBytes = 0;
+    qint64 m_cacheBudget = 0; // 0: four outputs' worth
+    QHash<ScaledImageKey, bool> m_decoding; // true once something waits on it
+    QSet<ScaledImageKey> m_failed; // not retried until the next boundary or resize
+    QSet<QString> m_pinned; // files of the current and next event
+    QString m_singleImagePath; // a plain image instead of a slideshow
 
-    QTimer m_timer;
+    QTimer m_timer; // transition frames
+    WallClockTimer m_boundary; // end of the current event
 
     QImage m_currentStaticImage;
     QImage m_transitionFromImage;
@@ -72,9 +92,27 @@ private:
 
     bool m_inTransition = false;
     int m_currentEventIndex = 0;
-    qint64 m_elapsedInEvent = 0;
+    qint64 m_elapsedInEvent = 0; // ms
+    int m_fps = 30;
+    int m_blendStripes = 0; // Crossfade::blend(); 0 picks by size
+
+    // HEX_WALL_STATS
+    bool m_stats = false;
+    int m_statsEventIndex = -1;
+    bool m_statsFirst = true; // the first phase logged includes startup
+    qint64 m_statsStartMs = 0;
+    qint64 m_statsStartCpuNs = 0;
+    int m_wakeups = 0;
+    int m_frames = 0;
 };
 
+static qint64 processCpuNs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return qint64(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
 WallpaperWindow::WallpaperWindow(const QString &xmlPath)
 : QWindow()
 , m_backingStore(new QBackingStore(this))
@@ -104,27 +142,50 @@ WallpaperWindow::WallpaperWindow(const QString &xmlPath)
 
     QFileInfo fi(xmlPath);
     if (fi.exists() && (fi.suffix().toLower() == "png" || fi.suffix().toLower() == "jpg" || fi.suffix().toLower() == "jpeg")) {
-        QImage img(xmlPath);
-        if (img.isNull()) {
+        if (!QImageReader(xmlPath).canRead()) {
             qWarning() << "Failed to load image:" << xmlPath;
             QCoreApplication::exit(1);
             return;
         }
-        m_currentStaticImage = img;
+        m_singleImagePath = xmlPath;
         m_inTransition = false;
         m_timer.stop();
         updateWallpaper();
         return;
     }
 
-    if (!loadXml(xmlPath)) {
+    if (!m_timeline.load(xmlPath)) {
         qWarning() << "Failed to load XML, exiting.";
         QCoreApplication::exit(1);
         return;
     }
 
-    connect(&m_timer, &QTimer::timeout, this, &WallpaperWindow::updateWallpaper);
-    m_timer.start(5 * 60 * 1000); // default interval
+    QSettings settings(QDir(QStandardPaths::writableLocation(QStandardPaths::ConfigLocation)).filePath("hexlauncher/apps.ini"),
+                       QSettings::IniFormat);
+    m_fps = std::clamp(settings.value("Wallpaper/fps", 30).toInt(), 1, 240);
+    m_cacheBudget = qMax(0, settings.value("Wallpaper/cacheMB", 0).toInt()) * qint64(1024 * 1024);
+    m_blendStripes = qMax(0, settings.value("Wallpaper/blendThreads", 0).toInt());
+    m_stats = qEnvironmentVariableIsSet("HEX_WALL_STATS");
+    m_statsStartMs = QDateTime::currentMSecsSinceEpoch();
+    m_statsStartCpuNs = processCpuNs();
+
+    m_timer.setSingleShot(true);
+    m_timer.setTimerType(Qt::PreciseTimer);
+    connect(&m_timer, &QTimer::timeout, this, [this]() {
+        ++m_wakeups;
+        requestUpdate();
+    });
+    connect(&m_boundary, &WallClockTimer::timeout, this, [this]() {
+        ++m_wakeups;
+        m_failed.clear();
+        requestUpdate();
+    });
+    connect(&m_boundary, &WallClockTimer::clockChanged, this, [this]() {
+        ++m_wakeups;
+        qDebug() << "[INFO] wall clock changed or resumed, re-reading the timeline";
+        m_failed.clear();
+        requestUpdate();
+    });
     updateWallpaper();
 }
 
@@ -132,143 +193,136 @@ WallpaperWindow::~WallpaperWindow() {
     delete m_backingStore;
 }
 
-void WallpaperWindow::cacheImage(const QString &path) {
-    if (m_imageCache.contains(path)) {
-        m_cacheOrder.removeAll(path);
-        m_cacheOrder.append(path);
-        return;
-    }
-
-    QImage img(path);
-    if (img.isNull()) {
-        qWarning() << "Failed to load image:" << path;
-        return;
-    }
-
-    m_imageCache.insert(path, img);
-    m_cacheOrder.append(path);
+ScaledImageKey WallpaperWindow::keyFor(const QString &path) const {
+    return { path, size() * devicePixelRatio(), devicePixelRatio() };
+}
 
-    while (m_cacheOrder.size() > m_cacheLimit) {
-        QString oldest = m_cacheOrder.takeFirst();
-        m_imageCache.remove(oldest);
+// Decoding and scaling a wallpaper takes long enough to miss frames, so it
+// happens on the pool; until it is done this returns a null image and
+// whatever is on screen stays there. A finished decode re-runs
+// updateWallpaper(); a failed one is not queued again for every frame.
+QImage WallpaperWindow::cachedImage(const QString &path) {
+    const ScaledImageKey key = keyFor(path);
+    if (m_imageCache.contains(key)) {
+        m_cacheOrder.removeAll(key);
+        m_cacheOrder.append(key);
+        return m_imageCache.value(key);
     }
+    if (m_failed.contains(key))
+        return QImage();
+
+    auto decoding = m_decoding.find(key);
+    if (decoding != m_decoding.end())
+        *decoding = true; // a prefetch still on its way; show it when done
+    else
+        decode(key, WorkerPool::Decode, true);
+    return QImage();
 }
 
-bool WallpaperWindow::loadXml(const QString &xmlPath) {
-    QFile file(xmlPath);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        qWarning() << "Cannot open XML file:" << xmlPath;
-        return false;
-    }
+// The next event's images, decoded at low priority while the current one
+// is up, so it starts from the cache
+void WallpaperWindow::prefetch(const QString &path) {
+    const ScaledImageKey key = keyFor(path);
+    if (!m_imageCache.contains(key) && !m_decoding.contains(key) && !m_failed.contains(key))
+        decode(key, WorkerPool::Prefetch, false);
+}
 
-    QXmlStreamReader xml(&file);
-    while (!xml.atEnd() && !xml.hasError()) {
-        QXmlStreamReader::TokenType token = xml.readNext();
-        if (token == QXmlStreamReader::StartElement) {
-            if (xml.name() == "starttime") {
-                int year=0, month=0, day=0, hour=0, minute=0, second=0;
-                while (!(xml.tokenType() == QXmlStreamReader::EndElement && xml.name() == "starttime")) {
-                    if (xml.tokenType() == QXmlStreamReader::StartElement) {
-                        if (xml.name() == "year") year = xml.readElementText().toDouble();
-                        else if (xml.name() == "month") month = xml.readElementText().toDouble();
-                        else if (xml.name() == "day") day = xml.readElementText().toDouble();
-                        else if (xml.name() == "hour") hour = xml.readElementText().toDouble();
-                        else if (xml.name() == "minute") minute = xml.readElementText().toDouble();
-                        else if (xml.name() == "second") second = xml.readElementText().toDouble();
-                    }
-                    xml.readNext();
-                }
-                m_startTime = QDateTime(QDate(year, month, day), QTime(hour, minute, second));
-            } else if (xml.name() == "static") {
-                StaticEvent se;
-                while (!(xml.tokenType() == QXmlStreamReader::EndElement && xml.name() == "static")) {
-                    if (xml.tokenType() == QXmlStreamReader::StartElement) {
-                        if (xml.name() == "duration") se.duration = xml.readElementText().toDouble();
-                        else if (xml.name() == "file") se.file = xml.readElementText();
-                    }
-                    xml.readNext();
-                }
-                Event e;
-                e.type = Event::Static;
-                e.data = QVariant::fromValue(se);
-                m_events.append(e);
-            } else if (xml.name() == "transition") {
-                TransitionEvent te;
-                while (!(xml.tokenType() == QXmlStreamReader::EndElement && xml.name() == "transition")) {
-                    if (xml.tokenType() == QXmlStreamReader::StartElement) {
-                        if (xml.name() == "duration") te.duration = xml.readElementText().toDouble();
-                        else if (xml.name() == "from") te.fromFile = xml.readElementText();
-                        else if (xml.name() == "to") te.toFile = xml.readElementText();
-                    }
-                    xml.readNext();
-                }
-                Event e;
-                e.type = Event::Transition;
-                e.data = QVariant::fromValue(te);
-                m_events.append(e);
+void WallpaperWindow::decode(const ScaledImageKey &key, WorkerPool::Lane lane, bool wanted) {
+    if (key.deviceSize.isEmpty())
+        return;
+    m_decoding.insert(key, wanted);
+
+    WorkerPool::instance()
+        ->run(lane, [key]() { return loadScaledImage(key); })
+        .then(this, [this, key](const QImage &img) {
+            const bool wanted = m_decoding.take(key);
+            if (img.isNull()) {
+                qWarning() << "Failed to load image:" << key.path;
+                m_failed.insert(key);
+                return;
             }
-        }
-    }
 
-    if (xml.hasError()) {
-        qWarning() << "XML parse error:" << xml.errorString();
-        return false;
-    }
+            m_imageCache.insert(key, img);
+            m_cacheOrder.append(key);
+            m_cacheBytes += img.sizeInBytes();
+            trimCache();
 
-    return true;
+            if (wanted)
+                updateWallpaper();
+        });
 }
 
-int WallpaperWindow::totalDuration() const {
-    int total = 0;
-    for (const Event &e : m_events) {
-        if (e.type == Event::Static)
-            total += e.data.value<StaticEvent>().duration;
-        else
-            total += e.data.value<TransitionEvent>().duration;
+// Oldest first, sparing what the current and next event use
+void WallpaperWindow::trimCache() {
+    const QSize deviceSize = size() * devicePixelRatio();
+    const qint64 budget = m_cacheBudget > 0 ? m_cacheBudget : 4 * qint64(deviceSize.width()) * deviceSize.height() * 4;
+
+    for (int i = 0; m_cacheBytes > budget && i < m_cacheOrder.size();) {
+        const ScaledImageKey &key = m_cacheOrder.at(i);
+        if (m_pinned.contains(key.path) && key.deviceSize == deviceSize) {
+            ++i;
+            continue;
+        }
+        m_cacheBytes -= m_imageCache.take(key).sizeInBytes();
+        m_cacheOrder.removeAt(i);
     }
-    return total;
 }
 
 void WallpaperWindow::updateWallpaper() {
-    if (m_events.isEmpty()) return;
-
-    qint64 secondsSinceStart = m_startTime.secsTo(QDateTime::currentDateTime());
-    int cycleDuration = totalDuration();
-    if (cycleDuration == 0) return;
-
-    qint64 loopSec = secondsSinceStart % cycleDuration;
-
-    int accumulated = 0;
-    int index = 0;
-    for (; index < m_events.size(); ++index) {
-        int dur = (m_events[index].type == Event::Static)
-        ? m_events[index].data.value<StaticEvent>().duration
-        : m_events[index].data.value<TransitionEvent>().duration;
+    if (!m_singleImagePath.isEmpty()) {
+        m_pinned = { m_singleImagePath };
+        QImage img = cachedImage(m_singleImagePath);
+        if (img.isNull())
+            return;
+        m_currentStaticImage = img;
+        if (isExposed())
+            renderWallpaper();
+        return;
+    }
 
-        if (loopSec < accumulated + dur)
-            break;
+    const QDateTime now = QDateTime::currentDateTime();
+    const Timeline::Position position = m_timeline.locate(m_timeline.startTime().msecsTo(now));
+    if (position.index < 0) return;
+    const int index = position.index;
 
-        accumulated += dur;
+    if (m_stats && index != m_statsEventIndex) {
+        if (m_statsEventIndex >= 0)
+            logPhase(m_timeline.isTransition(m_statsEventIndex));
+        m_statsEventIndex = index;
     }
 
-    if (index >= m_events.size()) index = 0;
-
     m_currentEventIndex = index;
-    m_elapsedInEvent = loopSec - accumulated;
-
-    const Event &event = m_events[index];
-
-    if (event.type == Event::Static) {
-        StaticEvent se = event.data.value<StaticEvent>();
-        cacheImage(se.file);
-        m_currentStaticImage = m_imageCache.value(se.file);
+    m_elapsedInEvent = position.elapsedMs;
+    scheduleNext(now.toMSecsSinceEpoch(), position.remainingMs);
+
+    // What this event and the next show stays cached; the next one's images
+    // are fetched now, well before it starts
+    const QStringList nextFiles = m_timeline.files((index + 1) % m_timeline.size());
+    m_pinned = QSet<QString>(nextFiles.begin(), nextFiles.end());
+    for (const QString &file : m_timeline.files(index))
+        m_pinned.insert(file);
+    for (const QString &file : nextFiles)
+        prefetch(file);
+
+    const TimelineEvent &event = m_timeline.at(index);
+    if (const auto *se = std::get_if<StaticEvent>(&event)) {
+        QImage img = cachedImage(m_timeline.path(se->image));
+        if (img.isNull())
+            return;
+        m_currentStaticImage = img;
         m_inTransition = false;
     } else {
-        TransitionEvent te = event.data.value<TransitionEvent>();
-        cacheImage(te.fromFile);
-        cacheImage(te.toFile);
-        m_transitionFromImage = m_imageCache.value(te.fromFile);
-        m_transitionToImage = m_imageCache.value(te.toFile);
+        const TransitionEvent &te = std::get<TransitionEvent>(event);
+        QImage from = cachedImage(m_timeline.path(te.from));
+        QImage to = cachedImage(m_timeline.path(te.to));
+        if (from.isNull() || to.isNull()) {
+            // Nothing to blend; the decode re-runs this when it lands, and
+            // a failed one waits for the boundary
+            m_timer.stop();
+            return;
+        }
+        m_transitionFromImage = from;
+        m_transitionToImage = to;
         m_inTransition = true;
     }
 
@@ -276,19 +330,86 @@ void WallpaperWindow::updateWallpaper() {
         renderWallpaper();
 }
 
+void WallpaperWindow::scheduleNext(qint64 nowMs, qint64 untilBoundaryMs) {
+    m_boundary.start(nowMs + untilBoundaryMs);
+
+    // Frames in between only while something moves; they are short enough
+    // for a monotonic QTimer, and a resume re-reads the timeline anyway
+    if (m_timeline.isTransition(m_currentEventIndex)) {
+        const qint64 durationMs = m_timeline.durationMs(m_currentEventIndex);
+        const qint64 frameMs = std::max<qint64>(1000 / m_fps, durationMs / 255);
+        if (frameMs < untilBoundaryMs) {
+            m_timer.start(int(std::min<qint64>(frameMs, INT_MAX)));
+            return;
+        }
+    }
+    m_timer.stop();
+}
+
+void WallpaperWindow::logPhase(bool transition) {
+    const qint64 nowMs = QDateTime::currentMSecsSinceEpoch();
+    const qint64 cpuNs = processCpuNs();
+    const double wallSec = (nowMs - m_statsStartMs) / 1000.0;
+    const double cpuMs = (cpuNs - m_statsStartCpuNs) / 1e6;
+    qDebug().nospace() << "[INFO] " << (transition ? "transition " : "static ") << wallSec << " s: "
+                       << m_wakeups << " wakeups, " << m_frames << " frames, cpu " << cpuMs << " ms ("
+                       << (wallSec > 0 ? cpuMs / 10.0 / wallSec : 0.0) << "%)"
+                       << (m_statsFirst ? ", includes startup" : "");
+    m_statsFirst = false;
+    m_statsStartMs = nowMs;
+    m_statsStartCpuNs = cpuNs;
+    m_wakeups = 0;
+    m_frames = 0;
+}
+
+qreal WallpaperWindow::transitionProgress() const {
+    const qint64 durationMs = m_timeline.durationMs(m_currentEventIndex);
+    double progress = durationMs > 0 ? double(m_elapsedInEvent) / durationMs : 1.0;
+    return qBound(0.0, progress, 1.0);
+}
+
 void WallpaperWindow::renderWallpaper() {
+    ++m_frames;
     QRect rect = geometry();
     m_backingStore->beginPaint(rect);
 
     QPaintDevice *device = m_backingStore->paintDevice();
+    const QSize deviceSize = size() * devicePixelRatio();
+
+    // Both layers at output size: one blend pass straight into the backing
+    // store (crossfade.h) instead of two full-screen composites
+    if (m_inTransition && device->devType() == QInternal::Image) {
+        QImage *target = static_cast<QImage *>(device);
+        if (Crossfade::supported(*target, m_transitionFromImage, m_transitionToImage)) {
+            Crossfade::blend(*target, m_transitionFromImage, m_transitionToImage, transitionProgress(), m_blendStripes);
+            m_backingStore->endPaint();
+            m_backingStore->flush(rect);
+            return;
+        }
+    }
+
     QPainter painter(device);
-    painter.fillRect(rect, Qt::black);
+
+    // An opaque image at full size covers everything anyway
+    const QImage &base = m_inTransition ? m_transitionFromImage : m_currentStaticImage;
+    if (base.size() != deviceSize || base.hasAlphaChannel())
+        painter.fillRect(rect, Qt::black);
 
     // Draw image scaled to fill the window while preserving aspect ratio (crop excess)
     auto drawImagePreserveAspectCrop = [&](const QImage &img, qreal opacity = 1.0) {
         if (img.isNull())
             return;
 
+        // Cache entries are made for this size: a straight blit. Anything
+        // else was made for the size before a resize and is scaled until
+        // its replacement is decoded.
+        if (img.size() == deviceSize && img.devicePixelRatio() == devicePixelRatio()) {
+            painter.setOpacity(opacity);
+            painter.drawImage(rect.topLeft(), img);
+            painter.setOpacity(1.0);
+            return;
+        }
+
         QSize targetSize = rect.size();
         QSize sourceSize = img.size();
 
@@ -312,12 +433,8 @@ void WallpaperWindow::renderWallpaper() {
     };
 
     if (m_inTransition) {
-        TransitionEvent te = m_events[m_currentEventIndex].data.value<TransitionEvent>();
-        double progress = double(m_elapsedInEvent) / te.duration;
-        progress = qBound(0.0, progress, 1.0);
-
         drawImagePreserveAspectCrop(m_transitionFromImage, 1.0);
-        drawImagePreserveAspectCrop(m_transitionToImage, progress);
+        drawImagePreserveAspectCrop(m_transitionToImage, transitionProgress());
     } else {
         drawImagePreserveAspectCrop(m_currentStaticImage);
     }
@@ -328,6 +445,15 @@ void WallpaperWindow::renderWallpaper() {
 }
 
 
+bool WallpaperWindow::event(QEvent *event) {
+    // Frame-callback paced: see the class comment
+    if (event->type() == QEvent::UpdateRequest) {
+        updateWallpaper();
+        return true;
+    }
+    return QWindow::event(event);
+}
+
 void WallpaperWindow::exposeEvent(QExposeEvent *event) {
     Q_UNUSED(event);
     if (isExposed())
@@ -339,6 +465,8 @@ void WallpaperWindow::resizeEvent(QResizeEvent *event) {
     m_backingStore->resize(event->size());
     if (isExposed())
         renderWallpaper();
+    m_failed.clear();
+    updateWallpaper(); // asks for images at the new size
 }
 
 int main(int argc, char **argv) {
@@ -0,0 +1,42 @@
+#include "scaledimage.h"
+
+#include <QImageReader>
+#include <cmath>
+
+QRect fillCropRect(const QSize &source, const QSize &target) {
+    if (source.isEmpty() || target.isEmpty())
+        return QRect();
+
+    const qreal scale = qMax(qreal(target.width()) / source.width(), qreal(target.height()) / source.height());
+    const int width = qMin(source.width(), int(std::lround(target.width() / scale)));
+    const int height = qMin(source.height(), int(std::lround(target.height() / scale)));
+    return QRect((source.width() - width) / 2, (source.height() - height) / 2, width, height);
+}
+
+QImage loadScaledImage(const ScaledImageKey &key) {
+    QImageReader reader(key.path);
+    const QSize sourceSize = reader.size();
+    const QRect crop = fillCropRect(sourceSize, key.deviceSize);
+
+    QImage image;
+    if (!crop.isEmpty() && reader.supportsOption(QImageIOHandler::ScaledSize)
+        && reader.supportsOption(QImageIOHandler::ClipRect)) {
+        reader.setClipRect(crop);
+        reader.setScaledSize(key.deviceSize);
+        image = reader.read();
+    } else {
+        image = reader.read();
+        const QRect imageCrop = fillCropRect(image.size(), key.deviceSize);
+        if (!image.isNull() && !imageCrop.isEmpty())
+            image = image.copy(imageCrop);
+    }
+    if (image.isNull())
+        return image;
+
+    if (image.size() != key.deviceSize)
+        image = image.scaled(key.deviceSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+
+    image.convertTo(image.hasAlphaChannel() ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32);
+    image.setDevicePixelRatio(key.devicePixelRatio);
+    return image;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <QHash>
+#include <QImage>
+#include <QRect>
+#include <QSize>
+#include <QString>
+
+// What hexwall keeps in its cache: a wallpaper already cropped and scaled to
+// the output, so painting it is a plain blit.
+struct ScaledImageKey {
+    QString path;
+    QSize deviceSize; // physical pixels
+    qreal devicePixelRatio = 1.0;
+
+    bool operator==(const ScaledImageKey &other) const {
+        return path == other.path && deviceSize == other.deviceSize && devicePixelRatio == other.devicePixelRatio;
+    }
+};
+
+inline size_t qHash(const ScaledImageKey &key, size_t seed = 0) {
+    return qHashMulti(seed, key.path, key.deviceSize.width(), key.deviceSize.height(), key.devicePixelRatio);
+}
+
+// The part of a `source`-sized image that fills `target` once scaled:
+// the aspect ratio is kept and the excess cropped evenly from both sides
+QRect fillCropRect(const QSize &source, const QSize &target);
+
+// `path` decoded to exactly key.deviceSize, cropped as above. Decoders that
+// can scale while decoding (JPEG) are asked to; anything else is smooth-
+// scaled afterwards. The result is RGB32, or ARGB32_Premultiplied if the
+// file has alpha: the formats a raster backing store blits without
+// converting. Null if the file cannot be read. Safe on any thread.
+QImage loadScaledImage(const ScaledImageKey &key);
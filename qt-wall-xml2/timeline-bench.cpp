@@ -0,0 +1,131 @@
+// timeline-bench: what finding the current event costs hexwall.
+//
+//   timeline-bench [events] [lookups]
+//
+// Builds a slideshow of alternating static and transition events (10,000 by
+// default, plus a 24-event one the size of a typical day) and looks up
+// random times in it (1,000,000 by default) two ways:
+//
+//   scan      the XML kept as QVariant-boxed events, the cycle summed and
+//             walked from the front on every update (hexwall before
+//             timeline.h)
+//   timeline  Timeline::locate(): a binary search over start offsets
+//
+// Both must agree on every lookup the scan made. Prints the time per lookup.
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QString>
+#include <QVariant>
+#include <QVector>
+#include <algorithm>
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+#include "timeline.h"
+
+struct BoxedStatic {
+    int duration;
+    QString file;
+};
+
+struct BoxedTransition {
+    int duration;
+    QString fromFile;
+    QString toFile;
+};
+
+struct BoxedEvent {
+    enum Type { Static, Transition } type;
+    QVariant data;
+};
+
+Q_DECLARE_METATYPE(BoxedStatic)
+Q_DECLARE_METATYPE(BoxedTransition)
+
+static int boxedDuration(const BoxedEvent &e) {
+    return e.type == BoxedEvent::Static ? e.data.value<BoxedStatic>().duration
+                                        : e.data.value<BoxedTransition>().duration;
+}
+
+// updateWallpaper()'s lookup before the timeline, index and elapsed ms
+static int scan(const QVector<BoxedEvent> &events, qint64 msSinceStart, qint64 *elapsedMs) {
+    qint64 cycle = 0;
+    for (const BoxedEvent &e : events)
+        cycle += boxedDuration(e);
+    cycle *= 1000;
+    const qint64 loopMs = ((msSinceStart % cycle) + cycle) % cycle;
+
+    qint64 accumulated = 0;
+    int index = 0;
+    for (; index < events.size(); ++index) {
+        const qint64 dur = qint64(boxedDuration(events[index])) * 1000;
+        if (loopMs < accumulated + dur)
+            break;
+        accumulated += dur;
+    }
+    *elapsedMs = loopMs - accumulated;
+    return index;
+}
+
+static bool bench(int count, int lookups) {
+    QVector<BoxedEvent> boxed;
+    Timeline timeline;
+    QRandomGenerator random(count);
+    for (int i = 0; i < count; ++i) {
+        const QString file = QStringLiteral("/usr/share/backgrounds/day/%1.jpg").arg(i / 2 % 48);
+        const QString next = QStringLiteral("/usr/share/backgrounds/day/%1.jpg").arg((i / 2 + 1) % 48);
+        if (i % 2 == 0) {
+            const int duration = 600 + random.bounded(3000);
+            boxed.append({ BoxedEvent::Static, QVariant::fromValue(BoxedStatic{ duration, file }) });
+            timeline.append(duration * 1000LL, file);
+        } else {
+            const int duration = 1 + random.bounded(10);
+            boxed.append({ BoxedEvent::Transition, QVariant::fromValue(BoxedTransition{ duration, file, next }) });
+            timeline.append(duration * 1000LL, file, next);
+        }
+    }
+
+    std::vector<qint64> times(lookups);
+    for (qint64 &t : times)
+        t = qint64(random.bounded(double(timeline.cycleMs()) * 3)) - timeline.cycleMs();
+
+    // The scan is slow enough at 10,000 events that a fraction of the
+    // lookups gives a stable figure
+    const int scanLookups = count > 1000 ? std::max(1, lookups / 100) : lookups;
+    std::vector<std::pair<int, qint64>> scanned(scanLookups);
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < scanLookups; ++i)
+        scanned[i].first = scan(boxed, times[i], &scanned[i].second);
+    const double scanNs = double(timer.nsecsElapsed()) / scanLookups;
+
+    std::vector<Timeline::Position> located(lookups);
+    timer.start();
+    for (int i = 0; i < lookups; ++i)
+        located[i] = timeline.locate(times[i]);
+    const double timelineNs = double(timer.nsecsElapsed()) / lookups;
+
+    std::printf("%6d events: scan %10.1f ns   timeline %6.1f ns   (%.0fx)\n", count, scanNs, timelineNs,
+                scanNs / timelineNs);
+
+    for (int i = 0; i < scanLookups; ++i) {
+        if (scanned[i].first != located[i].index || scanned[i].second != located[i].elapsedMs) {
+            std::fprintf(stderr, "scan and timeline disagree at %lld ms\n", static_cast<long long>(times[i]));
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    QCoreApplication app(argc, argv);
+
+    const int events = argc > 1 ? std::max(2, atoi(argv[1])) : 10000;
+    const int lookups = argc > 2 ? std::max(100, atoi(argv[2])) : 1000000;
+
+    const bool ok = bench(24, lookups) && bench(events, lookups);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,113 @@
+#include "timeline.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QXmlStreamReader>
+#include <algorithm>
+
+bool Timeline::load(const QString &xmlPath) {
+    QFile file(xmlPath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        qWarning() << "Cannot open XML file:" << xmlPath;
+        return false;
+    }
+
+    // Durations are seconds, possibly fractional
+    auto readMs = [](QXmlStreamReader &xml) {
+        return std::max<qint64>(0, qRound64(xml.readElementText().toDouble() * 1000));
+    };
+
+    QXmlStreamReader xml(&file);
+    while (!xml.atEnd() && !xml.hasError()) {
+        QXmlStreamReader::TokenType token = xml.readNext();
+        if (token == QXmlStreamReader::StartElement) {
+            if (xml.name() == "starttime") {
+                int year=0, month=0, day=0, hour=0, minute=0, second=0;
+                while (!(xml.tokenType() == QXmlStreamReader::EndElement && xml.name() == "starttime")) {
+                    if (xml.tokenType() == QXmlStreamReader::StartElement) {
+                        if (xml.name() == "year") year = xml.readElementText().toDouble();
+                        else if (xml.name() == "month") month = xml.readElementText().toDouble();
+                        else if (xml.name() == "day") day = xml.readElementText().toDouble();
+                        else if (xml.name() == "hour") hour = xml.readElementText().toDouble();
+                        else if (xml.name() == "minute") minute = xml.readElementText().toDouble();
+                        else if (xml.name() == "second") second = xml.readElementText().toDouble();
+                    }
+                    xml.readNext();
+                }
+                m_startTime = QDateTime(QDate(year, month, day), QTime(hour, minute, second));
+            } else if (xml.name() == "static") {
+                qint64 durationMs = 0;
+                QString file;
+                while (!(xml.tokenType() == QXmlStreamReader::EndElement && xml.name() == "static")) {
+                    if (xml.tokenType() == QXmlStreamReader::StartElement) {
+                        if (xml.name() == "duration") durationMs = readMs(xml);
+                        else if (xml.name() == "file") file = xml.readElementText();
+                    }
+                    xml.readNext();
+                }
+                append(durationMs, file);
+            } else if (xml.name() == "transition") {
+                qint64 durationMs = 0;
+                QString from, to;
+                while (!(xml.tokenType() == QXmlStreamReader::EndElement && xml.name() == "transition")) {
+                    if (xml.tokenType() == QXmlStreamReader::StartElement) {
+                        if (xml.name() == "duration") durationMs = readMs(xml);
+                        else if (xml.name() == "from") from = xml.readElementText();
+                        else if (xml.name() == "to") to = xml.readElementText();
+                    }
+                    xml.readNext();
+                }
+                append(durationMs, from, to);
+            }
+        }
+    }
+
+    if (xml.hasError()) {
+        qWarning() << "XML parse error:" << xml.errorString();
+        return false;
+    }
+
+    return true;
+}
+
+void Timeline::append(qint64 durationMs, const QString &file) {
+    m_events.push_back(StaticEvent{ durationMs, intern(file) });
+    m_starts.push_back(m_starts.back() + durationMs);
+}
+
+void Timeline::append(qint64 durationMs, const QString &from, const QString &to) {
+    m_events.push_back(TransitionEvent{ durationMs, intern(from), intern(to) });
+    m_starts.push_back(m_starts.back() + durationMs);
+}
+
+// A day-long slideshow names each image in a static event and two
+// transitions; every name is stored once
+int Timeline::intern(const QString &path) {
+    auto it = m_ids.constFind(path);
+    if (it != m_ids.constEnd())
+        return *it;
+    m_paths.append(path);
+    return *m_ids.insert(path, int(m_paths.size()) - 1);
+}
+
+QStringList Timeline::files(int index) const {
+    if (const auto *se = std::get_if<StaticEvent>(&m_events[index]))
+        return { m_paths[se->image] };
+    const TransitionEvent &te = std::get<TransitionEvent>(m_events[index]);
+    return { m_paths[te.from], m_paths[te.to] };
+}
+
+Timeline::Position Timeline::locate(qint64 msSinceStart) const {
+    const qint64 cycle = cycleMs();
+    if (cycle <= 0)
+        return {};
+
+    const qint64 loopMs = ((msSinceStart % cycle) + cycle) % cycle;
+
+    // The last event starting at or before loopMs. loopMs < cycle, so that
+    // is never the end sentinel, and zero-length events share their start
+    // with the next one and are passed over.
+    const auto next = std::upper_bound(m_starts.begin(), m_starts.end(), loopMs);
+    const int index = int(next - m_starts.begin()) - 1;
+    return { index, loopMs - m_starts[index], *next - loopMs };
+}
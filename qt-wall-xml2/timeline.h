@@ -0,0 +1,66 @@
+#pragma once
+
+#include <QDateTime>
+#include <QHash>
+#include <QStringList>
+#include <variant>
+#include <vector>
+
+// A slideshow XML compiled once into what updateWallpaper() reads on every
+// frame: the events in one contiguous array, each event's start offset as a
+// running sum, and the image paths interned so an event holds plain ids.
+// Finding the event for a time is a binary search over the offsets.
+struct StaticEvent {
+    qint64 durationMs;
+    int image; // Timeline::path()
+};
+
+struct TransitionEvent {
+    qint64 durationMs;
+    int from;
+    int to;
+};
+
+using TimelineEvent = std::variant<StaticEvent, TransitionEvent>;
+
+class Timeline {
+public:
+    struct Position {
+        int index = -1;
+        qint64 elapsedMs = 0; // into the event
+        qint64 remainingMs = 0; // until its end
+    };
+
+    // The <starttime>, <static> and <transition> elements of a GNOME-style
+    // background XML. False, with a warning, if the file cannot be read or
+    // parsed.
+    bool load(const QString &xmlPath);
+
+    void append(qint64 durationMs, const QString &file);
+    void append(qint64 durationMs, const QString &from, const QString &to);
+
+    bool isEmpty() const { return m_events.empty(); }
+    int size() const { return int(m_events.size()); }
+    qint64 cycleMs() const { return m_starts.back(); }
+    const QDateTime &startTime() const { return m_startTime; }
+    void setStartTime(const QDateTime &start) { m_startTime = start; }
+
+    const TimelineEvent &at(int index) const { return m_events[index]; }
+    qint64 durationMs(int index) const { return m_starts[index + 1] - m_starts[index]; }
+    bool isTransition(int index) const { return std::holds_alternative<TransitionEvent>(m_events[index]); }
+    const QString &path(int image) const { return m_paths[image]; }
+    QStringList files(int index) const;
+
+    // Where the slideshow is `msSinceStart` after the start time, wrapped
+    // into the cycle; index -1 if the cycle is empty
+    Position locate(qint64 msSinceStart) const;
+
+private:
+    int intern(const QString &path);
+
+    QDateTime m_startTime;
+    std::vector<TimelineEvent> m_events;
+    std::vector<qint64> m_starts{0}; // one more than m_events; the last is the cycle
+    QStringList m_paths;
+    QHash<QString, int> m_ids;
+};
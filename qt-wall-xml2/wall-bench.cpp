@@ -0,0 +1,179 @@
+// wall-bench: what one hexwall paint costs.
+//
+//   wall-bench [image] [width height] [iterations]
+//
+// Paints into an ARGB32_Premultiplied image the size of the output, which
+// is what a Wayland shm backing store hands QPainter:
+//
+//   full-res  the source drawn scaled on every paint (hexwall before the
+//             pre-scaled cache)
+//   scaled    the cache entry (scaledimage.h) blitted as is
+//
+// each as a static frame and as a crossfade step (two layers, the top one
+// at half opacity). Without an image a 6000x4000 JPEG is generated. Prints
+// the one-off cost of making the cache entry, the median and p99 paint, and
+// how many times faster the median scaled paint is than the full-res one.
+//
+// Then the crossfade step alone at 1080p and 4K: QPainter compositing two
+// layers against Crossfade::blendRow() with each kernel this CPU has, on
+// one thread, and Crossfade::blend() striped over the worker pool, with the
+// p50 of the fastest of those against QPainter's.
+
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QLinearGradient>
+#include <QPainter>
+#include <QTemporaryDir>
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <limits>
+#include <vector>
+
+#include "crossfade.h"
+#include "scaledimage.h"
+
+// Returns the median, in ns
+static qint64 report(const char *label, int iterations, const std::function<void()> &paint) {
+    paint(); // warm up
+
+    std::vector<qint64> times;
+    QElapsedTimer timer;
+    for (int i = 0; i < iterations; ++i) {
+        timer.start();
+        paint();
+        times.push_back(timer.nsecsElapsed());
+    }
+    std::sort(times.begin(), times.end());
+    std::printf("  %-26s p50 %8.3f ms   p99 %8.3f ms\n", label, times[times.size() / 2] / 1e6,
+                times[std::min(times.size() - 1, size_t(times.size() * 0.99))] / 1e6);
+    return times[times.size() / 2];
+}
+
+// What renderWallpaper() did per layer before the cache
+static void drawScaled(QPainter &painter, const QRect &rect, const QImage &img, qreal opacity) {
+    const qreal scale = qMax(qreal(rect.width()) / img.width(), qreal(rect.height()) / img.height());
+    const QSize scaledSize = img.size() * scale;
+    const QRectF target(rect.x() + (rect.width() - scaledSize.width()) / 2.0,
+                        rect.y() + (rect.height() - scaledSize.height()) / 2.0, scaledSize.width(),
+                        scaledSize.height());
+    painter.setOpacity(opacity);
+    painter.drawImage(target, img);
+}
+
+static void crossfadeBench(const QImage &source, const QSize &output, int iterations) {
+    const QImage from = source.scaled(output, Qt::IgnoreAspectRatio, Qt::SmoothTransformation)
+                            .convertToFormat(QImage::Format_RGB32);
+    const QImage to = from.mirrored(true, true);
+    QImage target(output, QImage::Format_ARGB32_Premultiplied);
+    std::printf("crossfade step at %dx%d:\n", output.width(), output.height());
+
+    const qint64 painter = report("QPainter, two layers", iterations, [&]() {
+        QPainter painter(&target);
+        painter.drawImage(QPoint(), from);
+        painter.setOpacity(0.5);
+        painter.drawImage(QPoint(), to);
+    });
+
+    qint64 best = std::numeric_limits<qint64>::max();
+    QByteArray bestLabel;
+    for (Crossfade::Kernel kernel : { Crossfade::Scalar, Crossfade::Sse2, Crossfade::Avx2 }) {
+        if (!Crossfade::available(kernel))
+            continue;
+        const QByteArray label = QByteArray("kernel ") + Crossfade::kernelName(kernel) + ", 1 thread";
+        const qint64 p50 = report(label.constData(), iterations, [&]() {
+            for (int y = 0; y < output.height(); ++y) {
+                Crossfade::blendRow(kernel, reinterpret_cast<quint32 *>(target.scanLine(y)),
+                                    reinterpret_cast<const quint32 *>(from.constScanLine(y)),
+                                    reinterpret_cast<const quint32 *>(to.constScanLine(y)), output.width(), 128);
+            }
+        });
+        if (p50 < best) {
+            best = p50;
+            bestLabel = label;
+        }
+    }
+
+    for (int stripes : { 2, 4 }) {
+        const QByteArray label = QByteArray("blend(), ") + QByteArray::number(stripes) + " stripes";
+        const qint64 p50 = report(label.constData(), iterations, [&]() { Crossfade::blend(target, from, to, 0.5, stripes); });
+        if (p50 < best) {
+            best = p50;
+            bestLabel = label;
+        }
+    }
+    std::printf("  fastest vs QPainter p50    %.1fx (%s)\n", double(painter) / qMax<qint64>(1, best),
+                bestLabel.constData());
+}
+
+int main(int argc, char **argv) {
+    QCoreApplication app(argc, argv);
+
+    QTemporaryDir temp;
+    QString path = argc > 1 ? QString::fromLocal8Bit(argv[1]) : QString();
+    const QSize output = argc > 3 ? QSize(atoi(argv[2]), atoi(argv[3])) : QSize(1920, 1080);
+    const int iterations = argc > 4 ? std::max(1, atoi(argv[4])) : 50;
+
+    if (path.isEmpty()) {
+        QImage generated(6000, 4000, QImage::Format_RGB32);
+        QPainter painter(&generated);
+        QLinearGradient gradient(0, 0, generated.width(), generated.height());
+        gradient.setColorAt(0, Qt::darkBlue);
+        gradient.setColorAt(0.5, Qt::darkCyan);
+        gradient.setColorAt(1, Qt::darkMagenta);
+        painter.fillRect(generated.rect(), gradient);
+        painter.end();
+        path = temp.filePath("generated.jpg");
+        generated.save(path, "JPEG", 90);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    const QImage full(path);
+    const qint64 decodeNs = timer.nsecsElapsed();
+    if (full.isNull() || output.isEmpty()) {
+        std::fprintf(stderr, "cannot read %s\n", qPrintable(path));
+        return 1;
+    }
+    std::printf("%s, %dx%d onto %dx%d, %d paints each\n", qPrintable(path), full.width(), full.height(),
+                output.width(), output.height(), iterations);
+
+    timer.start();
+    const QImage scaled = loadScaledImage({ path, output, 1.0 });
+    const qint64 scaledNs = timer.nsecsElapsed();
+    std::printf("  decode full-res            %8.3f ms\n", decodeNs / 1e6);
+    std::printf("  decode + scale for cache   %8.3f ms\n", scaledNs / 1e6);
+
+    QImage target(output, QImage::Format_ARGB32_Premultiplied);
+    const QRect rect(QPoint(), output);
+
+    const qint64 fullStatic = report("full-res static", iterations, [&]() {
+        QPainter painter(&target);
+        painter.fillRect(rect, Qt::black);
+        drawScaled(painter, rect, full, 1.0);
+    });
+    const qint64 fullCrossfade = report("full-res crossfade step", iterations, [&]() {
+        QPainter painter(&target);
+        painter.fillRect(rect, Qt::black);
+        drawScaled(painter, rect, full, 1.0);
+        drawScaled(painter, rect, full, 0.5);
+    });
+    const qint64 scaledStatic = report("scaled static", iterations, [&]() {
+        QPainter painter(&target);
+        painter.drawImage(QPoint(), scaled);
+    });
+    const qint64 scaledCrossfade = report("scaled crossfade step", iterations, [&]() {
+        QPainter painter(&target);
+        painter.drawImage(QPoint(), scaled);
+        painter.setOpacity(0.5);
+        painter.drawImage(QPoint(), scaled);
+    });
+    std::printf("  scaled vs full-res p50     static %.1fx, crossfade step %.1fx faster\n",
+                double(fullStatic) / qMax<qint64>(1, scaledStatic), double(fullCrossfade) / qMax<qint64>(1, scaledCrossfade));
+
+    crossfadeBench(full, QSize(1920, 1080), iterations);
+    crossfadeBench(full, QSize(3840, 2160), iterations);
+    return 0;
+}
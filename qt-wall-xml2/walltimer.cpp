@@ -0,0 +1,82 @@
+#include "walltimer.h"
+
+#include <QDBusConnection>
+#include <QDebug>
+#include <QSocketNotifier>
+#include <cerrno>
+#include <cstring>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+WallClockTimer::WallClockTimer(QObject *parent)
+: QObject(parent)
+{
+    m_timerFd = timerfd_create(CLOCK_REALTIME, TFD_CLOEXEC | TFD_NONBLOCK);
+    if (m_timerFd < 0) {
+        qWarning() << "[WARN] no timerfd, wallpaper will not advance:" << strerror(errno);
+        return;
+    }
+
+    m_notifier = new QSocketNotifier(m_timerFd, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &WallClockTimer::expired);
+
+    const bool watching = QDBusConnection::systemBus().connect("org.freedesktop.login1", "/org/freedesktop/login1",
+                                                               "org.freedesktop.login1.Manager", "PrepareForSleep",
+                                                               this, SLOT(prepareForSleep(bool)));
+    if (!watching)
+        qWarning() << "[WARN] cannot watch logind for resume; relying on the timer alone";
+}
+
+WallClockTimer::~WallClockTimer() {
+    if (m_timerFd >= 0)
+        close(m_timerFd);
+}
+
+void WallClockTimer::start(qint64 msecsSinceEpoch) {
+    m_deadline = msecsSinceEpoch;
+    arm(msecsSinceEpoch);
+}
+
+void WallClockTimer::stop() {
+    m_deadline = -1;
+    arm(-1);
+}
+
+void WallClockTimer::arm(qint64 msecsSinceEpoch) {
+    if (m_timerFd < 0)
+        return;
+
+    // An all-zero value disarms; a deadline already past fires right away
+    itimerspec spec = {};
+    if (msecsSinceEpoch >= 0) {
+        spec.it_value.tv_sec = msecsSinceEpoch / 1000;
+        spec.it_value.tv_nsec = (msecsSinceEpoch % 1000) * 1000000;
+        if (spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0)
+            spec.it_value.tv_nsec = 1;
+    }
+
+    if (timerfd_settime(m_timerFd, TFD_TIMER_ABSTIME | TFD_TIMER_CANCEL_ON_SET, &spec, nullptr) < 0)
+        qWarning() << "[WARN] cannot arm the wallpaper timer:" << strerror(errno);
+}
+
+void WallClockTimer::expired() {
+    quint64 expirations;
+    if (read(m_timerFd, &expirations, sizeof(expirations)) >= 0) {
+        m_deadline = -1;
+        emit timeout();
+        return;
+    }
+
+    // ECANCELED: the wall clock was set. The deadline stays armed (at its
+    // old absolute time) until the owner asks for a new one.
+    if (errno == ECANCELED) {
+        arm(m_deadline);
+        emit clockChanged();
+    }
+}
+
+void WallClockTimer::prepareForSleep(bool sleeping) {
+    if (!sleeping)
+        emit clockChanged();
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <QObject>
+
+class QSocketNotifier;
+
+// One wakeup at an absolute wall-clock time: the slideshow's next event
+// boundary.
+//
+// A CLOCK_REALTIME timerfd armed with TFD_TIMER_ABSTIME fires at that time
+// however long the machine slept in between, where a QTimer counts
+// monotonic time and would run late by the length of the suspend.
+// TFD_TIMER_CANCEL_ON_SET wakes it as soon as the wall clock is set (NTP
+// step, manual change), and logind's PrepareForSleep(false) says we just
+// resumed. Both emit clockChanged(): the deadline may be stale, and the
+// owner should work out where the timeline is and arm again.
+class WallClockTimer : public QObject {
+    Q_OBJECT
+
+public:
+    explicit WallClockTimer(QObject *parent = nullptr);
+    ~WallClockTimer();
+
+    void start(qint64 msecsSinceEpoch);
+    void stop();
+
+signals:
+    void timeout();
+    void clockChanged();
+
+private slots:
+    void prepareForSleep(bool sleeping);
+
+private:
+    void arm(qint64 msecsSinceEpoch);
+    void expired();
+
+    int m_timerFd = -1;
+    QSocketNotifier *m_notifier = nullptr;
+    qint64 m_deadline = -1;
+};
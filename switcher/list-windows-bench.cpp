@@ -0,0 +1,441 @@
+// list-windows-bench: times the window-list path against toplevel-standin.
+//
+// Usage: list-windows-bench [--sizes 10,100,1000] [--runs N]
+//                           [--list-windows PATH] [--standin PATH]
+//
+// Both binaries default to the ones next to this executable. Everything runs
+// in a private temporary HOME and XDG_RUNTIME_DIR, with an empty PATH for
+// list-windows so no hyprctl gets involved. For each window count it reports:
+//
+//   dump      exec-to-exit time, peak RSS and bytes written by one
+//             `list-windows` dump, plus the final windows.ini size
+//   activate  `list-windows --activate <title>` spawn until the compositor
+//             receives the activate request
+//   ready     `list-windows --watch` spawn until its "ready" line
+//   event     compositor title change until the "changed" line arrives
+//   event+read the same, until windows.ini has also been read back line by
+//             line. This is only the file read: the launcher's model parses
+//             it with QSettings and resets its rows on top, which this
+//             Qt-free bench does not do, so it is a floor for the model's
+//             refresh, not its cost
+//   roundtrip "activate <id>" on --watch stdin until the "activated" line
+//
+// To compare two builds of list-windows, e.g. the Qt one from before it
+// moved to plain libwayland-client against the current one, build the old
+// tree on its own and point --list-windows at it:
+//
+//   cmake -S switcher -B build -DLIST_WINDOWS_BENCH=ON && cmake --build build
+//   git worktree add /tmp/lw-old <old commit>
+//   cmake -S /tmp/lw-old/switcher -B /tmp/lw-old/build && cmake --build /tmp/lw-old/build
+//   build/list-windows-bench --runs 50 --list-windows /tmp/lw-old/build/list-windows
+//   build/list-windows-bench --runs 50
+//
+// The dump lines (exec-to-exit, peak RSS) are the before/after figures.
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <iostream>
+#include <map>
+#include <poll.h>
+#include <sstream>
+#include <string>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+static double now_ms()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+[[noreturn]] static void fail(const std::string& message)
+{
+    std::cerr << "list-windows-bench: " << message << std::endl;
+    exit(1);
+}
+
+// ----------------- Child processes -----------------
+struct Child {
+    pid_t pid = -1;
+    int in = -1; // our end of its stdin
+    int out = -1; // our end of its stdout
+    std::string buffer;
+
+    // Next stdout line, or false after timeoutMs / EOF
+    bool readLine(std::string& line, int timeoutMs = 10000)
+    {
+        const double deadline = now_ms() + timeoutMs;
+        for (;;) {
+            size_t newline = buffer.find('\n');
+            if (newline != std::string::npos) {
+                line = buffer.substr(0, newline);
+                buffer.erase(0, newline + 1);
+                return true;
+            }
+
+            int remaining = int(deadline - now_ms());
+            pollfd pfd = { out, POLLIN, 0 };
+            if (remaining <= 0 || poll(&pfd, 1, remaining) <= 0)
+                return false;
+
+            char buf[65536];
+            ssize_t n = read(out, buf, sizeof(buf));
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                return false;
+            buffer.append(buf, n);
+        }
+    }
+
+    void writeLine(const std::string& line)
+    {
+        std::string data = line + "\n";
+        if (write(in, data.data(), data.size()) != ssize_t(data.size()))
+            fail("short write to child");
+    }
+};
+
+static Child spawn(const std::vector<std::string>& args, const std::vector<std::string>& env, bool pipes)
+{
+    std::vector<char*> argv, envp;
+    for (const std::string& arg : args)
+        argv.push_back(const_cast<char*>(arg.c_str()));
+    argv.push_back(nullptr);
+    for (const std::string& var : env)
+        envp.push_back(const_cast<char*>(var.c_str()));
+    envp.push_back(nullptr);
+
+    int inPipe[2] = { -1, -1 }, outPipe[2] = { -1, -1 };
+    if (pipes && (pipe2(inPipe, O_CLOEXEC) < 0 || pipe2(outPipe, O_CLOEXEC) < 0))
+        fail("pipe failed");
+
+    Child child;
+    child.pid = fork();
+    if (child.pid < 0)
+        fail("fork failed");
+
+    if (child.pid == 0) {
+        if (pipes) {
+            dup2(inPipe[0], STDIN_FILENO);
+            dup2(outPipe[1], STDOUT_FILENO);
+        } else {
+            int null = open("/dev/null", O_RDWR);
+            dup2(null, STDIN_FILENO);
+            dup2(null, STDOUT_FILENO);
+        }
+        execve(argv[0], argv.data(), envp.data());
+        _exit(127);
+    }
+
+    if (pipes) {
+        close(inPipe[0]);
+        close(outPipe[1]);
+        child.in = inPipe[1];
+        child.out = outPipe[0];
+    }
+    return child;
+}
+
+struct ExitStats {
+    double ms = 0;
+    long maxRssKiB = 0;
+    long long bytesWritten = 0;
+};
+
+// Waits for a child; the /proc io counters are read while it is still a zombie
+static ExitStats reap(const Child& child, double startMs)
+{
+    ExitStats stats;
+    siginfo_t info;
+    while (waitid(P_PID, child.pid, &info, WEXITED | WNOWAIT) < 0 && errno == EINTR) { }
+    stats.ms = now_ms() - startMs;
+
+    FILE* io = fopen(("/proc/" + std::to_string(child.pid) + "/io").c_str(), "r");
+    if (io) {
+        char key[64];
+        long long value;
+        while (fscanf(io, "%63[^:]: %lld\n", key, &value) == 2) {
+            if (strcmp(key, "wchar") == 0)
+                stats.bytesWritten = value;
+        }
+        fclose(io);
+    }
+
+    int status;
+    rusage usage;
+    while (wait4(child.pid, &status, 0, &usage) < 0 && errno == EINTR) { }
+    stats.maxRssKiB = usage.ru_maxrss;
+    return stats;
+}
+
+// ----------------- Stand-in compositor -----------------
+struct Standin {
+    Child child;
+    std::deque<std::string> events; // "event ..." lines seen while waiting for replies
+
+    // Sends a script command and returns its "ok ..." reply
+    std::string command(const std::string& line)
+    {
+        child.writeLine(line);
+        return expectOk();
+    }
+
+    std::string expectOk()
+    {
+        std::string reply;
+        while (child.readLine(reply)) {
+            if (reply.rfind("event ", 0) == 0) {
+                events.push_back(reply);
+                continue;
+            }
+            if (reply.rfind("ok", 0) != 0)
+                fail("stand-in: " + reply);
+            return reply;
+        }
+        fail("stand-in stopped answering");
+    }
+
+    std::string nextEvent()
+    {
+        if (!events.empty()) {
+            std::string event = events.front();
+            events.pop_front();
+            return event;
+        }
+        std::string line;
+        while (child.readLine(line)) {
+            if (line.rfind("event ", 0) == 0)
+                return line;
+        }
+        fail("no event from stand-in");
+    }
+};
+
+// ----------------- Reporting -----------------
+struct Samples {
+    std::vector<double> values;
+
+    void add(double value) { values.push_back(value); }
+
+    double percentile(double p)
+    {
+        if (values.empty())
+            return 0;
+        std::sort(values.begin(), values.end());
+        return values[std::min(values.size() - 1, size_t(p * (values.size() - 1) + 0.5))];
+    }
+
+    std::string summary()
+    {
+        char text[128];
+        snprintf(text, sizeof(text), "min=%.3fms median=%.3fms p95=%.3fms max=%.3fms",
+            percentile(0), percentile(0.5), percentile(0.95), percentile(1));
+        return text;
+    }
+};
+
+static off_t file_size(const std::string& path)
+{
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 ? st.st_size : 0;
+}
+
+// Reads windows.ini through once and counts its sections: the file I/O
+// part of the launcher model's reload, without the QSettings parse
+static int read_ini(const std::string& path)
+{
+    FILE* file = fopen(path.c_str(), "r");
+    if (!file)
+        return 0;
+    int sections = 0;
+    char line[4096];
+    while (fgets(line, sizeof(line), file)) {
+        if (line[0] == '[')
+            ++sections;
+    }
+    fclose(file);
+    return sections;
+}
+
+static std::vector<int> parse_sizes(const std::string& text)
+{
+    std::vector<int> sizes;
+    std::stringstream in(text);
+    std::string item;
+    while (std::getline(in, item, ','))
+        sizes.push_back(std::stoi(item));
+    return sizes;
+}
+
+static std::string exe_dir()
+{
+    char path[4096];
+    ssize_t n = readlink("/proc/self/exe", path, sizeof(path) - 1);
+    if (n <= 0)
+        return ".";
+    path[n] = '\0';
+    std::string dir = path;
+    return dir.substr(0, dir.rfind('/'));
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<int> sizes = { 10, 100, 1000 };
+    int runs = 20;
+    std::string listWindows = exe_dir() + "/list-windows";
+    std::string standinPath = exe_dir() + "/toplevel-standin";
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--sizes")
+            sizes = parse_sizes(argv[i + 1]);
+        else if (arg == "--runs")
+            runs = std::max(1, atoi(argv[i + 1]));
+        else if (arg == "--list-windows")
+            listWindows = argv[i + 1];
+        else if (arg == "--standin")
+            standinPath = argv[i + 1];
+        else
+            fail("unknown option " + arg);
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+
+    // Private HOME and runtime dir so the real windows.ini is left alone
+    char tmpl[] = "/tmp/hex-list-windows-bench-XXXXXX";
+    if (!mkdtemp(tmpl))
+        fail("mkdtemp failed");
+    const std::string root = tmpl;
+    const std::string runtime = root + "/run";
+    mkdir(runtime.c_str(), 0700);
+    mkdir((root + "/bin").c_str(), 0755);
+    const std::string iniPath = root + "/.config/hexlauncher/windows.ini";
+
+    Standin standin;
+    standin.child = spawn({ standinPath, "wayland-bench" }, { "XDG_RUNTIME_DIR=" + runtime }, true);
+    std::string line;
+    if (!standin.child.readLine(line) || line.rfind("socket ", 0) != 0)
+        fail("stand-in did not start: " + line);
+
+    const std::vector<std::string> env = {
+        "HOME=" + root,
+        "XDG_RUNTIME_DIR=" + runtime,
+        "WAYLAND_DISPLAY=wayland-bench",
+        "PATH=" + root + "/bin"
+    };
+
+    for (int size : sizes) {
+        standin.command("close-all");
+        std::string created = standin.command("create-many " + std::to_string(size) + " bench.app Window");
+        uint32_t firstId = 0;
+        sscanf(created.c_str(), "ok %u", &firstId);
+
+        // --- dump ---
+        Samples dumpMs;
+        long maxRss = 0;
+        long long written = 0;
+        for (int run = 0; run < runs; ++run) {
+            double start = now_ms();
+            ExitStats stats = reap(spawn({ listWindows }, env, false), start);
+            dumpMs.add(stats.ms);
+            maxRss = std::max(maxRss, stats.maxRssKiB);
+            written = stats.bytesWritten;
+        }
+        std::cout << "dump      windows=" << size << " " << dumpMs.summary() << " maxrss=" << maxRss << "KiB"
+                  << " written=" << written << "B ini=" << file_size(iniPath) << "B" << std::endl;
+
+        // --- activate by spawn, as RunningWindowModel::activate does ---
+        Samples activateMs;
+        for (int run = 0; run < runs; ++run) {
+            std::string title = "Window " + std::to_string(run % size);
+            double start = now_ms();
+            Child child = spawn({ listWindows, "--activate", title }, env, false);
+            standin.nextEvent();
+            activateMs.add(now_ms() - start);
+            reap(child, start);
+        }
+        std::cout << "activate  windows=" << size << " " << activateMs.summary() << std::endl;
+
+        // --- watch mode ---
+        Samples readyMs, eventMs, readMs, roundtripMs;
+        double start = now_ms();
+        Child watch = spawn({ listWindows, "--watch" }, env, true);
+
+        std::map<std::string, std::string> idByTitle; // list-windows' ids
+        while (watch.readLine(line) && line != "ready") {
+            std::vector<std::string> fields;
+            std::stringstream in(line);
+            std::string field;
+            while (std::getline(in, field, '\t'))
+                fields.push_back(field);
+            if (fields.size() == 6 && fields[0] == "added")
+                idByTitle[fields[5]] = fields[1];
+        }
+        if (line != "ready")
+            fail("list-windows --watch never got ready");
+        readyMs.add(now_ms() - start);
+
+        // Needs a window that is not focused yet on every run
+        for (int run = 0; size > 1 && run < runs; ++run) {
+            std::string id = idByTitle["Window " + std::to_string(run % size)];
+            double t0 = now_ms();
+            watch.writeLine("activate " + id);
+            do {
+                if (!watch.readLine(line))
+                    fail("no activated event for window " + id);
+            } while (line.rfind("activated\t" + id + "\t", 0) != 0);
+            roundtripMs.add(now_ms() - t0);
+            standin.nextEvent();
+        }
+
+        for (int run = 0; run < runs; ++run) {
+            uint32_t target = firstId + run % size;
+            std::string title = "Renamed " + std::to_string(run);
+            double t0 = now_ms();
+            standin.child.writeLine("title " + std::to_string(target) + " " + title);
+            do {
+                if (!watch.readLine(line))
+                    fail("no changed event for \"" + title + "\"");
+            } while (line.rfind("changed\t", 0) != 0 || line.size() < title.size()
+                || line.compare(line.size() - title.size(), title.size(), title) != 0);
+            double t1 = now_ms();
+            read_ini(iniPath);
+            double t2 = now_ms();
+            eventMs.add(t1 - t0);
+            readMs.add(t2 - t0);
+            standin.expectOk();
+        }
+
+        close(watch.in);
+        close(watch.out);
+        reap(watch, now_ms());
+
+        std::cout << "ready     windows=" << size << " " << readyMs.summary() << std::endl;
+        std::cout << "event     windows=" << size << " " << eventMs.summary() << std::endl;
+        std::cout << "event+read windows=" << size << " " << readMs.summary() << std::endl;
+        std::cout << "roundtrip windows=" << size << " " << roundtripMs.summary() << std::endl;
+    }
+
+    standin.child.writeLine("quit");
+    reap(standin.child, now_ms());
+
+    unlink(iniPath.c_str());
+    rmdir((root + "/.config/hexlauncher").c_str());
+    rmdir((root + "/.config").c_str());
+    rmdir((root + "/bin").c_str());
+    rmdir(runtime.c_str());
+    rmdir(root.c_str());
+    return 0;
+}
@@ -1,18 +1,40 @@
 #include "wlr-foreign-toplevel-management-unstable-v1-client-protocol.h"
-#include <QDir>
-#include <QSettings>
-#include <QProcess>
-#include <QJsonDocument>
-#include <QJsonArray>
-#include <QJsonObject>
-#include <QThread>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
+#include <fcntl.h>
 #include <iostream>
 #include <map>
+#include <poll.h>
+#include <pwd.h>
+#include <spawn.h>
+#include <string>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
 #include <wayland-client.h>
 
+// No Qt here on purpose: this tool is spawned over and over, so it only
+// links libwayland-client and carries its own small INI writer and JSON
+// reader. See the LIST_WINDOWS_STATIC option for a fully static build.
+
+extern char** environ;
+
 bool running = true;
 bool exit_after_first_dump = true;
+bool watch_mode = false; // --watch: stay connected and stream events on stdout
+// While the first roundtrip delivers the existing windows, windows.ini is
+// written once after it rather than once per window (quadratic at 1000)
+bool initial_sync = true;
 
 extern "C" {
     extern const struct wl_interface zwlr_foreign_toplevel_manager_v1_interface;
@@ -25,54 +47,407 @@ struct zwlr_foreign_toplevel_manager_v1* toplevel_manager = nullptr;
 struct wl_seat* seat = nullptr;
 
 struct WindowInfo {
+    uint32_t id = 0; // stable id used by the --watch protocol
     std::string title;
     std::string app_id;
     bool focused = false;
     bool minimized = false;
     bool maximized = false;
     bool closing = false; // NEW: mark requested-close windows
+    bool announced = false; // --watch: "added" already emitted
+    bool wasFocused = false; // focus as of the previous done event
+    uint64_t lastActivated = 0; // MRU key: activation_serial of the last ACTIVATED transition
     std::string lastPrinted;
 };
 
 std::map<zwlr_foreign_toplevel_handle_v1*, WindowInfo> windows;
 std::string activateTitle;
 std::string closeTitle;
+uint32_t next_window_id = 1;
+uint64_t activation_serial = 0;
+
+// ----------------- Process helpers -----------------
+static const size_t kMaxCapturedOutput = 4 << 20;
+
+static int64_t monotonic_ms()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return int64_t(now.tv_sec) * 1000 + now.tv_nsec / 1000000;
+}
+
+// Runs a program found on PATH with stdin from /dev/null. stderr is dropped
+// when capturing, otherwise inherited along with stdout; at most
+// kMaxCapturedOutput bytes are kept. A child still running after timeoutMs is
+// killed. Returns the exit status, or -1 if it could not be started or timed
+// out.
+static int run_program(const std::vector<std::string>& args, std::string* capturedOutput = nullptr,
+    int timeoutMs = 5000)
+{
+    std::vector<char*> argv;
+    for (const std::string& arg : args)
+        argv.push_back(const_cast<char*>(arg.c_str()));
+    argv.push_back(nullptr);
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+
+    int pipeFds[2] = { -1, -1 };
+    if (capturedOutput) {
+        if (pipe2(pipeFds, O_CLOEXEC) < 0) {
+            posix_spawn_file_actions_destroy(&actions);
+            return -1;
+        }
+        posix_spawn_file_actions_adddup2(&actions, pipeFds[1], STDOUT_FILENO);
+        posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+    }
+
+    pid_t pid;
+    int err = posix_spawnp(&pid, argv[0], &actions, nullptr, argv.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+
+    const int64_t deadline = monotonic_ms() + timeoutMs;
+    bool timedOut = false;
+
+    if (capturedOutput) {
+        close(pipeFds[1]);
+        if (err == 0) {
+            pollfd fd = { pipeFds[0], POLLIN, 0 };
+            char buf[4096];
+            for (;;) {
+                const int64_t remaining = deadline - monotonic_ms();
+                int ready = remaining > 0 ? poll(&fd, 1, int(remaining)) : 0;
+                if (ready < 0 && errno == EINTR)
+                    continue;
+                if (ready <= 0) {
+                    timedOut = ready == 0;
+                    break;
+                }
+
+                ssize_t n = read(pipeFds[0], buf, sizeof(buf));
+                if (n < 0 && errno == EINTR)
+                    continue;
+                if (n <= 0)
+                    break;
+                // Past the cap the pipe is still drained so the child can finish
+                if (capturedOutput->size() < kMaxCapturedOutput)
+                    capturedOutput->append(buf, std::min<size_t>(n, kMaxCapturedOutput - capturedOutput->size()));
+            }
+        }
+        close(pipeFds[0]);
+    }
+
+    if (err != 0)
+        return -1;
+
+#ifdef SYS_pidfd_open
+    // Wait for the exit with the time that is left; older kernels without
+    // pidfd just wait
+    int pidFd = timedOut ? -1 : int(syscall(SYS_pidfd_open, pid, 0));
+    if (pidFd >= 0) {
+        pollfd fd = { pidFd, POLLIN, 0 };
+        int ready;
+        do {
+            const int64_t remaining = deadline - monotonic_ms();
+            ready = remaining > 0 ? poll(&fd, 1, int(remaining)) : 0;
+        } while (ready < 0 && errno == EINTR);
+        timedOut = ready == 0;
+        close(pidFd);
+    }
+#endif
+
+    if (timedOut) {
+        std::cerr << "[WARN] " << args[0] << " timed out, killing it" << std::endl;
+        kill(pid, SIGKILL);
+    }
+
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR) { }
+    if (timedOut)
+        return -1;
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+
+// ----------------- Minimal JSON reading -----------------
+// Just enough for `hyprctl -j clients`: an array of objects whose string
+// members we look up by name. Members that are not strings read as "",
+// matching QJsonValue::toString().
+struct JsonObject {
+    std::map<std::string, std::string> strings;
+
+    std::string value(const std::string& key) const
+    {
+        auto it = strings.find(key);
+        return it != strings.end() ? it->second : std::string();
+    }
+};
+
+class JsonReader {
+public:
+    explicit JsonReader(const std::string& text)
+        : m_text(text)
+    {
+    }
+
+    // False on malformed input or if the top level is not an array
+    bool readArrayOfObjects(std::vector<JsonObject>& out)
+    {
+        skipSpace();
+        if (!consume('['))
+            return false;
+        skipSpace();
+        if (consume(']'))
+            return atEnd();
+
+        do {
+            skipSpace();
+            JsonObject object;
+            if (peek() == '{') {
+                if (!readObject(&object))
+                    return false;
+            } else if (!skipValue()) {
+                return false;
+            }
+            out.push_back(std::move(object));
+            skipSpace();
+        } while (consume(','));
+
+        return consume(']') && atEnd();
+    }
+
+private:
+    const std::string& m_text;
+    size_t m_pos = 0;
+
+    char peek() const { return m_pos < m_text.size() ? m_text[m_pos] : '\0'; }
+
+    bool consume(char c)
+    {
+        if (peek() != c)
+            return false;
+        ++m_pos;
+        return true;
+    }
+
+    bool atEnd()
+    {
+        skipSpace();
+        return m_pos == m_text.size();
+    }
+
+    void skipSpace()
+    {
+        while (m_pos < m_text.size() && strchr(" \t\r\n", m_text[m_pos]))
+            ++m_pos;
+    }
+
+    static void appendUtf8(std::string& out, uint32_t cp)
+    {
+        if (cp < 0x80) {
+            out += char(cp);
+        } else if (cp < 0x800) {
+            out += char(0xC0 | (cp >> 6));
+            out += char(0x80 | (cp & 0x3F));
+        } else if (cp < 0x10000) {
+            out += char(0xE0 | (cp >> 12));
+            out += char(0x80 | ((cp >> 6) & 0x3F));
+            out += char(0x80 | (cp & 0x3F));
+        } else {
+            out += char(0xF0 | (cp >> 18));
+            out += char(0x80 | ((cp >> 12) & 0x3F));
+            out += char(0x80 | ((cp >> 6) & 0x3F));
+            out += char(0x80 | (cp & 0x3F));
+        }
+    }
+
+    bool readHex4(uint32_t& out)
+    {
+        if (m_pos + 4 > m_text.size())
+            return false;
+        out = 0;
+        for (int i = 0; i < 4; ++i) {
+            char c = m_text[m_pos++];
+            out <<= 4;
+            if (c >= '0' && c <= '9')
+                out |= c - '0';
+            else if (c >= 'a' && c <= 'f')
+                out |= c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F')
+                out |= c - 'A' + 10;
+            else
+                return false;
+        }
+        return true;
+    }
+
+    bool readString(std::string* out)
+    {
+        if (!consume('"'))
+            return false;
+
+        while (m_pos < m_text.size()) {
+            char c = m_text[m_pos++];
+            if (c == '"')
+                return true;
+            if (c != '\\') {
+                if (out)
+                    *out += c;
+                continue;
+            }
+
+            if (m_pos >= m_text.size())
+                return false;
+            char escaped = m_text[m_pos++];
+            uint32_t cp = 0;
+            switch (escaped) {
+            case '"': cp = '"'; break;
+            case '\\': cp = '\\'; break;
+            case '/': cp = '/'; break;
+            case 'b': cp = '\b'; break;
+            case 'f': cp = '\f'; break;
+            case 'n': cp = '\n'; break;
+            case 'r': cp = '\r'; break;
+            case 't': cp = '\t'; break;
+            case 'u':
+                if (!readHex4(cp))
+                    return false;
+                // Surrogate pair
+                if (cp >= 0xD800 && cp < 0xDC00 && m_text.compare(m_pos, 2, "\\u") == 0) {
+                    size_t save = m_pos;
+                    uint32_t low = 0;
+                    m_pos += 2;
+                    if (readHex4(low) && low >= 0xDC00 && low < 0xE000)
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                    else
+                        m_pos = save;
+                }
+                if (cp >= 0xD800 && cp < 0xE000)
+                    cp = 0xFFFD;
+                break;
+            default:
+                return false;
+            }
+            if (out)
+                appendUtf8(*out, cp);
+        }
+        return false;
+    }
+
+    bool readObject(JsonObject* out)
+    {
+        if (!consume('{'))
+            return false;
+        skipSpace();
+        if (consume('}'))
+            return true;
+
+        do {
+            skipSpace();
+            std::string key;
+            if (!readString(&key))
+                return false;
+            skipSpace();
+            if (!consume(':'))
+                return false;
+            skipSpace();
+            if (peek() == '"') {
+                std::string value;
+                if (!readString(&value))
+                    return false;
+                if (out)
+                    out->strings[key] = value;
+            } else if (!skipValue()) {
+                return false;
+            }
+            skipSpace();
+        } while (consume(','));
+
+        return consume('}');
+    }
+
+    bool skipValue()
+    {
+        switch (peek()) {
+        case '"':
+            return readString(nullptr);
+        case '{':
+            return readObject(nullptr);
+        case '[': {
+            ++m_pos;
+            skipSpace();
+            if (consume(']'))
+                return true;
+            do {
+                skipSpace();
+                if (!skipValue())
+                    return false;
+                skipSpace();
+            } while (consume(','));
+            return consume(']');
+        }
+        default: {
+            // Number or literal
+            size_t start = m_pos;
+            while (m_pos < m_text.size() && strchr("+-.0123456789eEtruefalsn", m_text[m_pos]))
+                ++m_pos;
+            return m_pos > start;
+        }
+        }
+    }
+};
+
 
 // ----------------- Hyprland helper -----------------
-void switch_to_window_workspace(const std::string &title) {
-    QProcess proc;
-    proc.start("hyprctl", QStringList() << "-j" << "clients");
-    proc.waitForFinished();
-    QByteArray output = proc.readAllStandardOutput();
-
-    auto jsonDoc = QJsonDocument::fromJson(output);
-    if (!jsonDoc.isArray()) return;
-
-    QJsonArray clients = jsonDoc.array();
-    for (const auto &v : clients) {
-        auto obj = v.toObject();
-        QString winTitle = obj["title"].toString();
-        if (winTitle.toStdString() == title) {
-            QString workspace = obj["workspace"].toString();
-            QString address = obj["address"].toString(); // use address, not id
+// Bumped for every --watch activation; a worker whose generation is no longer
+// current stops before its next hyprctl call.
+std::atomic<uint64_t> switch_generation { 0 };
+
+void switch_to_window_workspace(const std::string &title, uint64_t generation = 0) {
+    auto superseded = [generation]() { return generation != 0 && generation != switch_generation; };
+
+    std::string output;
+    run_program({ "hyprctl", "-j", "clients" }, &output);
+    if (superseded()) return;
+
+    std::vector<JsonObject> clients;
+    if (!JsonReader(output).readArrayOfObjects(clients)) return;
+
+    for (const auto &obj : clients) {
+        if (obj.value("title") == title) {
+            std::string workspace = obj.value("workspace");
+            std::string address = obj.value("address"); // use address, not id
 
             // Switch to workspace
-            QProcess::execute("hyprctl", QStringList() << "dispatch" << "workspace" << workspace);
+            run_program({ "hyprctl", "dispatch", "workspace", workspace });
 
-            QThread::msleep(50); // wait a bit
+            usleep(50 * 1000); // wait a bit
+            if (superseded()) return;
 
             // Focus the window by address
-            QProcess::execute("hyprctl", QStringList() << "dispatch" << "focuswindow" << ("address:" + address));
+            run_program({ "hyprctl", "dispatch", "focuswindow", "address:" + address });
 
             break;
         }
     }
 }
 
+// --watch keeps serving Wayland events and commands while hyprctl runs, so
+// the switch happens on a worker thread. A newer activation cancels it.
+void switch_to_window_workspace_async(const std::string &title) {
+    const uint64_t generation = ++switch_generation;
+    std::thread([title, generation]() { switch_to_window_workspace(title, generation); }).detach();
+}
+
 
 // ----------------- Window and INI handling -----------------
 void print_window(zwlr_foreign_toplevel_handle_v1* handle)
 {
+    // stdout carries the event protocol in --watch mode
+    if (watch_mode)
+        return;
+
     auto& win = windows[handle];
     std::string current = "Window: \"" + win.title + "\""
     + " (app_id: " + win.app_id + ")"
@@ -87,11 +462,126 @@ if (current != win.lastPrinted) {
 }
 }
 
+// ----------------- INI writing -----------------
+// Writes exactly what QSettings::IniFormat would for the same data, so the
+// Qt readers on the other side see no difference: sections and keys in
+// string order, a blank line between sections, values escaped and quoted by
+// the same rules (QSettingsPrivate::iniEscapedString).
+using IniSection = std::map<std::string, std::string>; // key -> raw value
+
+static std::string ini_escape(const std::string& value)
+{
+    // QSettings marks its own encodings with a leading '@'; a literal one is doubled
+    const std::string in = (!value.empty() && value[0] == '@') ? "@" + value : value;
+
+    std::string out;
+    out.reserve(in.size() + 8);
+    bool needsQuotes = false;
+    bool escapeNextIfDigit = false;
+
+    for (unsigned char ch : in) {
+        if (ch == ';' || ch == ',' || ch == '=')
+            needsQuotes = true;
+
+        if (escapeNextIfDigit && isxdigit(ch)) {
+            char hex[8];
+            snprintf(hex, sizeof(hex), "\\x%x", ch);
+            out += hex;
+            continue;
+        }
+        escapeNextIfDigit = false;
+
+        switch (ch) {
+        case '\0': out += "\\0"; escapeNextIfDigit = true; break;
+        case '\a': out += "\\a"; break;
+        case '\b': out += "\\b"; break;
+        case '\f': out += "\\f"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        case '\v': out += "\\v"; break;
+        case '"':
+        case '\\':
+            out += '\\';
+            out += char(ch);
+            break;
+        default:
+            if (ch <= 0x1F || ch == 0x7F) {
+                char hex[8];
+                snprintf(hex, sizeof(hex), "\\x%x", ch);
+                out += hex;
+                escapeNextIfDigit = true;
+            } else {
+                out += char(ch); // UTF-8 passes through
+            }
+        }
+    }
+
+    if (needsQuotes || (!out.empty() && (out.front() == ' ' || out.back() == ' ')))
+        out = '"' + out + '"';
+    return out;
+}
+
+static std::string home_dir()
+{
+    const char* home = getenv("HOME");
+    if (home && *home)
+        return home;
+    const passwd* pw = getpwuid(getuid());
+    return pw ? pw->pw_dir : "/";
+}
+
+static void make_dirs(const std::string& path)
+{
+    for (size_t slash = path.find('/', 1); slash != std::string::npos; slash = path.find('/', slash + 1))
+        mkdir(path.substr(0, slash).c_str(), 0755);
+    mkdir(path.c_str(), 0755);
+}
+
+// Replaces the file atomically so readers never see a half-written INI
+static bool write_ini_file(const std::string& path, const std::map<std::string, IniSection>& sections)
+{
+    std::string text;
+    bool first = true;
+    for (const auto& [name, keys] : sections) {
+        if (!first)
+            text += '\n';
+        first = false;
+
+        text += '[' + name + "]\n";
+        for (const auto& [key, value] : keys)
+            text += key + '=' + value + '\n';
+    }
+
+    make_dirs(path.substr(0, path.rfind('/')));
+
+    std::string tmpPath = path + ".XXXXXX";
+    int fd = mkstemp(tmpPath.data());
+    if (fd < 0)
+        return false;
+
+    size_t written = 0;
+    while (written < text.size()) {
+        ssize_t n = write(fd, text.data() + written, text.size() - written);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        written += n;
+    }
+    fchmod(fd, 0644);
+
+    if (close(fd) < 0 || written != text.size() || rename(tmpPath.c_str(), path.c_str()) < 0) {
+        unlink(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
 void write_all_windows_to_ini()
 {
-    QString path = QDir::homePath() + "/.config/hexlauncher/windows.ini";
-    QSettings settings(path, QSettings::IniFormat);
-    settings.clear();
+    std::string path = home_dir() + "/.config/hexlauncher/windows.ini";
+    std::map<std::string, IniSection> sections;
 
     int index = 0;
     for (auto& [handle, win] : windows) {
@@ -99,16 +589,47 @@ void write_all_windows_to_ini()
         if (win.title.empty() || win.app_id.empty())
             continue;
 
-        settings.beginGroup(QString::number(index++));
-        settings.setValue("Title", QString::fromStdString(win.title));
-        settings.setValue("AppID", QString::fromStdString(win.app_id));
-        settings.setValue("Focused", win.focused);
-        settings.setValue("Minimized", win.minimized);
-        settings.setValue("Maximized", win.maximized);
-        settings.endGroup();
+        IniSection& section = sections[std::to_string(index++)];
+        section["Title"] = ini_escape(win.title);
+        section["AppID"] = ini_escape(win.app_id);
+        section["Focused"] = win.focused ? "true" : "false";
+        section["Minimized"] = win.minimized ? "true" : "false";
+        section["Maximized"] = win.maximized ? "true" : "false";
+        section["LastActivated"] = std::to_string(win.lastActivated);
+        // Only meaningful to the --watch stream that wrote this file
+        section["ID"] = std::to_string(win.id);
     }
 
-    settings.sync();
+    if (!write_ini_file(path, sections))
+        std::cerr << "Failed to write " << path << ": " << strerror(errno) << std::endl;
+}
+
+
+// ----------------- --watch event protocol -----------------
+// One line per event on stdout, tab separated:
+//   <event>\t<id>\t<focused>\t<last_activated>\t<app_id>\t<title>
+// where <event> is added, changed, activated or closed, and <last_activated>
+// orders windows by their most recent activation (0 = never seen focused). A single "ready" line
+// follows the initial dump. Lines are written after windows.ini is updated, so
+// readers may reload the INI as soon as they see one.
+// Commands are read from stdin, one per line: "activate <id>" or "close <id>".
+std::string sanitize_field(const std::string& value)
+{
+    std::string out = value;
+    for (char& c : out) {
+        if (c == '\t' || c == '\n' || c == '\r')
+            c = ' ';
+    }
+    return out;
+}
+
+void emit_event(const char* event, const WindowInfo& win)
+{
+    if (!watch_mode)
+        return;
+
+    std::cout << event << '\t' << win.id << '\t' << (win.focused ? 1 : 0) << '\t'
+              << win.lastActivated << '\t' << sanitize_field(win.app_id) << '\t' << sanitize_field(win.title) << std::endl;
 }
 
 
@@ -153,6 +674,10 @@ static void handle_done(void*, zwlr_foreign_toplevel_handle_v1* handle)
 
     auto& win = windows[handle];
 
+    // Most-recently-used order follows ACTIVATED transitions
+    if (win.focused && !win.wasFocused)
+        win.lastActivated = ++activation_serial;
+
     // If activate requested for this title, do workspace switch + activate
     if (!activateTitle.empty() && win.title == activateTitle) {
         // --- Hyprland workspace switch ---
@@ -180,7 +705,18 @@ static void handle_done(void*, zwlr_foreign_toplevel_handle_v1* handle)
 
     // Only write INI for normal updates (skip if this window is marked closing)
     // Note: write_all_windows_to_ini skips closing windows anyway, but avoid extra writes here
-    write_all_windows_to_ini();
+    if (!initial_sync)
+        write_all_windows_to_ini();
+
+    if (!win.announced) {
+        win.announced = true;
+        emit_event("added", win);
+    } else if (win.focused && !win.wasFocused) {
+        emit_event("activated", win);
+    } else {
+        emit_event("changed", win);
+    }
+    win.wasFocused = win.focused;
 
     if (exit_after_first_dump) {
         // If we are doing a close operation, we purposely keep running until closed.
@@ -194,15 +730,19 @@ static void handle_closed(void*, zwlr_foreign_toplevel_handle_v1* handle)
 {
     auto it = windows.find(handle);
     if (it != windows.end()) {
-        std::cout << "Window closed: \"" << it->second.title << "\"" << std::endl;
-
-        running = false;  // Stop regardless of which window closed
+        if (!watch_mode) {
+            std::cout << "Window closed: \"" << it->second.title << "\"" << std::endl;
+            running = false;  // Stop regardless of which window closed
+        }
 
+        WindowInfo closed = it->second;
         windows.erase(it);
         write_all_windows_to_ini();
-    } else {
+        emit_event("closed", closed);
+    } else if (!watch_mode) {
         std::cout << "Window closed: unknown handle" << std::endl;
     }
+    zwlr_foreign_toplevel_handle_v1_destroy(handle);
 }
 
 
@@ -223,7 +763,9 @@ static void manager_handle_toplevel(void*, zwlr_foreign_toplevel_manager_v1*,
                                     zwlr_foreign_toplevel_handle_v1* handle)
 {
     // Add listener and ensure WindowInfo exists
-    windows.emplace(handle, WindowInfo());
+    WindowInfo info;
+    info.id = next_window_id++;
+    windows.emplace(handle, info);
     zwlr_foreign_toplevel_handle_v1_add_listener(handle, &toplevel_handle_listener, nullptr);
 }
 
@@ -252,8 +794,105 @@ static const wl_registry_listener registry_listener = {
     .global_remove = handle_global_remove
 };
 
+// ----------------- --watch command handling -----------------
+zwlr_foreign_toplevel_handle_v1* find_window(uint32_t id)
+{
+    for (auto& [handle, win] : windows) {
+        if (win.id == id)
+            return handle;
+    }
+    return nullptr;
+}
+
+void handle_command(const std::string& line)
+{
+    size_t space = line.find(' ');
+    if (space == std::string::npos)
+        return;
+
+    std::string command = line.substr(0, space);
+    uint32_t id = static_cast<uint32_t>(std::strtoul(line.c_str() + space + 1, nullptr, 10));
+    zwlr_foreign_toplevel_handle_v1* handle = find_window(id);
+    if (!handle)
+        return;
+
+    if (command == "activate") {
+        switch_to_window_workspace_async(windows[handle].title);
+        if (seat)
+            zwlr_foreign_toplevel_handle_v1_activate(handle, seat);
+    } else if (command == "close") {
+        windows[handle].closing = true;
+        zwlr_foreign_toplevel_handle_v1_close(handle);
+    }
+}
+
+// Returns false once stdin is closed, i.e. the reader went away.
+bool read_commands()
+{
+    static std::string pending;
+    char buf[512];
+    ssize_t n = read(STDIN_FILENO, buf, sizeof(buf));
+    if (n <= 0)
+        return n < 0 && errno == EINTR;
+
+    pending.append(buf, n);
+    size_t newline;
+    while ((newline = pending.find('\n')) != std::string::npos) {
+        handle_command(pending.substr(0, newline));
+        pending.erase(0, newline + 1);
+    }
+    return true;
+}
+
+// Event loop for --watch: dispatch Wayland events and stdin commands until
+// either side hangs up.
+int run_watch_loop()
+{
+    pollfd fds[2] = {
+        { wl_display_get_fd(display), POLLIN, 0 },
+        { STDIN_FILENO, POLLIN, 0 }
+    };
+
+    while (running) {
+        while (wl_display_prepare_read(display) != 0)
+            wl_display_dispatch_pending(display);
+        wl_display_flush(display);
+
+        if (poll(fds, 2, -1) < 0) {
+            wl_display_cancel_read(display);
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+
+        if (fds[0].revents & POLLIN) {
+            if (wl_display_read_events(display) < 0)
+                break;
+        } else {
+            wl_display_cancel_read(display);
+        }
+        if (wl_display_dispatch_pending(display) < 0)
+            break;
+        if (fds[0].revents & (POLLERR | POLLHUP))
+            break;
+
+        if (fds[1].revents & (POLLIN | POLLHUP)) {
+            if (!read_commands())
+                break;
+        }
+    }
+
+    wl_display_disconnect(display);
+    return 0;
+}
+
 int main(int argc, char** argv)
 {
+    if (argc == 2 && std::string(argv[1]) == "--watch") {
+        watch_mode = true;
+        exit_after_first_dump = false;
+    }
+
     if (argc == 3) {
         std::string arg1 = argv[1];
         if (arg1 == "--activate") {
@@ -284,14 +923,17 @@ int main(int argc, char** argv)
     zwlr_foreign_toplevel_manager_v1_add_listener(toplevel_manager, &manager_listener, nullptr);
     // ensure we receive initial events
     wl_display_roundtrip(display);
+    initial_sync = false;
+    write_all_windows_to_ini(); // empty if there are no windows
 
-    // if there are no windows, still write an empty INI
-    if (windows.empty()) {
-        write_all_windows_to_ini();
-        if (exit_after_first_dump) {
-            wl_display_disconnect(display);
-            return 0;
-        }
+    if (watch_mode) {
+        std::cout << "ready" << std::endl;
+        return run_watch_loop();
+    }
+
+    if (windows.empty() && exit_after_first_dump) {
+        wl_display_disconnect(display);
+        return 0;
     }
 
     // main event loop - keep running until windows closed (if close requested)
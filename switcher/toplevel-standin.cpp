@@ -0,0 +1,441 @@
+// toplevel-standin: a stand-in compositor for list-windows.
+//
+// Serves zwlr_foreign_toplevel_manager_v1 (and a bare wl_seat) on its own
+// Wayland socket, with no outputs and no surfaces, so list-windows and its
+// readers can be exercised and benchmarked without a real Hyprland/labwc
+// session.
+//
+// Usage: toplevel-standin [socket-name]
+// The socket is created in $XDG_RUNTIME_DIR; its name is printed first as
+// "socket <name>". The window list is then scripted through stdin, one
+// command per line, each answered with an "ok ..." line on stdout:
+//
+//   create <app_id> <title...>              -> ok <id>
+//   create-many <count> <app_id> <prefix>   -> ok <first-id> <last-id>
+//   title <id> <title...>                   -> ok
+//   activate <id>                           -> ok
+//   minimize <id> / maximize <id>           -> ok   (toggle)
+//   close <id>                              -> ok
+//   close-all                               -> ok
+//   sync                                    -> ok   (after flushing clients)
+//   quit
+//
+// Requests coming from clients are reported as they arrive:
+//
+//   event activate <id>
+//   event close <id>
+//
+// and then applied as if scripted, so round trips can be timed end to end.
+
+#include "wlr-foreign-toplevel-management-unstable-v1-server-protocol.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include <wayland-server.h>
+
+static constexpr uint32_t kManagerVersion = 3;
+
+struct Toplevel {
+    uint32_t id = 0;
+    std::string appId;
+    std::string title;
+    bool activated = false;
+    bool minimized = false;
+    bool maximized = false;
+    std::vector<wl_resource*> handles; // one per bound manager
+};
+
+static wl_display* display = nullptr;
+static std::map<uint32_t, Toplevel> toplevels;
+static std::vector<wl_resource*> managers;
+static uint32_t next_id = 1;
+
+static void reply(const std::string& line)
+{
+    std::cout << line << std::endl;
+}
+
+// ----------------- Sending state -----------------
+static void send_state(const Toplevel& toplevel, wl_resource* handle)
+{
+    wl_array states;
+    wl_array_init(&states);
+    auto add = [&states](uint32_t state) {
+        *static_cast<uint32_t*>(wl_array_add(&states, sizeof(uint32_t))) = state;
+    };
+    if (toplevel.activated)
+        add(ZWLR_FOREIGN_TOPLEVEL_HANDLE_V1_STATE_ACTIVATED);
+    if (toplevel.minimized)
+        add(ZWLR_FOREIGN_TOPLEVEL_HANDLE_V1_STATE_MINIMIZED);
+    if (toplevel.maximized)
+        add(ZWLR_FOREIGN_TOPLEVEL_HANDLE_V1_STATE_MAXIMIZED);
+
+    zwlr_foreign_toplevel_handle_v1_send_state(handle, &states);
+    wl_array_release(&states);
+}
+
+static void send_all(const Toplevel& toplevel, wl_resource* handle)
+{
+    zwlr_foreign_toplevel_handle_v1_send_title(handle, toplevel.title.c_str());
+    zwlr_foreign_toplevel_handle_v1_send_app_id(handle, toplevel.appId.c_str());
+    send_state(toplevel, handle);
+    zwlr_foreign_toplevel_handle_v1_send_done(handle);
+}
+
+static void activate_toplevel(uint32_t id);
+static void close_toplevel(uint32_t id);
+
+// ----------------- zwlr_foreign_toplevel_handle_v1 -----------------
+static uint32_t handle_toplevel_id(wl_resource* resource)
+{
+    // Zero once the toplevel is gone but the client still holds the handle
+    return static_cast<uint32_t>(reinterpret_cast<uintptr_t>(wl_resource_get_user_data(resource)));
+}
+
+static void set_flag(wl_resource* resource, bool Toplevel::*flag, bool value)
+{
+    auto it = toplevels.find(handle_toplevel_id(resource));
+    if (it == toplevels.end() || it->second.*flag == value)
+        return;
+
+    it->second.*flag = value;
+    for (wl_resource* handle : it->second.handles) {
+        send_state(it->second, handle);
+        zwlr_foreign_toplevel_handle_v1_send_done(handle);
+    }
+}
+
+static void request_set_maximized(wl_client*, wl_resource* resource) { set_flag(resource, &Toplevel::maximized, true); }
+static void request_unset_maximized(wl_client*, wl_resource* resource) { set_flag(resource, &Toplevel::maximized, false); }
+static void request_set_minimized(wl_client*, wl_resource* resource) { set_flag(resource, &Toplevel::minimized, true); }
+static void request_unset_minimized(wl_client*, wl_resource* resource) { set_flag(resource, &Toplevel::minimized, false); }
+
+static void request_activate(wl_client*, wl_resource* resource, wl_resource*)
+{
+    uint32_t id = handle_toplevel_id(resource);
+    if (!toplevels.count(id))
+        return;
+    reply("event activate " + std::to_string(id));
+    activate_toplevel(id);
+}
+
+static void request_close(wl_client*, wl_resource* resource)
+{
+    uint32_t id = handle_toplevel_id(resource);
+    if (!toplevels.count(id))
+        return;
+    reply("event close " + std::to_string(id));
+    close_toplevel(id);
+}
+
+static void request_set_rectangle(wl_client*, wl_resource*, wl_resource*, int32_t, int32_t, int32_t, int32_t) { }
+static void request_set_fullscreen(wl_client*, wl_resource*, wl_resource*) { }
+static void request_unset_fullscreen(wl_client*, wl_resource*) { }
+
+static void request_destroy(wl_client*, wl_resource* resource)
+{
+    wl_resource_destroy(resource);
+}
+
+static const struct zwlr_foreign_toplevel_handle_v1_interface handle_impl = {
+    .set_maximized = request_set_maximized,
+    .unset_maximized = request_unset_maximized,
+    .set_minimized = request_set_minimized,
+    .unset_minimized = request_unset_minimized,
+    .activate = request_activate,
+    .close = request_close,
+    .set_rectangle = request_set_rectangle,
+    .destroy = request_destroy,
+    .set_fullscreen = request_set_fullscreen,
+    .unset_fullscreen = request_unset_fullscreen
+};
+
+static void handle_resource_destroyed(wl_resource* resource)
+{
+    auto it = toplevels.find(handle_toplevel_id(resource));
+    if (it == toplevels.end())
+        return;
+
+    auto& handles = it->second.handles;
+    handles.erase(std::remove(handles.begin(), handles.end(), resource), handles.end());
+}
+
+static void announce(Toplevel& toplevel, wl_resource* manager)
+{
+    wl_client* client = wl_resource_get_client(manager);
+    wl_resource* handle = wl_resource_create(client, &zwlr_foreign_toplevel_handle_v1_interface,
+        wl_resource_get_version(manager), 0);
+    if (!handle) {
+        wl_client_post_no_memory(client);
+        return;
+    }
+
+    wl_resource_set_implementation(handle, &handle_impl,
+        reinterpret_cast<void*>(uintptr_t(toplevel.id)), handle_resource_destroyed);
+    toplevel.handles.push_back(handle);
+
+    zwlr_foreign_toplevel_manager_v1_send_toplevel(manager, handle);
+    send_all(toplevel, handle);
+}
+
+// ----------------- zwlr_foreign_toplevel_manager_v1 -----------------
+static void manager_stop(wl_client*, wl_resource* resource)
+{
+    zwlr_foreign_toplevel_manager_v1_send_finished(resource);
+    wl_resource_destroy(resource);
+}
+
+static const struct zwlr_foreign_toplevel_manager_v1_interface manager_impl = {
+    .stop = manager_stop
+};
+
+static void manager_resource_destroyed(wl_resource* resource)
+{
+    managers.erase(std::remove(managers.begin(), managers.end(), resource), managers.end());
+}
+
+static void bind_manager(wl_client* client, void*, uint32_t version, uint32_t id)
+{
+    wl_resource* manager = wl_resource_create(client, &zwlr_foreign_toplevel_manager_v1_interface, version, id);
+    if (!manager) {
+        wl_client_post_no_memory(client);
+        return;
+    }
+
+    wl_resource_set_implementation(manager, &manager_impl, nullptr, manager_resource_destroyed);
+    managers.push_back(manager);
+
+    for (auto& [toplevelId, toplevel] : toplevels)
+        announce(toplevel, manager);
+}
+
+// ----------------- wl_seat -----------------
+// Only here so clients have something to pass to activate()
+static void seat_get_device(wl_client*, wl_resource* resource, uint32_t)
+{
+    wl_resource_post_error(resource, 0, "toplevel-standin has no input devices");
+}
+
+static void seat_release(wl_client*, wl_resource* resource)
+{
+    wl_resource_destroy(resource);
+}
+
+static const struct wl_seat_interface seat_impl = {
+    .get_pointer = seat_get_device,
+    .get_keyboard = seat_get_device,
+    .get_touch = seat_get_device,
+    .release = seat_release
+};
+
+static void bind_seat(wl_client* client, void*, uint32_t version, uint32_t id)
+{
+    wl_resource* seat = wl_resource_create(client, &wl_seat_interface, version, id);
+    if (!seat) {
+        wl_client_post_no_memory(client);
+        return;
+    }
+
+    wl_resource_set_implementation(seat, &seat_impl, nullptr, nullptr);
+    wl_seat_send_capabilities(seat, 0);
+}
+
+// ----------------- Window list operations -----------------
+static uint32_t create_toplevel(const std::string& appId, const std::string& title)
+{
+    Toplevel& toplevel = toplevels[next_id];
+    toplevel.id = next_id++;
+    toplevel.appId = appId;
+    toplevel.title = title;
+
+    for (wl_resource* manager : managers)
+        announce(toplevel, manager);
+    return toplevel.id;
+}
+
+static void activate_toplevel(uint32_t id)
+{
+    for (auto& [otherId, toplevel] : toplevels) {
+        bool activated = otherId == id;
+        if (toplevel.activated == activated)
+            continue;
+
+        toplevel.activated = activated;
+        if (activated)
+            toplevel.minimized = false;
+        for (wl_resource* handle : toplevel.handles) {
+            send_state(toplevel, handle);
+            zwlr_foreign_toplevel_handle_v1_send_done(handle);
+        }
+    }
+}
+
+static void close_toplevel(uint32_t id)
+{
+    auto it = toplevels.find(id);
+    if (it == toplevels.end())
+        return;
+
+    // Clients may keep their handles until they destroy them; detach them
+    for (wl_resource* handle : it->second.handles) {
+        wl_resource_set_user_data(handle, nullptr);
+        zwlr_foreign_toplevel_handle_v1_send_closed(handle);
+    }
+    toplevels.erase(it);
+}
+
+static void set_title(uint32_t id, const std::string& title)
+{
+    auto it = toplevels.find(id);
+    if (it == toplevels.end())
+        return;
+
+    it->second.title = title;
+    for (wl_resource* handle : it->second.handles) {
+        zwlr_foreign_toplevel_handle_v1_send_title(handle, title.c_str());
+        zwlr_foreign_toplevel_handle_v1_send_done(handle);
+    }
+}
+
+static void toggle_flag(uint32_t id, bool Toplevel::*flag)
+{
+    auto it = toplevels.find(id);
+    if (it == toplevels.end())
+        return;
+
+    it->second.*flag = !(it->second.*flag);
+    for (wl_resource* handle : it->second.handles) {
+        send_state(it->second, handle);
+        zwlr_foreign_toplevel_handle_v1_send_done(handle);
+    }
+}
+
+// ----------------- Script input -----------------
+static std::string rest_of(std::istringstream& in)
+{
+    std::string rest;
+    std::getline(in, rest);
+    if (!rest.empty() && rest[0] == ' ')
+        rest.erase(0, 1);
+    return rest;
+}
+
+static void run_command(const std::string& line)
+{
+    std::istringstream in(line);
+    std::string command;
+    in >> command;
+
+    if (command == "create") {
+        std::string appId;
+        in >> appId;
+        reply("ok " + std::to_string(create_toplevel(appId, rest_of(in))));
+    } else if (command == "create-many") {
+        unsigned count = 0;
+        std::string appId, prefix;
+        in >> count >> appId >> prefix;
+        uint32_t first = next_id;
+        for (unsigned i = 0; i < count; ++i)
+            create_toplevel(appId, prefix + " " + std::to_string(i));
+        reply("ok " + std::to_string(first) + " " + std::to_string(next_id - 1));
+    } else if (command == "title") {
+        uint32_t id = 0;
+        in >> id;
+        set_title(id, rest_of(in));
+        reply("ok");
+    } else if (command == "activate") {
+        uint32_t id = 0;
+        in >> id;
+        activate_toplevel(id);
+        reply("ok");
+    } else if (command == "minimize" || command == "maximize") {
+        uint32_t id = 0;
+        in >> id;
+        toggle_flag(id, command == "minimize" ? &Toplevel::minimized : &Toplevel::maximized);
+        reply("ok");
+    } else if (command == "close") {
+        uint32_t id = 0;
+        in >> id;
+        close_toplevel(id);
+        reply("ok");
+    } else if (command == "close-all") {
+        while (!toplevels.empty())
+            close_toplevel(toplevels.begin()->first);
+        reply("ok");
+    } else if (command == "sync") {
+        wl_display_flush_clients(display);
+        reply("ok");
+    } else if (command == "quit") {
+        wl_display_terminate(display);
+    } else if (!command.empty()) {
+        reply("error unknown command " + command);
+    }
+}
+
+static int handle_stdin(int fd, uint32_t mask, void*)
+{
+    static std::string pending;
+
+    char buf[4096];
+    ssize_t n = (mask & WL_EVENT_READABLE) ? read(fd, buf, sizeof(buf)) : 0;
+    if (n <= 0) {
+        // Script ended: nothing left to drive us
+        wl_display_terminate(display);
+        return 0;
+    }
+
+    pending.append(buf, n);
+    size_t newline;
+    while ((newline = pending.find('\n')) != std::string::npos) {
+        run_command(pending.substr(0, newline));
+        pending.erase(0, newline + 1);
+    }
+
+    // Script replies and client events should leave together
+    wl_display_flush_clients(display);
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    display = wl_display_create();
+    if (!display) {
+        std::cerr << "Failed to create Wayland display." << std::endl;
+        return 1;
+    }
+
+    const char* socket = nullptr;
+    if (argc > 1) {
+        if (wl_display_add_socket(display, argv[1]) != 0) {
+            std::cerr << "Failed to create socket " << argv[1] << std::endl;
+            return 1;
+        }
+        socket = argv[1];
+    } else {
+        socket = wl_display_add_socket_auto(display);
+        if (!socket) {
+            std::cerr << "Failed to create a Wayland socket." << std::endl;
+            return 1;
+        }
+    }
+
+    wl_global_create(display, &zwlr_foreign_toplevel_manager_v1_interface, kManagerVersion, nullptr, bind_manager);
+    wl_global_create(display, &wl_seat_interface, 1, nullptr, bind_seat);
+
+    wl_event_loop* loop = wl_display_get_event_loop(display);
+    wl_event_loop_add_fd(loop, STDIN_FILENO, WL_EVENT_READABLE, handle_stdin, nullptr);
+
+    reply(std::string("socket ") + socket);
+    wl_display_run(display);
+
+    wl_display_destroy_clients(display);
+    wl_display_destroy(display);
+    return 0;
+}